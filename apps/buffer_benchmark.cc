@@ -0,0 +1,285 @@
+#include "buffer.hh"
+#include "fd_adapter.hh"
+#include "file_descriptor.hh"
+#include "parser.hh"
+#include "socket.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Packets received or serialized by each variant
+constexpr size_t total_packets = 1 << 18;
+
+//! Datagrams sent, and read, at a time
+constexpr size_t batch_size = TCPOverUDPSocketAdapter::BATCH_SIZE;
+
+//! Bytes of payload in each TCP segment
+constexpr size_t payload_size = 1000;
+
+//! Calls to operator new while `counting` is set
+static size_t allocations = 0;
+static bool counting = false;
+
+void *operator new(const size_t size) {
+    allocations += counting;
+    if (void *ptr = malloc(size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, const size_t) noexcept { free(ptr); }
+
+static void report(const string &name, const nanoseconds duration, const size_t allocation_count) {
+    cout << fixed << setprecision(2);
+    cout << "  " << setw(44) << left << name << right << setw(8) << double(duration.count()) / total_packets
+         << " ns/packet " << setw(8) << double(allocation_count) / total_packets << " allocations/packet\n";
+}
+
+//! Time `receive`, and count its allocations, as it reads batches of UDP datagrams sent to `receiver`
+//! (which must be bound), each carrying a TCP segment; `receive` returns the number it read
+static void receive_benchmark(const string &name, UDPSocket &receiver, const function<size_t()> &receive) {
+    UDPSocket sender;
+    sender.bind({"127.0.0.1", 0});
+
+    // with SYN set, so that a listening adapter accepts them all
+    TCPSegment seg;
+    seg.header().syn = true;
+    seg.header().sport = sender.local_address().port();
+    seg.header().dport = receiver.local_address().port();
+    seg.payload() = string(payload_size, 'x');
+    const string datagram = seg.serialize().concatenate();
+    const vector<BufferViewList> batch(batch_size, BufferViewList(datagram));
+    const Address destination = receiver.local_address();
+
+    // the first rounds are a warm-up, in which pools and scratch space fill
+    nanoseconds duration{0};
+    allocations = 0;
+    for (size_t round = 0; round < total_packets / batch_size + 16; round++) {
+        sender.send_batch(destination, batch);
+        const bool measured = round >= 16;
+
+        const auto start = steady_clock::now();
+        counting = measured;
+        for (size_t received = 0; received < batch_size;) {
+            received += receive();
+        }
+        counting = false;
+        if (measured) {
+            duration += steady_clock::now() - start;
+        }
+    }
+    report(name, duration, allocations);
+}
+
+//! Time `operation`, and count its allocations, over total_packets calls
+static void operation_benchmark(const string &name, const function<size_t()> &operation) {
+    size_t total = 0;
+    allocations = 0;
+    counting = true;
+    const auto start = steady_clock::now();
+    for (size_t i = 0; i < total_packets; i++) {
+        total += operation();
+    }
+    const auto duration = steady_clock::now() - start;
+    counting = false;
+
+    if (total != total_packets) {
+        throw runtime_error(name + ": wrong result");
+    }
+    report(name, duration, allocations);
+}
+
+//! Time `serialize`, and count its allocations, on a TCP segment's header
+static void serialize_benchmark(const string &name, const function<size_t(const TCPSegment &)> &serialize) {
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.payload() = string(payload_size, 'x');
+
+    size_t total = 0;
+    allocations = 0;
+    counting = true;
+    const auto start = steady_clock::now();
+    for (size_t i = 0; i < total_packets; i++) {
+        total += serialize(seg);
+    }
+    const auto duration = steady_clock::now() - start;
+    counting = false;
+
+    if (total != total_packets * TCPHeader::LENGTH) {
+        throw runtime_error(name + ": wrong header length");
+    }
+    report(name, duration, allocations);
+}
+
+int main() {
+    try {
+        cout << "Receiving " << total_packets << " TCP segments over UDP, in batches of " << batch_size << ":\n";
+
+        UDPSocket sock;
+        sock.bind({"127.0.0.1", 0});
+
+        receive_benchmark("recv(), payload moved into a Buffer", sock, [&]() -> size_t {
+            auto datagram = sock.recv();
+            const Buffer payload{move(datagram.payload)};
+            return payload.size() == TCPHeader::LENGTH + payload_size;
+        });
+
+        UDPSocket::RecvBatch recv_batch{batch_size};
+        receive_benchmark("recv_batch(), payloads copied into Buffers", sock, [&]() -> size_t {
+            sock.recv_batch(recv_batch);
+            size_t received = 0;
+            for (size_t i = 0; i < recv_batch.size(); i++) {
+                const Buffer payload{string(recv_batch.payload(i).str())};
+                received += payload.size() == TCPHeader::LENGTH + payload_size;
+            }
+            return received;
+        });
+
+        receive_benchmark("recv_batch(), payloads in pooled slabs", sock, [&]() -> size_t {
+            sock.recv_batch(recv_batch);
+            size_t received = 0;
+            for (size_t i = 0; i < recv_batch.size(); i++) {
+                const Buffer payload = recv_batch.payload(i);
+                received += payload.size() == TCPHeader::LENGTH + payload_size;
+            }
+            return received;
+        });
+
+        TCPOverUDPSocketAdapter adapter{move(sock)};
+        adapter.set_listening(true);
+        vector<TCPSegment> segments{};
+        receive_benchmark("TCPOverUDPSocketAdapter::read_batch()", adapter, [&]() -> size_t {
+            segments.clear();
+            adapter.read_batch(segments);
+            return segments.size();
+        });
+
+        cout << "Reading " << total_packets << " packets from a datagram socket pair:\n";
+
+        int fds[2];
+        SystemCall("socketpair", socketpair(AF_UNIX, SOCK_DGRAM, 0, static_cast<int *>(fds)));
+        FileDescriptor packet_sender{fds[0]}, packet_receiver{fds[1]};
+        const string frame(payload_size + TCPOverIPv4Adapter::HEADERS_LENGTH + EthernetHeader::LENGTH, 'x');
+        size_t packets_read = 0;
+        const auto read_benchmark = [&](const string &name, const function<size_t()> &read_packet) {
+            operation_benchmark(name, [&]() -> size_t {
+                if (packets_read++ % batch_size == 0) {
+                    counting = false;
+                    for (size_t i = 0; i < batch_size; i++) {
+                        packet_sender.write(frame);
+                    }
+                    counting = true;
+                }
+                return read_packet() == frame.size();
+            });
+        };
+
+        read_benchmark("read() into a std::string, in a Buffer", [&]() -> size_t {
+            const Buffer packet{packet_receiver.read()};
+            return packet.size();
+        });
+
+        BufferPool packet_pool{TCPOverIPv4Adapter::PACKET_SLAB_SIZE};
+        BufferPool large_packet_pool{TCPOverIPv4Adapter::LARGE_PACKET_SLAB_SIZE, 4};
+        read_benchmark("read_into() pooled slabs", [&]() -> size_t {
+            const Buffer packet = packet_receiver.read_into(packet_pool, large_packet_pool);
+            return packet.size();
+        });
+
+        cout << "Serializing " << total_packets << " TCP headers:\n";
+
+        serialize_benchmark("into a std::string, in a Buffer", [](const TCPSegment &seg) -> size_t {
+            const Buffer header{seg.header().serialize()};
+            return header.size();
+        });
+
+        serialize_benchmark("into a Headroom, copied to a pooled Buffer", [](const TCPSegment &seg) -> size_t {
+            Headroom headroom;
+            seg.header().serialize(headroom);
+            const Buffer header = headroom.to_buffer();
+            return header.size();
+        });
+
+        cout << "Copying and appending Buffers " << total_packets << " times:\n";
+
+        TCPSegment seg;
+        seg.payload() = string(payload_size, 'x');
+        const Buffer header{seg.header().serialize()};
+        const string payload_string(payload_size, 'x');
+
+        operation_benchmark("copy a TCPSegment", [&]() -> size_t {
+            const TCPSegment seg_copy{seg};
+            return seg_copy.payload().size() == payload_size;
+        });
+
+        operation_benchmark("make a BufferList of header and payload", [&]() -> size_t {
+            BufferList packet{header};
+            packet.append(seg.payload());
+            return packet.size() == TCPHeader::LENGTH + payload_size;
+        });
+
+        operation_benchmark("make a Buffer from a std::string", [&]() -> size_t {
+            const Buffer buffer{string(payload_string)};
+            return buffer.size() == payload_size;
+        });
+
+        operation_benchmark("make a Buffer with Buffer::copy_of()", [&]() -> size_t {
+            const Buffer buffer = Buffer::copy_of(payload_string);
+            return buffer.size() == payload_size;
+        });
+
+        // once a program has started a thread, references are counted atomically
+        thread([] {}).join();
+        operation_benchmark("copy a TCPSegment (with a second thread)", [&]() -> size_t {
+            const TCPSegment seg_copy{seg};
+            return seg_copy.payload().size() == payload_size;
+        });
+
+        cout << "Writing " << total_packets << " packets of header and payload:\n";
+
+        FileDescriptor devnull{SystemCall("open /dev/null", open("/dev/null", O_WRONLY))};
+        operation_benchmark("FileDescriptor::write() (writev)", [&]() -> size_t {
+            BufferList packet{header};
+            packet.append(seg.payload());
+            return devnull.write(packet) == TCPHeader::LENGTH + payload_size;
+        });
+
+        UDPSocket sink;
+        sink.bind({"127.0.0.1", 0});
+        const Address sink_address = sink.local_address();
+        UDPSocket sender;
+        BufferList packet{header};
+        packet.append(seg.payload());
+        const vector<BufferViewList> batch(batch_size, BufferViewList(packet));
+        size_t sent = 0;
+        operation_benchmark("UDPSocket::send_batch() (sendmmsg)", [&]() -> size_t {
+            if (sent++ % batch_size == 0) {
+                sender.send_batch(sink_address, batch);
+            }
+            return 1;
+        });
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Total number of bytes to checksum for each (kernel, input size) pair
+constexpr size_t total_bytes = 1024 * 1024 * 1024;
+
+using Kernel = InternetChecksum::Kernel;
+
+static const vector<pair<Kernel, string>> kernels = {
+    {Kernel::Bytewise, "bytewise"}, {Kernel::Word64, "word64"}, {Kernel::SSE2, "sse2"}, {Kernel::AVX2, "avx2"}};
+
+//! Check that every kernel agrees with the bytewise one, including when the input is split at odd offsets
+static void check_kernels(const string &data) {
+    InternetChecksum reference{0x1234, Kernel::Bytewise};
+    reference.add(data);
+
+    for (const auto &[kernel, name] : kernels) {
+        if (not InternetChecksum::supported(kernel)) {
+            continue;
+        }
+        for (const size_t split : {size_t{0}, size_t{1}, size_t{7}, data.size() / 2 + 1}) {
+            InternetChecksum check{0x1234, kernel};
+            check.add(string_view(data).substr(0, split));
+            check.add(string_view(data).substr(split, 3));
+            check.add(string_view(data).substr(min(data.size(), split + 3)));
+            if (check.value() != reference.value()) {
+                throw runtime_error(name + " kernel disagrees with bytewise checksum (size " +
+                                    to_string(data.size()) + ", split " + to_string(split) + ")");
+            }
+        }
+    }
+}
+
+static void checksum_loop(const Kernel kernel, const string &name, const string &data) {
+    const size_t iterations = total_bytes / data.size();
+    uint16_t result = 0;
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t i = 0; i < iterations; i++) {
+        InternetChecksum check{result, kernel};
+        check.add(data);
+        result = check.value();
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    const auto gigabits_per_second = iterations * data.size() * 8.0 / double(duration);
+    const auto ns_per_call = double(duration) / iterations;
+
+    cout << fixed << setprecision(2);
+    cout << "  " << setw(8) << left << name << right << setw(10) << gigabits_per_second << " Gbit/s" << setw(12)
+         << ns_per_call << " ns/call   (result " << hex << result << dec << ")\n";
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        for (const size_t size : {size_t{64}, size_t{1500}, size_t{65536}}) {
+            string data(size, 0);
+            for (auto &ch : data) {
+                ch = rd();
+            }
+            check_kernels(data);
+
+            cout << "InternetChecksum over " << size << "-byte inputs:\n";
+            for (const auto &[kernel, name] : kernels) {
+                if (InternetChecksum::supported(kernel)) {
+                    checksum_loop(kernel, name, data);
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
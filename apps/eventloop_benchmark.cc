@@ -0,0 +1,113 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Number of wakeups to time for each (backend, rule count) pair
+constexpr size_t total_wakeups = 20000;
+
+//! File descriptors to keep free for the benchmark itself
+constexpr size_t spare_fds = 64;
+
+using Backend = EventLoop::Backend;
+
+static const vector<pair<Backend, string>> backends = {{Backend::Poll, "poll"}, {Backend::Epoll, "epoll"}};
+
+//! Raise the soft limit on open files as far as the hard limit allows
+//! \returns the number of idle rules that fit within the limit
+static size_t raise_fd_limit() {
+    rlimit limit{};
+    SystemCall("getrlimit", getrlimit(RLIMIT_NOFILE, &limit));
+    limit.rlim_cur = limit.rlim_max;
+    SystemCall("setrlimit", setrlimit(RLIMIT_NOFILE, &limit));
+    return limit.rlim_cur > spare_fds ? limit.rlim_cur - spare_fds : 0;
+}
+
+static FileDescriptor make_eventfd() { return FileDescriptor(SystemCall("eventfd", eventfd(0, EFD_NONBLOCK))); }
+
+//! Time wakeups of an EventLoop with `idle_count` rules that never fire, and one that fires on every call
+static void wakeup_loop(const Backend backend, const string &name, const size_t idle_count) {
+    EventLoop loop{backend};
+
+    vector<FileDescriptor> idle{};
+    idle.reserve(idle_count);
+    for (size_t i = 0; i < idle_count; i++) {
+        idle.push_back(make_eventfd());
+        loop.add_rule(idle.back(), Direction::In, [] { throw runtime_error("idle eventfd became readable"); });
+    }
+
+    FileDescriptor active = make_eventfd();
+    const string signal = [] {
+        string s(sizeof(uint64_t), 0);
+        s.front() = 1;
+        return s;
+    }();
+    size_t wakeups = 0;
+    loop.add_rule(active, Direction::In, [&] {
+        active.read(sizeof(uint64_t));
+        wakeups++;
+    });
+
+    // one call to set up the registrations, which isn't timed
+    active.write(signal);
+    loop.wait_next_event(-1);
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t i = 0; i < total_wakeups; i++) {
+        active.write(signal);
+        if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+            throw runtime_error("EventLoop stopped early");
+        }
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (wakeups != total_wakeups + 1) {
+        throw runtime_error("expected " + to_string(total_wakeups + 1) + " wakeups, got " + to_string(wakeups));
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const auto us_per_wakeup = double(duration) / total_wakeups / 1000.0;
+
+    cout << fixed << setprecision(2);
+    cout << "  " << setw(6) << left << name << right << setw(8) << idle_count << " idle rules" << setw(12)
+         << us_per_wakeup << " us/wakeup\n";
+}
+
+int main() {
+    try {
+        const size_t max_idle = raise_fd_limit();
+
+        for (const size_t requested : {size_t{10}, size_t{100}, size_t{1000}, size_t{10000}, size_t{100000}}) {
+            const size_t idle_count = min(requested, max_idle);
+            cout << "EventLoop wakeup latency with " << requested << " rules";
+            if (idle_count != requested) {
+                cout << " (capped to " << idle_count << " by RLIMIT_NOFILE)";
+            }
+            cout << ":\n";
+
+            for (const auto &[backend, name] : backends) {
+                wakeup_loop(backend, name, idle_count);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -89,7 +89,7 @@ class NetworkInterfaceAdapter : public TCPOverIPv4Adapter {
 
     optional<TCPSegment> read() {
         EthernetFrame frame;
-        if (frame.parse(_data_socket_pair.first.read()) != ParseResult::NoError) {
+        if (frame.parse(_read_packet(_data_socket_pair.first)) != ParseResult::NoError) {
             return {};
         }
 
@@ -110,6 +110,18 @@ class NetworkInterfaceAdapter : public TCPOverIPv4Adapter {
         _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
         send_pending();
     }
+    void read_batch(vector<TCPSegment> &segments) {
+        auto seg = read();
+        if (seg) {
+            segments.push_back(move(seg.value()));
+        }
+    }
+    void write_batch(queue<TCPSegment> &segments) {
+        while (not segments.empty()) {
+            write(segments.front());
+            segments.pop();
+        }
+    }
     void tick(const size_t ms_since_last_tick) {
         _interface.tick(ms_since_last_tick);
         send_pending();
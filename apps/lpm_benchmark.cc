@@ -0,0 +1,87 @@
+#include "lpm_table.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static const vector<pair<LPMAlgorithm, string>> algorithms = {
+    {LPMAlgorithm::Linear, "linear"}, {LPMAlgorithm::Trie, "trie"}, {LPMAlgorithm::Dir24_8, "DIR-24-8"}};
+
+//! A random prefix, with lengths spread roughly as in a full Internet routing table (mostly /24)
+static pair<uint32_t, uint8_t> random_prefix(mt19937 &rd) {
+    // weights for lengths 8 to 32, in parts per 100000
+    static discrete_distribution<unsigned> length_distribution{
+        1, 1, 1, 2, 10, 20, 40, 50, 1300, 350, 600, 1200, 2300, 2500, 7000, 7000, 56000, 10, 10, 10, 10, 10, 10, 10, 10};
+    return {uint32_t(rd()), static_cast<uint8_t>(8 + length_distribution(rd))};
+}
+
+static void benchmark(const size_t prefix_count) {
+    auto rd = get_random_generator();
+    vector<pair<uint32_t, uint8_t>> prefixes(prefix_count);
+    for (auto &prefix : prefixes) {
+        prefix = random_prefix(rd);
+    }
+
+    // addresses under the prefixes (so most lookups match something), in random order
+    constexpr size_t address_count = 1 << 20;
+    vector<uint32_t> addresses(address_count);
+    for (auto &address : addresses) {
+        const auto &[prefix, length] = prefixes[rd() % prefixes.size()];
+        address = LPMTable::mask(prefix, length) | (uint32_t(rd()) & ~LPMTable::mask(~uint32_t{0}, length));
+    }
+
+    cout << prefix_count << " prefixes:\n";
+    for (const auto &[algorithm, name] : algorithms) {
+        const auto table = LPMTable::make(algorithm);
+
+        const auto insert_start = high_resolution_clock::now();
+        for (size_t i = 0; i < prefixes.size(); i++) {
+            table->insert(prefixes[i].first, prefixes[i].second, i);
+        }
+        const auto insert_end = high_resolution_clock::now();
+
+        // the linear scan gets a small sample, or it would take hours
+        const size_t lookups = algorithm == LPMAlgorithm::Linear ? 200 : address_count;
+        size_t matched = 0;
+        const auto lookup_start = high_resolution_clock::now();
+        for (size_t i = 0; i < lookups; i++) {
+            matched += table->lookup(addresses[i]).has_value();
+        }
+        const auto lookup_end = high_resolution_clock::now();
+
+        if (matched != lookups) {
+            throw runtime_error(name + ": an address under a prefix didn't match");
+        }
+
+        const auto insert_ms = duration_cast<milliseconds>(insert_end - insert_start).count();
+        const auto lookup_ns = duration_cast<nanoseconds>(lookup_end - lookup_start).count();
+        const double lookups_per_s = double(lookups) / double(lookup_ns) * 1e9;
+
+        cout << fixed << setprecision(0);
+        cout << "  " << setw(10) << left << name << right << " inserted in " << setw(6) << insert_ms << " ms, "
+             << setw(12) << lookups_per_s << " lookups/s\n";
+    }
+}
+
+int main() {
+    try {
+        for (const size_t prefix_count : {size_t{100000}, size_t{1000000}}) {
+            benchmark(prefix_count);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -2,11 +2,18 @@
 #include "router.hh"
 #include "util.hh"
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <list>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 using namespace std;
+using namespace std::chrono;
 
 auto rd = get_random_generator();
 
@@ -343,8 +350,92 @@ void network_simulator() {
     cout << "\n\n\033[32;1mCongratulations! All datagrams were routed successfully.\033[m\n";
 }
 
-int main() {
+//! Measure the router's aggregate forwarding throughput as route_parallel() uses more workers
+void forwarding_benchmark() {
+    constexpr size_t interface_count = 8;
+    constexpr size_t datagrams_per_interface = 50000;
+    constexpr size_t rounds = 10;
+
+    // interface k is 192.168.k.1, with a neighbor at 192.168.k.2 that is the next hop to 10.k.0.0/16
+    Router router;
+    vector<EthernetAddress> router_addresses{};
+    for (size_t k = 0; k < interface_count; k++) {
+        router_addresses.push_back(random_router_ethernet_address());
+        const uint32_t subnet = ip("192.168.0.0") | (k << 8);
+        router.add_interface({router_addresses.back(), Address::from_ipv4_numeric(subnet | 1)});
+        router.add_route(ip("10.0.0.0") | (k << 16), 16, Address::from_ipv4_numeric(subnet | 2), k);
+
+        // an unsolicited ARP reply tells the router the neighbor's Ethernet address
+        ARPMessage arp;
+        arp.opcode = ARPMessage::OPCODE_REPLY;
+        arp.sender_ethernet_address = random_host_ethernet_address();
+        arp.sender_ip_address = subnet | 2;
+        arp.target_ethernet_address = router_addresses.back();
+        arp.target_ip_address = subnet | 1;
+        EthernetFrame frame;
+        frame.header() = {router_addresses.back(), arp.sender_ethernet_address, EthernetHeader::TYPE_ARP};
+        frame.payload() = arp.serialize();
+        router.interface(k).recv_frame(frame);
+    }
+
+    // each neighbor sends datagrams to random destinations behind the others
+    vector<vector<EthernetFrame>> traffic(interface_count);
+    for (size_t k = 0; k < interface_count; k++) {
+        for (size_t i = 0; i < datagrams_per_interface; i++) {
+            InternetDatagram dgram;
+            dgram.header().src = ip("192.168.0.2") | (k << 8);
+            dgram.header().dst = ip("10.0.0.0") | ((rd() % interface_count) << 16) | (rd() & 0xffff);
+            dgram.payload() = string(64, 'x');
+            dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+
+            EthernetFrame frame;
+            frame.header() = {router_addresses[k], random_host_ethernet_address(), EthernetHeader::TYPE_IPv4};
+            frame.payload() = dgram.serialize().concatenate();
+            traffic[k].push_back(move(frame));
+        }
+    }
+
+    cout << "Forwarding " << interface_count * datagrams_per_interface << " datagrams among " << interface_count
+         << " interfaces (" << thread::hardware_concurrency() << " hardware threads):\n";
+    for (size_t workers = 1; workers <= interface_count; workers++) {
+        // the traffic arrives in rounds, each routed by one call (so the workers are reused between calls)
+        int64_t duration = 0;
+        size_t forwarded = 0;
+        for (size_t round = 0; round < rounds; round++) {
+            for (size_t k = 0; k < interface_count; k++) {
+                for (size_t i = round; i < traffic[k].size(); i += rounds) {
+                    router.interface(k).recv_frame(traffic[k][i]);
+                }
+            }
+
+            const auto start = steady_clock::now();
+            router.route_parallel(workers);
+            duration += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+            for (size_t k = 0; k < interface_count; k++) {
+                auto &frames = router.interface(k).frames_out();
+                forwarded += frames.size();
+                frames = {};
+            }
+        }
+        if (forwarded != interface_count * datagrams_per_interface) {
+            throw runtime_error("forwarded " + to_string(forwarded) + " datagrams, expected " +
+                                to_string(interface_count * datagrams_per_interface));
+        }
+
+        cout << fixed << setprecision(2);
+        cout << "  " << workers << " worker" << (workers == 1 ? " " : "s") << setw(10)
+             << double(forwarded) / double(duration) * 1000.0 << " M datagrams/s\n";
+    }
+}
+
+int main(int argc, char **argv) {
     try {
+        if (argc == 2 and strcmp(argv[1], "-b") == 0) {
+            forwarding_benchmark();
+            return EXIT_SUCCESS;
+        }
+
         network_simulator();
     } catch (const exception &e) {
         cerr << "\n\n\n";
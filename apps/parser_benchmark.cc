@@ -0,0 +1,167 @@
+#include "ethernet_frame.hh"
+#include "ethernet_header.hh"
+#include "ipv4_datagram.hh"
+#include "ipv4_header.hh"
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <pcap/pcap.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Times each way of reading the frames is run over all of them
+constexpr unsigned ROUNDS = 2000;
+
+//! \returns the Ethernet frames in a capture file that carry IPv4 datagrams
+static vector<Buffer> read_frames(const char *filename) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t *pcap = pcap_open_offline(filename, static_cast<char *>(errbuf));
+    if (pcap == nullptr) {
+        throw runtime_error("opening " + string(filename) + ": " + static_cast<char *>(errbuf));
+    }
+    if (pcap_datalink(pcap) != 1) {
+        pcap_close(pcap);
+        throw runtime_error("expected ethernet linktype in capture file");
+    }
+
+    vector<Buffer> frames;
+    const uint8_t *pkt;
+    struct pcap_pkthdr hdr;
+    while ((pkt = pcap_next(pcap, &hdr)) != nullptr) {
+        if (hdr.caplen >= EthernetHeader::LENGTH and pkt[12] == 0x08 and pkt[13] == 0x00) {
+            frames.emplace_back(string(pkt, pkt + hdr.caplen));
+        }
+    }
+    pcap_close(pcap);
+    return frames;
+}
+
+//! Run `read_frame` on every frame ROUNDS times, and print the time it took per frame
+template <typename Frame>
+static void benchmark(const string &name,
+                      const vector<Frame> &frames,
+                      const function<uint64_t(const Frame &)> &read_frame) {
+    uint64_t total = 0;  // of the values read, so they can't be optimized away
+    const auto start = steady_clock::now();
+    for (unsigned round = 0; round < ROUNDS; round++) {
+        for (const auto &frame : frames) {
+            total += read_frame(frame);
+        }
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    cout << fixed << setprecision(1);
+    cout << "  " << setw(42) << left << name << right << setw(8) << double(duration) / ROUNDS / frames.size()
+         << " ns/frame  (" << hex << total % 0x10000 << dec << ")\n";
+}
+
+int main(int argc, char **argv) {
+    try {
+        if (argc != 2) {
+            cerr << "Usage: " << argv[0] << " CAPTURE_FILE (e.g., tests/ipv4_parser.data)\n";
+            return EXIT_FAILURE;
+        }
+
+        const vector<Buffer> frames = read_frames(argv[1]);
+        if (frames.empty()) {
+            throw runtime_error("no IPv4 frames in capture file");
+        }
+        cout << frames.size() << " IPv4 frames, read " << ROUNDS << " times:\n";
+
+        benchmark<Buffer>("frame, datagram and segment parse()", frames, [](const Buffer &frame_bytes) -> uint64_t {
+            EthernetFrame frame;
+            IPv4Datagram dgram;
+            TCPSegment seg;
+            if (frame.parse(frame_bytes) != ParseResult::NoError or
+                dgram.parse(frame.payload()) != ParseResult::NoError or
+                seg.parse(dgram.payload(), dgram.header().pseudo_cksum()) != ParseResult::NoError) {
+                return 0;
+            }
+            return dgram.header().dst + seg.header().dport + seg.payload().size();
+        });
+
+        benchmark<Buffer>("header structs (NetParser)", frames, [](const Buffer &frame_bytes) -> uint64_t {
+            NetParser p{frame_bytes};
+            EthernetHeader ethernet_header{};
+            IPv4Header ip_header;
+            TCPHeader tcp_header;
+            if (ethernet_header.parse(p) != ParseResult::NoError or ip_header.parse(p) != ParseResult::NoError or
+                tcp_header.parse(p) != ParseResult::NoError) {
+                return 0;
+            }
+            return ip_header.dst + ip_header.ttl + ip_header.cksum + tcp_header.dport + tcp_header.seqno.raw_value() +
+                   tcp_header.win;
+        });
+
+        benchmark<Buffer>("header views, every field", frames, [](const Buffer &frame_bytes) -> uint64_t {
+            const EthernetHeaderView ethernet_header{frame_bytes};
+            const IPv4HeaderView ip_header{ethernet_header.payload()};
+            const TCPHeaderView tcp_header{ip_header.payload()};
+            if (not ethernet_header.valid() or not ip_header.valid() or not tcp_header.valid()) {
+                return 0;
+            }
+            uint64_t sum = ethernet_header.dst()[5] + ethernet_header.src()[5] + ethernet_header.type();
+            sum += ip_header.ver() + ip_header.hlen() + ip_header.tos() + ip_header.len() + ip_header.id() +
+                   ip_header.df() + ip_header.mf() + ip_header.offset() + ip_header.ttl() + ip_header.proto() +
+                   ip_header.cksum() + ip_header.src() + ip_header.dst();
+            sum += tcp_header.sport() + tcp_header.dport() + tcp_header.seqno().raw_value() +
+                   tcp_header.ackno().raw_value() + tcp_header.doff() + tcp_header.urg() + tcp_header.ack() +
+                   tcp_header.psh() + tcp_header.rst() + tcp_header.syn() + tcp_header.fin() + tcp_header.win() +
+                   tcp_header.cksum() + tcp_header.uptr();
+            return sum;
+        });
+
+        benchmark<Buffer>("header views, addresses and ports only", frames, [](const Buffer &frame_bytes) -> uint64_t {
+            const IPv4HeaderView ip_header{EthernetHeaderView{frame_bytes}.payload()};
+            const TCPHeaderView tcp_header{ip_header.payload()};
+            if (not ip_header.valid() or not tcp_header.valid()) {
+                return 0;
+            }
+            return ip_header.src() + ip_header.dst() + tcp_header.sport() + tcp_header.dport();
+        });
+
+        // the datagrams and segments, to serialize again
+        vector<pair<IPv4Datagram, TCPSegment>> packets;
+        for (const auto &frame_bytes : frames) {
+            EthernetFrame frame;
+            IPv4Datagram dgram;
+            TCPSegment seg;
+            if (frame.parse(frame_bytes) == ParseResult::NoError and
+                dgram.parse(frame.payload()) == ParseResult::NoError and
+                seg.parse(dgram.payload(), dgram.header().pseudo_cksum()) == ParseResult::NoError) {
+                packets.emplace_back(move(dgram), move(seg));
+            }
+        }
+        cout << packets.size() << " TCP segments, serialized " << ROUNDS << " times:\n";
+
+        using Packet = pair<IPv4Datagram, TCPSegment>;
+        benchmark<Packet>("IPv4 and TCP headers as strings", packets, [](const Packet &packet) -> uint64_t {
+            const string ip_header = packet.first.header().serialize();
+            const BufferList segment = packet.second.serialize(packet.first.header().pseudo_cksum());
+            return ip_header.size() + uint8_t(segment.buffers().front().str()[16]);
+        });
+
+        benchmark<Packet>("IPv4 and TCP headers into a Headroom", packets, [](const Packet &packet) -> uint64_t {
+            Headroom headroom;
+            packet.second.serialize(headroom, packet.first.header().pseudo_cksum());
+            packet.first.header().serialize(headroom);
+            return headroom.size() + uint8_t(headroom.str()[IPv4Header::LENGTH + 16]);
+        });
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
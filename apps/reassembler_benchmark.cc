@@ -0,0 +1,110 @@
+#include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t len = 100 * 1024 * 1024;
+constexpr size_t segment_size = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr size_t capacity = TCPConfig::DEFAULT_CAPACITY;
+
+//! How the segments of each window are delivered to the reassembler
+enum class Order { InOrder, Reversed, Shuffled, ShuffledWithDuplicates };
+
+static string order_name(const Order order) {
+    switch (order) {
+        case Order::InOrder:
+            return "in order:              ";
+        case Order::Reversed:
+            return "reversed windows:      ";
+        case Order::Shuffled:
+            return "shuffled windows:      ";
+        default:
+            return "shuffled + duplicates: ";
+    }
+}
+
+void reassembler_loop(const Order order) {
+    auto rd = get_random_generator();
+    StreamReassembler reassembler{capacity};
+
+    Buffer stream_data{string(len, 'x')};
+    size_t bytes_received = 0;
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (uint64_t window_start = 0; window_start < len; window_start += capacity) {
+        // cut one receive window into segments
+        vector<pair<uint64_t, Buffer>> segments;
+        for (uint64_t index = window_start; index < min(window_start + capacity, uint64_t{len});
+             index += segment_size) {
+            Buffer segment = stream_data;
+            segment.remove_prefix(index);
+            segment.remove_suffix(segment.size() - min(segment_size, segment.size()));
+            segments.emplace_back(index, segment);
+            if (order == Order::ShuffledWithDuplicates) {
+                // overlapping retransmission that starts in the middle of the segment
+                Buffer dup = segment;
+                dup.remove_prefix(dup.size() / 2);
+                segments.emplace_back(index + segment.size() / 2, dup);
+                segments.emplace_back(index, segment);
+            }
+        }
+
+        switch (order) {
+            case Order::InOrder:
+                break;
+            case Order::Reversed:
+                reverse(segments.begin(), segments.end());
+                break;
+            default:
+                shuffle(segments.begin(), segments.end(), rd);
+                break;
+        }
+
+        for (auto &[index, segment] : segments) {
+            reassembler.push_substring(move(segment), index, index + segment_size >= len);
+        }
+
+        // read output
+        ByteStream &out = reassembler.stream_out();
+        bytes_received += out.buffer_size();
+        out.pop_output(out.buffer_size());
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (bytes_received != len or not reassembler.stream_out().eof()) {
+        throw runtime_error("reassembled " + to_string(bytes_received) + " of " + to_string(len) + " bytes");
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    const auto gigabits_per_second = len * 8.0 / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << "StreamReassembler throughput, " << order_name(order) << gigabits_per_second << " Gbit/s\n";
+}
+
+int main() {
+    try {
+        reassembler_loop(Order::InOrder);
+        reassembler_loop(Order::Reversed);
+        reassembler_loop(Order::Shuffled);
+        reassembler_loop(Order::ShuffledWithDuplicates);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
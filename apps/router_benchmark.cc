@@ -0,0 +1,177 @@
+#include "arp_message.hh"
+#include "lpm_table.hh"
+#include "router.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Prefixes in each table
+constexpr size_t prefix_count = 1000000;
+
+//! Addresses looked up, and datagrams routed, in each measurement
+constexpr size_t address_count = 1 << 20;
+
+//! Interfaces on the benchmarked router
+constexpr size_t interface_count = 8;
+
+static const vector<pair<LPMAlgorithm, string>> algorithms = {{LPMAlgorithm::Trie, "trie"},
+                                                              {LPMAlgorithm::Dir24_8, "DIR-24-8"}};
+
+static auto rd = get_random_generator();
+
+//! A random prefix, with lengths spread roughly as in a full Internet routing table (mostly /24)
+static pair<uint32_t, uint8_t> random_prefix() {
+    // weights for lengths 8 to 32, in parts per 100000
+    static discrete_distribution<unsigned> length_distribution{
+        1, 1, 1, 2, 10, 20, 40, 50, 1300, 350, 600, 1200, 2300, 2500, 7000, 7000, 56000, 10, 10, 10, 10, 10, 10, 10, 10};
+    return {uint32_t(rd()), static_cast<uint8_t>(8 + length_distribution(rd))};
+}
+
+//! A random address under one of `prefixes`
+static uint32_t random_address(const vector<pair<uint32_t, uint8_t>> &prefixes) {
+    const auto &[prefix, length] = prefixes[rd() % prefixes.size()];
+    return LPMTable::mask(prefix, length) | (uint32_t(rd()) & ~LPMTable::mask(~uint32_t{0}, length));
+}
+
+static void report(const string &name, const string &variant, const size_t count, const nanoseconds duration) {
+    cout << fixed << setprecision(2);
+    cout << "  " << setw(10) << left << name << setw(24) << variant << right << setw(8)
+         << double(count) / double(duration.count()) * 1000.0 << " M/s\n";
+}
+
+//! Time single lookups against batches of Router::ROUTE_BATCH_SIZE
+static void lookup_benchmark(const vector<pair<uint32_t, uint8_t>> &prefixes) {
+    vector<vector<uint32_t>> batches(address_count / Router::ROUTE_BATCH_SIZE);
+    for (auto &batch : batches) {
+        for (size_t i = 0; i < Router::ROUTE_BATCH_SIZE; i++) {
+            batch.push_back(random_address(prefixes));
+        }
+    }
+
+    cout << "Lookups among " << prefixes.size() << " prefixes:\n";
+    for (const auto &[algorithm, name] : algorithms) {
+        const auto table = LPMTable::make(algorithm);
+        for (size_t i = 0; i < prefixes.size(); i++) {
+            table->insert(prefixes[i].first, prefixes[i].second, i % interface_count);
+        }
+
+        size_t matched = 0;
+        auto start = steady_clock::now();
+        for (const auto &batch : batches) {
+            for (const uint32_t address : batch) {
+                matched += table->lookup(address).has_value();
+            }
+        }
+        report(name, "lookup()", address_count, steady_clock::now() - start);
+
+        vector<optional<size_t>> results{};
+        start = steady_clock::now();
+        for (const auto &batch : batches) {
+            table->lookup_batch(batch, results);
+            for (const auto &result : results) {
+                matched += result.has_value();
+            }
+        }
+        report(name, "lookup_batch()", address_count, steady_clock::now() - start);
+
+        if (matched != 2 * address_count) {
+            throw runtime_error(name + ": an address under a prefix didn't match");
+        }
+    }
+}
+
+//! Time a Router forwarding datagrams one at a time against batches of Router::ROUTE_BATCH_SIZE
+static void router_benchmark(const vector<pair<uint32_t, uint8_t>> &prefixes) {
+    cout << "Forwarding among " << interface_count << " interfaces with " << prefixes.size() << " routes:\n";
+    for (const auto &[algorithm, name] : algorithms) {
+        cerr.setstate(ios::failbit);  // quiet the router's debugging output
+
+        // interface k is 192.168.k.1, with a neighbor at 192.168.k.2 that is every route's next hop
+        Router router{algorithm};
+        vector<EthernetAddress> router_addresses(interface_count);
+        for (size_t k = 0; k < interface_count; k++) {
+            const uint32_t subnet = Address{"192.168.0.0"}.ipv4_numeric() | (k << 8);
+            router.add_interface({router_addresses[k], Address::from_ipv4_numeric(subnet | 1)});
+
+            ARPMessage arp;
+            arp.opcode = ARPMessage::OPCODE_REPLY;
+            arp.sender_ethernet_address = {2, 0, 0, 0, 0, static_cast<uint8_t>(k)};
+            arp.sender_ip_address = subnet | 2;
+            arp.target_ip_address = subnet | 1;
+            EthernetFrame frame;
+            frame.header() = {router_addresses[k], arp.sender_ethernet_address, EthernetHeader::TYPE_ARP};
+            frame.payload() = arp.serialize();
+            router.interface(k).recv_frame(frame);
+        }
+
+        for (size_t i = 0; i < prefixes.size(); i++) {
+            const size_t interface_num = i % interface_count;
+            const uint32_t next_hop = Address{"192.168.0.2"}.ipv4_numeric() | (interface_num << 8);
+            router.add_route(
+                prefixes[i].first, prefixes[i].second, Address::from_ipv4_numeric(next_hop), interface_num);
+        }
+        cerr.clear();
+
+        // parsed from their serialized form, as they would be when read from a network interface
+        vector<InternetDatagram> traffic(address_count);
+        for (auto &dgram : traffic) {
+            InternetDatagram original;
+            original.header().dst = random_address(prefixes);
+            original.payload() = string(64, 'x');
+            original.header().len = original.header().hlen * 4 + original.payload().size();
+            if (dgram.parse(original.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("couldn't parse a serialized datagram");
+            }
+        }
+
+        for (const size_t batch_size : {size_t{1}, Router::ROUTE_BATCH_SIZE}) {
+            vector<InternetDatagram> batch{};
+            const auto start = steady_clock::now();
+            for (size_t i = 0; i < traffic.size(); i += batch_size) {
+                batch.assign(traffic.begin() + i, traffic.begin() + min(i + batch_size, traffic.size()));
+                router.route_batch(batch);
+            }
+            const auto duration = steady_clock::now() - start;
+
+            size_t forwarded = 0;
+            for (size_t k = 0; k < interface_count; k++) {
+                forwarded += router.interface(k).frames_out().size();
+                router.interface(k).frames_out() = {};
+            }
+            if (forwarded != traffic.size()) {
+                throw runtime_error(name + ": forwarded " + to_string(forwarded) + " datagrams, expected " +
+                                    to_string(traffic.size()));
+            }
+
+            report(name, "batches of " + to_string(batch_size), traffic.size(), duration);
+        }
+    }
+}
+
+int main() {
+    try {
+        vector<pair<uint32_t, uint8_t>> prefixes(prefix_count);
+        for (auto &prefix : prefixes) {
+            prefix = random_prefix();
+        }
+
+        lookup_benchmark(prefixes);
+        router_benchmark(prefixes);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
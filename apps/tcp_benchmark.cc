@@ -1,10 +1,14 @@
+#include "lossy_fd_adapter.hh"
 #include "tcp_connection.hh"
 
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
@@ -28,8 +32,11 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+//! Transfer `len` bytes with payloads of up to `mss` bytes, and windows of 64 segments
+void main_loop(const bool reorder, const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE) {
     TCPConfig config;
+    config.mss = mss;
+    config.recv_capacity = config.send_capacity = 64 * mss;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -52,7 +59,9 @@ void main_loop(const bool reorder) {
         // write input into x
         while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
             const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
-            const auto written = x.write(string(bytes_to_send.str().substr(0, want)));
+            Buffer chunk = bytes_to_send;
+            chunk.remove_suffix(chunk.size() - want);
+            const auto written = x.write(move(chunk));
             if (want != written) {
                 throw runtime_error("want = " + to_string(want) + ", written = " + to_string(written));
             }
@@ -95,18 +104,218 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << "CPU-limited throughput, MSS " << setw(5) << mss << (reorder ? " with reordering: " : "                : ")
+         << setw(5) << gigabits_per_second << " Gbit/s\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+//! Push `len` bytes through a ByteStream in TCPConfig::MAX_PAYLOAD_SIZE slices, either copying
+//! (write(string) + read()) or sharing storage (write(Buffer) + peek_buffers()).
+void byte_stream_loop(const bool zero_copy) {
+    ByteStream stream{TCPConfig::DEFAULT_CAPACITY};
+    Buffer bytes_to_send{string(len, 'x')};
+    size_t bytes_received = 0;
+
+    const auto first_time = high_resolution_clock::now();
+
+    while (bytes_received < len) {
+        const auto want = min(stream.remaining_capacity(), bytes_to_send.size());
+        if (zero_copy) {
+            Buffer chunk = bytes_to_send;
+            chunk.remove_suffix(chunk.size() - want);
+            stream.write(move(chunk));
+        } else {
+            stream.write(string(bytes_to_send.str().substr(0, want)));
+        }
+        bytes_to_send.remove_prefix(want);
+
+        while (not stream.buffer_empty()) {
+            if (zero_copy) {
+                const BufferList payload = stream.peek_buffers(TCPConfig::MAX_PAYLOAD_SIZE);
+                bytes_received += payload.size();
+                stream.pop_output(payload.size());
+            } else {
+                bytes_received += stream.read(TCPConfig::MAX_PAYLOAD_SIZE).size();
+            }
+        }
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    const auto gigabits_per_second = len * 8.0 / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << "ByteStream throughput" << (zero_copy ? " (zero-copy):  " : " (copying):    ") << gigabits_per_second
+         << " Gbit/s\n";
+}
+
+//! Bytes transferred by each lossy_loop() run
+constexpr size_t lossy_len = 10 * 1024 * 1024;
+
+//! Simulated time per lossy_loop() iteration; every segment sent in an iteration is answered
+//! within the same iteration, so this is also the round-trip time
+constexpr size_t lossy_rtt_ms = 10;
+
+static string congestion_control_name(const CongestionControl algorithm) {
+    switch (algorithm) {
+        case CongestionControl::NewReno:
+            return "newreno";
+        case CongestionControl::Cubic:
+            return "cubic";
+        default:
+            return "none";
+    }
+}
+
+//! Probability that a segment is swapped with the next one, in reordering runs
+constexpr auto reorder_rate = numeric_limits<uint16_t>::max() / 8;
+
+//! The payload x has sent to y through a lossy path
+struct SentPayload {
+    size_t bytes = 0;                         //!< Payload bytes sent, including any retransmitted
+    size_t needless_bytes = 0;                //!< Bytes of segments that y had already received
+    std::unordered_set<uint32_t> received{};  //!< Sequence numbers of the segments y has received
+};
+
+//! Move segments from x to y, dropping each one according to `loss_model`. If `reorder_model` is
+//! given, it swaps each surviving segment with the next one with probability `reorder_rate`.
+//! If `sent` is given, it tallies the payload x sent.
+static void move_segments_lossy(TCPConnection &x,
+                                TCPConnection &y,
+                                LossModel &loss_model,
+                                const uint16_t loss,
+                                LossModel *reorder_model = nullptr,
+                                SentPayload *sent = nullptr) {
+    vector<TCPSegment> segments;
+    while (not x.segments_out().empty()) {
+        if (sent) {
+            sent->bytes += x.segments_out().front().payload().size();
+        }
+        if (not loss_model.should_drop(loss)) {
+            segments.emplace_back(move(x.segments_out().front()));
+        }
+        x.segments_out().pop();
+    }
+    for (size_t i = 0; reorder_model and i + 1 < segments.size(); i++) {
+        if (reorder_model->should_drop(reorder_rate)) {
+            swap(segments[i], segments[i + 1]);
+            i++;
+        }
+    }
+    for (auto &segment : segments) {
+        // a retransmission resends the very same segment, so its sequence number identifies it
+        if (sent and segment.payload().size() > 0) {
+            if (not sent->received.insert(segment.header().seqno.raw_value()).second) {
+                sent->needless_bytes += segment.payload().size();
+            }
+        }
+        y.segment_received(move(segment));
+    }
+}
+
+//! Transfer `lossy_len` bytes through a path that drops segments in both directions with
+//! probability `loss_rate` (using the same loss model as LossyFdAdapter) and report the goodput
+//! in simulated time, along with how much of the data had to be sent more than once, and how much of
+//! that y had already received.
+//! With `reorder`, x's segments are also delivered slightly out of order.
+void lossy_loop(const CongestionControl algorithm, const double loss_rate, const bool sack, const bool reorder) {
+    TCPConfig config;
+    config.rt_timeout = 4 * lossy_rtt_ms;
+    config.congestion_control = algorithm;
+    config.sack = sack;
+    TCPConnection x{config}, y{config};
+
+    const auto loss = static_cast<uint16_t>(loss_rate * numeric_limits<uint16_t>::max());
+    // fixed seeds, and separate sources for loss and reordering, so that runs are comparable
+    LossModel loss_model{1}, reorder_model{2};
+    SentPayload sent{};
+
+    Buffer bytes_to_send{string(lossy_len, 'x')};
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+    size_t bytes_received = 0;
+    uint64_t elapsed_ms = 0;
+
+    while (not y.inbound_stream().eof()) {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            Buffer chunk = bytes_to_send;
+            chunk.remove_suffix(chunk.size() - min(x.remaining_outbound_capacity(), chunk.size()));
+            bytes_to_send.remove_prefix(x.write(move(chunk)));
+        }
+
+        if (bytes_to_send.size() == 0 and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        move_segments_lossy(x, y, loss_model, loss, reorder ? &reorder_model : nullptr, &sent);
+        move_segments_lossy(y, x, loss_model, loss);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        bytes_received += available_output;
+        y.inbound_stream().pop_output(available_output);
+
+        x.tick(lossy_rtt_ms);
+        y.tick(lossy_rtt_ms);
+        elapsed_ms += lossy_rtt_ms;
+
+        if (not x.active() and not y.inbound_stream().eof()) {
+            throw runtime_error("connection aborted after " + to_string(bytes_received) + " bytes");
+        }
+    }
+
+    if (bytes_received != lossy_len) {
+        throw runtime_error("received " + to_string(bytes_received) + " of " + to_string(lossy_len) + " bytes");
+    }
+
+    const auto megabits_per_second = lossy_len * 8.0 / 1000.0 / double(elapsed_ms);
+    const auto retransmitted_percent = 100.0 * double(sent.bytes - lossy_len) / lossy_len;
+    const auto needless_percent = 100.0 * double(sent.needless_bytes) / lossy_len;
+
+    cout << fixed << setprecision(2);
+    cout << "Simulated goodput, " << setw(7) << left << congestion_control_name(algorithm) << right << " at "
+         << setw(2) << unsigned(loss_rate * 100 + 0.5) << "% loss" << (reorder ? " + reordering" : "             ")
+         << (sack ? ", SACK:    " : ", no SACK: ") << setw(8) << megabits_per_second << " Mbit/s, "
+         << setw(6) << retransmitted_percent << "% retransmitted (" << needless_percent << "% needlessly)\n";
+
+    while (x.active() or y.active()) {
+        move_segments_lossy(x, y, loss_model, loss);
+        move_segments_lossy(y, x, loss_model, loss);
+        x.tick(lossy_rtt_ms);
+        y.tick(lossy_rtt_ms);
+    }
+}
+
 int main() {
     try {
         main_loop(false);
         main_loop(true);
+        // Ethernet, jumbo frames and the largest payload in a 64 KiB IPv4 datagram
+        for (const size_t mss : {1460, 8960, 65495}) {
+            main_loop(false, mss);
+        }
+        byte_stream_loop(false);
+        byte_stream_loop(true);
+        for (const double loss_rate : {0.01, 0.05, 0.10}) {
+            for (const auto algorithm :
+                 {CongestionControl::None, CongestionControl::NewReno, CongestionControl::Cubic}) {
+                lossy_loop(algorithm, loss_rate, false, false);
+            }
+        }
+        for (const double loss_rate : {0.01, 0.05}) {
+            for (const auto algorithm : {CongestionControl::NewReno, CongestionControl::Cubic}) {
+                for (const bool sack : {false, true}) {
+                    lossy_loop(algorithm, loss_rate, sack, true);
+                }
+            }
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
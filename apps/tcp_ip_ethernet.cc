@@ -31,6 +31,13 @@ static void show_usage(const char *argv0, const char *msg) {
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+         << "   -c <algorithm>  Congestion control: none, newreno or cubic      none\n\n"
+         << "   -m <mtu>        Size TCP payloads to fill <mtu>-byte IP datagrams (MSS " << TCPConfig::MAX_PAYLOAD_SIZE
+         << ")\n\n"
+
+         << "   -S              Offer selective acknowledgments (SACK)          (no SACK)\n"
+         << "   -T              Offer TCP timestamps                            (no timestamps)\n\n"
+
          << "   -d <tapdev>     Connect to tap <tapdev>                         " << TAP_DFLT << "\n\n"
 
          << "   -h              Show this message.\n\n";
@@ -85,6 +92,34 @@ static tuple<TCPConfig, FdAdapterConfig, Address, string> get_config(int argc, c
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-c", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -c requires one argument.");
+            const string algorithm = argv[curr + 1];
+            if (algorithm == "none") {
+                c_fsm.congestion_control = CongestionControl::None;
+            } else if (algorithm == "newreno") {
+                c_fsm.congestion_control = CongestionControl::NewReno;
+            } else if (algorithm == "cubic") {
+                c_fsm.congestion_control = CongestionControl::Cubic;
+            } else {
+                show_usage(argv[0], "ERROR: -c must be one of none, newreno or cubic.");
+                exit(1);
+            }
+            curr += 2;
+
+        } else if (strncmp("-m", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -m requires one argument.");
+            c_filt.mtu = strtol(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-S", argv[curr], 3) == 0) {
+            c_fsm.sack = true;
+            curr += 1;
+
+        } else if (strncmp("-T", argv[curr], 3) == 0) {
+            c_fsm.timestamps = true;
+            curr += 1;
+
         } else if (strncmp("-d", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -t requires one argument.");
             tapdev = argv[curr + 1];
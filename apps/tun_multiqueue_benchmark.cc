@@ -0,0 +1,153 @@
+#include "address.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_sponge_socket.hh"
+#include "tun.hh"
+#include "tuntap_adapter.hh"
+#include "util.hh"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <linux/if.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Name of the (temporary) multiqueue TUN device each run creates
+constexpr const char *DEVICE = "tunmq144";
+
+//! Address of the kernel's end of the device, and of the TCPSpongeServer behind it
+const string KERNEL_ADDRESS = "169.254.244.1";
+const string SPONGE_ADDRESS = "169.254.244.9";
+
+//! TCP connections, from the kernel to the TCPSpongeServer, in each run
+constexpr size_t FLOWS = 16;
+
+//! Bytes sent at a time by each connection
+constexpr size_t CHUNK_SIZE = 65536;
+
+//! Set an IPv4 address or netmask of `device`, with `request` (SIOCSIFADDR or SIOCSIFNETMASK)
+static void set_device_address(const int sock,
+                               const string &device,
+                               const unsigned long request,
+                               const string &address) {
+    ifreq req{};
+    strncpy(static_cast<char *>(req.ifr_name), device.c_str(), IFNAMSIZ - 1);
+    sockaddr_in sin{};
+    sin.sin_family = AF_INET;
+    if (inet_pton(AF_INET, address.c_str(), &sin.sin_addr) != 1) {
+        throw runtime_error("bad address " + address);
+    }
+    memcpy(&req.ifr_addr, &sin, sizeof(sin));
+    SystemCall("ioctl (set address)", ioctl(sock, request, &req));
+}
+
+//! Give `device` the kernel's address on a /24, and bring it up
+static void configure_device(const string &device) {
+    FileDescriptor sock{SystemCall("socket", socket(AF_INET, SOCK_DGRAM, 0))};
+    set_device_address(sock.fd_num(), device, SIOCSIFADDR, KERNEL_ADDRESS);
+    set_device_address(sock.fd_num(), device, SIOCSIFNETMASK, "255.255.255.0");
+
+    ifreq req{};
+    strncpy(static_cast<char *>(req.ifr_name), device.c_str(), IFNAMSIZ - 1);
+    SystemCall("ioctl (get flags)", ioctl(sock.fd_num(), SIOCGIFFLAGS, &req));
+    req.ifr_flags |= IFF_UP;
+    SystemCall("ioctl (set flags)", ioctl(sock.fd_num(), SIOCSIFFLAGS, &req));
+}
+
+//! Send FLOWS connections' worth of data from the kernel, through a device with `queue_count` queues, to
+//! a TCPSpongeServer with a TCP thread per queue
+//! \returns the goodput, in Gbit/s
+static double run(const size_t queue_count, const size_t bytes_per_flow) {
+    // opening the first queue creates the device, which goes away when the last is closed
+    vector<TCPOverIPv4OverTunFdAdapter> adapters;
+    for (auto &queue : TunFD::open_queues(DEVICE, queue_count)) {
+        adapters.emplace_back(move(queue));
+    }
+    configure_device(DEVICE);
+
+    TCPConfig c_tcp{};
+    c_tcp.recv_capacity = 1 << 20;
+    c_tcp.send_capacity = 1 << 20;
+    FdAdapterConfig c_ad{};
+    c_ad.source = {SPONGE_ADDRESS, uint16_t(9000 + queue_count)};
+    c_ad.mtu = 1500;
+
+    TCPOverIPv4SpongeServer server{move(adapters)};
+    server.listen(c_tcp, c_ad, FLOWS);
+
+    const auto start = steady_clock::now();
+
+    vector<thread> senders;
+    for (size_t i = 0; i < FLOWS; i++) {
+        senders.emplace_back([&] {
+            TCPSocket sock;
+            sock.connect(c_ad.source);
+            const string chunk(CHUNK_SIZE, 'x');
+            for (size_t sent = 0; sent < bytes_per_flow; sent += chunk.size()) {
+                sock.write(chunk);
+            }
+        });
+    }
+
+    vector<size_t> received(FLOWS, 0);
+    vector<thread> receivers;
+    for (size_t i = 0; i < FLOWS; i++) {
+        receivers.emplace_back([&received, i, stream = server.accept().first]() mutable {
+            while (not stream.eof()) {
+                received[i] += stream.read().size();
+            }
+        });
+    }
+    for (auto &t : senders) {
+        t.join();
+    }
+    for (auto &t : receivers) {
+        t.join();
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    size_t total = 0;
+    for (const auto bytes : received) {
+        total += bytes;
+    }
+    if (total != FLOWS * bytes_per_flow) {
+        throw runtime_error("received " + to_string(total) + " bytes, expected " + to_string(FLOWS * bytes_per_flow));
+    }
+    return 8.0 * total / duration;
+}
+
+int main(int argc, char **argv) {
+    try {
+        if (argc > 2) {
+            cerr << "Usage: " << argv[0] << " [MIB_PER_FLOW] (run as root, to create a multiqueue TUN device)\n";
+            return EXIT_FAILURE;
+        }
+        const size_t bytes_per_flow = (argc == 2 ? stoul(argv[1]) : 4) << 20;
+
+        cout << FLOWS << " TCP connections of " << (bytes_per_flow >> 20) << " MiB each, from the kernel through "
+             << DEVICE << " to a TCPSpongeServer (" << thread::hardware_concurrency() << " CPUs):\n";
+        for (const size_t queue_count : {1, 2, 4, 8}) {
+            const double goodput = run(queue_count, bytes_per_flow);
+            cout << fixed << setprecision(2);
+            cout << "  " << queue_count << " queue(s), one TCP thread each: " << setw(6) << goodput << " Gbit/s\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
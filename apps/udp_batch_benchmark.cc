@@ -0,0 +1,116 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "socket.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Number of datagrams to send through each variant
+constexpr size_t total_datagrams = 1 << 20;
+
+//! Size of each datagram, about that of a full-sized TCP segment
+constexpr size_t datagram_size = 1400;
+
+//! Send and receive `batch_size` datagrams at a time, one system call per datagram
+static size_t one_at_a_time(UDPSocket &sender, UDPSocket &receiver, const size_t batch_size) {
+    const Address destination = receiver.local_address();
+    const string payload(datagram_size, 'x');
+    UDPSocket::received_datagram datagram{{"0", 0}, ""};
+
+    size_t received = 0;
+    for (size_t sent = 0; sent < total_datagrams; sent += batch_size) {
+        for (size_t i = 0; i < batch_size; i++) {
+            sender.sendto(destination, payload);
+        }
+        for (size_t i = 0; i < batch_size; i++) {
+            receiver.recv(datagram);
+            received += datagram.payload.size() == datagram_size;
+        }
+    }
+    return received;
+}
+
+//! Send and receive `batch_size` datagrams at a time with sendmmsg and recvmmsg
+static size_t batched(UDPSocket &sender, UDPSocket &receiver, const size_t batch_size) {
+    const Address destination = receiver.local_address();
+    const string payload(datagram_size, 'x');
+    const vector<BufferViewList> payloads(batch_size, BufferViewList(payload));
+    UDPSocket::RecvBatch batch{batch_size};
+
+    size_t received = 0;
+    for (size_t sent = 0; sent < total_datagrams; sent += batch_size) {
+        sender.send_batch(destination, payloads);
+        for (size_t pending = batch_size; pending > 0; pending -= batch.size()) {
+            receiver.recv_batch(batch);
+            for (size_t i = 0; i < batch.size(); i++) {
+                received += batch.payload(i).size() == datagram_size;
+            }
+        }
+    }
+    return received;
+}
+
+//! Send `batch_size` datagrams at a time with UDP_SEGMENT, and receive them coalesced with UDP_GRO
+static size_t offloaded(UDPSocket &sender, UDPSocket &receiver, const size_t batch_size) {
+    const Address destination = receiver.local_address();
+    const string payload(datagram_size * batch_size, 'x');
+    UDPSocket::coalesced_datagrams datagrams{{"0", 0}, {}};
+    receiver.enable_gro();
+
+    size_t received = 0;
+    for (size_t sent = 0; sent < total_datagrams; sent += batch_size) {
+        sender.send_segmented(destination, payload, datagram_size);
+        for (size_t pending = batch_size; pending > 0; pending -= datagrams.payloads.size()) {
+            receiver.recv_coalesced(datagrams);
+            for (const auto &datagram : datagrams.payloads) {
+                received += datagram.size() == datagram_size;
+            }
+        }
+    }
+    return received;
+}
+
+static void run(const string &name, size_t (*variant)(UDPSocket &, UDPSocket &, const size_t), const size_t batch_size) {
+    UDPSocket sender, receiver;
+    sender.bind({"127.0.0.1", 0});
+    receiver.bind({"127.0.0.1", 0});
+
+    const auto first_time = high_resolution_clock::now();
+    const size_t received = variant(sender, receiver, batch_size);
+    const auto final_time = high_resolution_clock::now();
+
+    if (received != total_datagrams) {
+        throw runtime_error(name + ": expected " + to_string(total_datagrams) + " datagrams, got " +
+                            to_string(received));
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const auto kpps = double(total_datagrams) / double(duration) * 1e6;
+
+    cout << fixed << setprecision(1);
+    cout << "  " << setw(18) << left << name << right << " batches of " << setw(2) << batch_size << ": " << setw(8)
+         << kpps << " kpps\n";
+}
+
+int main() {
+    try {
+        cout << "UDP over loopback, " << total_datagrams << " datagrams of " << datagram_size << " bytes:\n";
+        for (const size_t batch_size : {size_t{16}, size_t{32}}) {
+            run("sendto/recv", one_at_a_time, batch_size);
+            run("sendmmsg/recvmmsg", batched, batch_size);
+            run("GSO/GRO", offloaded, batch_size);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
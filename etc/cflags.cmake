@@ -2,6 +2,13 @@ set (CMAKE_CXX_STANDARD 17)
 set (CMAKE_EXPORT_COMPILE_COMMANDS ON)
 set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -std=c++17 -g -pedantic -pedantic-errors -Werror -Wall -Wextra -Wshadow -Wpointer-arith -Wcast-qual -Wformat=2 -Weffc++ -Wold-style-cast")
 
+# Buffers count their references atomically once a program has a second thread; this counts them without
+# atomic operations regardless, which is only safe if no Buffer is shared between threads
+option (SPONGE_NONATOMIC_BUFFERS "Count Buffer references without atomic operations" OFF)
+if (SPONGE_NONATOMIC_BUFFERS)
+    set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DSPONGE_NONATOMIC_BUFFER_REFCOUNT")
+endif ()
+
 # check for supported compiler versions
 set (IS_GNU_COMPILER ("${CMAKE_CXX_COMPILER_ID}" STREQUAL "GNU"))
 set (IS_CLANG_COMPILER ("${CMAKE_CXX_COMPILER_ID}" MATCHES "[Cc][Ll][Aa][Nn][Gg]"))
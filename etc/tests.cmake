@@ -21,6 +21,8 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_fast_retx       COMMAND send_fast_retx)
+add_test(NAME t_send_rtt             COMMAND send_rtt)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -56,6 +58,14 @@ add_test(NAME t_connect              COMMAND fsm_connect_relaxed)
 add_test(NAME ec_listen              COMMAND fsm_listen)
 add_test(NAME t_listen               COMMAND fsm_listen_relaxed)
 add_test(NAME t_winsize              COMMAND fsm_winsize)
+add_test(NAME t_options              COMMAND fsm_options)
+add_test(NAME t_demux                COMMAND fsm_demux)
+add_test(NAME t_timer_wheel          COMMAND timer_wheel)
+add_test(NAME t_lpm_table            COMMAND lpm_table)
+add_test(NAME t_router_parallel      COMMAND router_parallel)
+add_test(NAME t_tcp_sponge_server    COMMAND tcp_sponge_server)
+add_test(NAME t_eventloop            COMMAND eventloop)
+add_test(NAME t_buffer_pool          COMMAND buffer_pool)
 add_test(NAME ec_retx                COMMAND fsm_retx)
 add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
@@ -120,6 +130,10 @@ add_test(NAME t_usD_128K_8K_l        COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -us
 add_test(NAME t_usD_128K_8K_L        COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -usDd 128K -w 8K -L ${LOSS_RATE})
 add_test(NAME t_usD_128K_8K_lL       COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -usDd 128K -w 8K -l ${LOSS_RATE} -L ${LOSS_RATE})
 
+add_test(NAME t_ucD_1M_32K_g         COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -ucDd 1M -w 32K -g)
+add_test(NAME t_usD_1M_32K_g         COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -usDd 1M -w 32K -g)
+add_test(NAME t_ucS_128K_8K_lL_g     COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -ucSd 128K -w 8K -l ${LOSS_RATE} -L ${LOSS_RATE} -g)
+
 add_test(NAME t_ipv4_client_send     COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -icS)
 add_test(NAME t_ipv4_server_send     COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -isS)
 add_test(NAME t_ipv4_client_recv     COMMAND "${PROJECT_SOURCE_DIR}/txrx.sh" -icR)
@@ -14,62 +14,60 @@ void DUMMY_CODE(Targs &&.../* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : _buf(capacity), _capacity(capacity) {}
+ByteStream::ByteStream(const size_t capacity) : _capacity(capacity) {}
 
 size_t ByteStream::write(const string &data) {
-    size_t nwritten = 0;         // Number of bytes successfully written to _buf during iteration
-    size_t nleft = data.size();  // Number of bytes left to write
-    size_t n_to_write;           // Number of bytes to write in one iteration
-
-    while (nleft > 0 && _size < _capacity) {  // Continue writing while there is data left and _buf is not full.
-        // Calculate the number of bytes that can be written in this iteration.
-        // Since _buf is a Circular Queue, the amount to write, n_to_write, depends on the position of _head and _tail.
-        if (_head <= _tail) {
-            // Since we have checked the size in the while statement, _head == _tail means the buffer is empty .
-            // If _size equals _capacity, it would indicate the buffer is full, but that condition is handled by
-            // the while loop guard.
-            // If _head <= _tail, write until data runs out or until reaching the end of _buf.
-            // If _tail reach the _buf's end, _tail will be wrap to 0 and we will continue writing the remaining data in
-            // the next iteration.
-            n_to_write = std::min(nleft, _capacity - _tail);
-        } else {
-            // Otherwise, when _tail < _head, write until data runs out or
-            // the _tail reaches _head, which means _buf is full.
-            n_to_write = std::min(nleft, _head - _tail);
-        }
+    // Copy only the part of data that fits, then hand it over as a chunk.
+    const size_t n_to_write = std::min(data.size(), remaining_capacity());
+    if (n_to_write == 0) {
+        return 0;
+    }
+    return write(Buffer::copy_of(string_view(data).substr(0, n_to_write)));
+}
 
-        // Copy the data from input string to _buf starting at _tail.
-        std::copy(data.begin() + nwritten, data.begin() + nwritten + n_to_write, _buf.begin() + _tail);
-        _tail = (_tail + n_to_write) % _capacity;  // Update _tail , wrapping around if reaching the end of _buf
-        _size += n_to_write;
-        nwritten += n_to_write;
-        nleft -= n_to_write;
+size_t ByteStream::write(Buffer data) {
+    const size_t n_to_write = std::min(data.size(), remaining_capacity());
+    if (n_to_write == 0) {
+        return 0;
     }
-    _write_cnt += nwritten;
-    return nwritten;
+    // Keep only the prefix that fits; the underlying storage is shared rather than copied.
+    data.remove_suffix(data.size() - n_to_write);
+    _buffers.push_back(std::move(data));
+    _size += n_to_write;
+    _write_cnt += n_to_write;
+    return n_to_write;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 // peek_output is the counterpart of a write operation, but it does not consume data from the buffer
 string ByteStream::peek_output(const size_t len) const {
     // Output size is determined by the samllest value between the current buffer size and the size need to read.
-    string output(std::min(len, _size), '\0');
-    size_t nread = 0, nleft = len, n_to_read;
-    size_t head = _head, size = _size;  // Since the function is const, we need to create some local copy
-
-    while (nleft > 0 && size > 0) {
-        if (head < _tail) {
-            n_to_read = std::min(nleft, _tail - head);
-        } else {
-            // Note in this iteration, if head == _tail, it means _buf is full.
-            // Though head == _tail can also mean _buf is emtpy, but this case is excluded by the while condition.
-            n_to_read = std::min(nleft, _capacity - head);
+    string output;
+    output.reserve(std::min(len, _size));
+    size_t nleft = len;
+
+    for (auto it = _buffers.begin(); it != _buffers.end() && nleft > 0; ++it) {
+        const string_view chunk = it->str().substr(0, nleft);
+        output.append(chunk);
+        nleft -= chunk.size();
+    }
+
+    return output;
+}
+
+//! \param[in] len bytes will be sliced from the output side of the buffer
+//! \returns a BufferList whose Buffers share storage with the stream (no bytes are copied)
+BufferList ByteStream::peek_buffers(const size_t len) const {
+    BufferList output;
+    size_t nleft = len;
+
+    for (auto it = _buffers.begin(); it != _buffers.end() && nleft > 0; ++it) {
+        Buffer chunk = *it;
+        if (chunk.size() > nleft) {
+            chunk.remove_suffix(chunk.size() - nleft);
         }
-        std::copy(_buf.begin() + head, _buf.begin() + head + n_to_read, output.begin() + nread);
-        head = (head + n_to_read) % _capacity;
-        size -= n_to_read;
-        nread += n_to_read;
-        nleft -= n_to_read;
+        nleft -= chunk.size();
+        output.append(chunk);
     }
 
     return output;
@@ -78,9 +76,18 @@ string ByteStream::peek_output(const size_t len) const {
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
     size_t nremoved = std::min(len, _size);
-    _head = (_head + nremoved) % _capacity;
     _read_cnt += nremoved;
     _size -= nremoved;
+
+    while (nremoved > 0) {
+        Buffer &front = _buffers.front();
+        if (nremoved < front.size()) {
+            front.remove_prefix(nremoved);
+            break;
+        }
+        nremoved -= front.size();
+        _buffers.pop_front();
+    }
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
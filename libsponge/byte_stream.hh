@@ -1,8 +1,10 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
+#include <deque>
 #include <string>
-#include <vector>
 
 //! \brief An in-order byte stream.
 
@@ -12,18 +14,16 @@
 class ByteStream {
   private:
     // Your code here -- add private members as necessary.
-    // Use Circular Queue to implement ByteStream
-    // Because we can't use _head ==_tail to determine whether _buf is empty or full,
-    // it is necessary to use a additional variable _size to indicate it.
-    std::vector<char> _buf;     // Internal buffer to store bytes
-    size_t _head = 0;           // _buf[_head] is the first bytes
-    size_t _tail = 0;           // _buf[_tail-1] is the last bytes
-    size_t _size = 0;           // Number of currently stored bytes
-    size_t _capacity;           // Max capacity of the _buf
-    size_t _read_cnt = 0;       // Number of totally read bytes
-    size_t _write_cnt = 0;      // Number of totally writed bytes
-    bool _input_ended = false;  // Flag indicating that the input has ended
-    bool _error = false;        //!< Flag indicating that the stream suffered an error.
+    // Store the written data as a queue of reference-counted chunks instead of copying
+    // every byte into a ring buffer. A chunk written by move (or as a Buffer) is kept as-is,
+    // and readers can take slices of it (see peek_buffers) without copying the payload.
+    std::deque<Buffer> _buffers{};  // Internal chunks; _buffers.front() holds the first unread bytes
+    size_t _size = 0;               // Number of currently stored bytes
+    size_t _capacity;               // Max number of bytes stored in _buffers at once
+    size_t _read_cnt = 0;           // Number of totally read bytes
+    size_t _write_cnt = 0;          // Number of totally writed bytes
+    bool _input_ended = false;      // Flag indicating that the input has ended
+    bool _error = false;            //!< Flag indicating that the stream suffered an error.
 
     // Hint: This doesn't need to be a sophisticated data structure at
     // all, but if any of your tests are taking longer than a second,
@@ -42,6 +42,15 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream by taking ownership of it (no copy).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data) { return write(Buffer(std::move(data))); }
+
+    //! Write a Buffer into the stream. The Buffer's storage is shared, not copied;
+    //! if it doesn't fit, only a prefix of it is kept.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -59,6 +68,10 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns a BufferList sharing storage with the stream
+    BufferList peek_buffers(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -0,0 +1,120 @@
+#include "congestion_controller.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//! \param[in] algorithm is the congestion control algorithm to use
+//! \param[in] mss is the sender's maximum segment size, in bytes
+unique_ptr<CongestionController> CongestionController::make(const CongestionControl algorithm, const size_t mss) {
+    switch (algorithm) {
+        case CongestionControl::NewReno:
+            return make_unique<NewRenoController>(mss);
+        case CongestionControl::Cubic:
+            return make_unique<CubicController>(mss);
+        default:
+            return nullptr;
+    }
+}
+
+//! \details In slow start the window grows by at most one segment per ack (so by roughly 2x per RTT).
+//! In congestion avoidance it grows by one segment once a full window's worth of bytes has been acked.
+void NewRenoController::on_ack(const size_t bytes_acked) {
+    if (_in_slow_start()) {
+        _cwnd += min(bytes_acked, _mss);
+        return;
+    }
+
+    _bytes_acked += bytes_acked;
+    if (_bytes_acked >= _cwnd) {
+        _bytes_acked -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+//! \details Per RFC 5681 section 3.1, ssthresh becomes half the flight size.
+size_t NewRenoController::_congestion_event(const size_t bytes_in_flight) {
+    return max(bytes_in_flight / 2, 2 * _mss);
+}
+
+//! \details The window drops to a single segment and slow start begins again.
+void NewRenoController::on_timeout(const size_t bytes_in_flight) {
+    _ssthresh = _congestion_event(bytes_in_flight);
+    _cwnd = _mss;
+    _bytes_acked = 0;
+}
+
+//! \details The window is "inflated" by the three segments that the duplicate acks show have left the network.
+void NewRenoController::on_fast_retransmit(const size_t bytes_in_flight) {
+    _ssthresh = _congestion_event(bytes_in_flight);
+    _cwnd = _ssthresh + 3 * _mss;
+    _bytes_acked = 0;
+}
+
+//! \details Deflates the window by the amount of new data acknowledged, then adds back one segment
+//! if at least that much was acked (RFC 6582 section 3.2, step 5).
+void NewRenoController::on_partial_ack(const size_t bytes_acked) {
+    _cwnd -= min(_cwnd - _mss, bytes_acked);
+    if (bytes_acked >= _mss) {
+        _cwnd += _mss;
+    }
+}
+
+void NewRenoController::on_recovery_exit() {
+    _cwnd = _ssthresh;
+    _bytes_acked = 0;
+}
+
+void CubicController::on_ack(const size_t bytes_acked) {
+    if (_in_slow_start()) {
+        NewRenoController::on_ack(bytes_acked);
+        return;
+    }
+
+    const double cwnd = double(_cwnd) / _mss;  // in segments
+
+    if (not _epoch_start_ms.has_value()) {
+        // first ack of a new congestion avoidance epoch
+        _epoch_start_ms = _now_ms;
+        if (cwnd < _w_max) {
+            _k = cbrt((_w_max - cwnd) / C);
+        } else {
+            _k = 0;
+            _w_max = cwnd;
+        }
+        _w_est = cwnd;
+    }
+
+    const double segments_acked = double(bytes_acked) / _mss;
+    const double t = double(_now_ms - _epoch_start_ms.value()) / 1000;
+    const double w_cubic = C * pow(t - _k, 3) + _w_max;
+    // the Reno-friendly estimate grows like Reno once it has recovered the window lost at the last reduction
+    _w_est += (_w_est < _cwnd_prior ? ALPHA : 1.0) * segments_acked / cwnd;
+
+    // grow towards the larger of the two, but by no more than half a window per window acked
+    const double target = min(max(w_cubic, _w_est), 1.5 * cwnd);
+    if (target > cwnd) {
+        _cwnd_fraction += (target - cwnd) / cwnd * segments_acked * _mss;
+        const auto whole_bytes = static_cast<size_t>(_cwnd_fraction);
+        _cwnd += whole_bytes;
+        _cwnd_fraction -= whole_bytes;
+    }
+}
+
+//! \details As in RFC 9438 sections 4.6 to 4.8, ssthresh is set with the CUBIC decrease factor and the
+//! cubic function is re-centred on the window at the congestion event. That window is taken to be the
+//! flight size when it is larger, so that the repeated timeouts of exponential backoff do not collapse
+//! W_max to a single segment.
+size_t CubicController::_congestion_event(const size_t bytes_in_flight) {
+    const double cwnd = double(max(_cwnd, bytes_in_flight)) / _mss;
+
+    // fast convergence: release bandwidth faster if the window keeps shrinking
+    _w_max = cwnd < _w_last_max ? cwnd * (1 + BETA) / 2 : cwnd;
+    _w_last_max = cwnd;
+    _cwnd_prior = cwnd;
+
+    _cwnd_fraction = 0;
+    _epoch_start_ms.reset();
+    return max(static_cast<size_t>(cwnd * BETA * _mss), 2 * _mss);
+}
@@ -0,0 +1,119 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+
+#include "tcp_config.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+
+//! \brief Interface for the congestion control algorithm of a TCPSender.
+
+//! The TCPSender reports acknowledgments, retransmission timeouts and the passage of time,
+//! and never lets more than window() bytes (in sequence space) be in flight, in addition to
+//! respecting the receiver's advertised window.
+class CongestionController {
+  public:
+    virtual ~CongestionController() = default;
+
+    //! \returns the congestion window, in bytes
+    virtual size_t window() const = 0;
+
+    //! \brief Newly acknowledged data
+    //! \param[in] bytes_acked number of sequence numbers acknowledged for the first time
+    virtual void on_ack(const size_t bytes_acked) = 0;
+
+    //! \brief The retransmission timer expired
+    //! \param[in] bytes_in_flight number of sequence numbers outstanding when the timer fired
+    virtual void on_timeout(const size_t bytes_in_flight) = 0;
+
+    //! \brief Three duplicate acks arrived and the oldest outstanding segment was retransmitted
+    //! \param[in] bytes_in_flight number of sequence numbers outstanding at that moment
+    virtual void on_fast_retransmit(const size_t bytes_in_flight) = 0;
+
+    //! \brief A further duplicate ack arrived during fast recovery
+    virtual void on_duplicate_ack() = 0;
+
+    //! \brief An ack during fast recovery acknowledged some, but not all, of the data outstanding
+    //! when recovery started
+    //! \param[in] bytes_acked number of sequence numbers acknowledged for the first time
+    virtual void on_partial_ack(const size_t bytes_acked) = 0;
+
+    //! \brief Everything outstanding when fast recovery started has been acknowledged
+    virtual void on_recovery_exit() = 0;
+
+    //! \brief Notifies the controller of the passage of time
+    virtual void tick(const size_t ms_since_last_tick) { static_cast<void>(ms_since_last_tick); }
+
+    //! \returns a controller implementing `algorithm`, or nullptr for CongestionControl::None
+    static std::unique_ptr<CongestionController> make(const CongestionControl algorithm, const size_t mss);
+};
+
+//! \brief Slow start and congestion avoidance as in [RFC 5681](\ref rfc::rfc5681), with the
+//! fast recovery of [RFC 6582](https://www.rfc-editor.org/rfc/rfc6582)
+class NewRenoController : public CongestionController {
+  protected:
+    size_t _mss;                                           //!< Sender maximum segment size
+    size_t _cwnd;                                          //!< Congestion window
+    size_t _ssthresh{std::numeric_limits<size_t>::max()};  //!< Slow start threshold
+    size_t _bytes_acked{0};                                //!< Bytes acked since the last CA increase
+
+    //! \returns `true` while the sender is in slow start
+    bool _in_slow_start() const { return _cwnd < _ssthresh; }
+
+    //! \brief Reacts to a loss (timeout or fast retransmit) other than by setting the window
+    //! \returns the new slow start threshold
+    virtual size_t _congestion_event(const size_t bytes_in_flight);
+
+  public:
+    //! Initial window is 10 segments ([RFC 6928](\ref rfc::rfc6928))
+    static constexpr size_t INITIAL_WINDOW_SEGMENTS = 10;
+
+    explicit NewRenoController(const size_t mss) : _mss(mss), _cwnd(INITIAL_WINDOW_SEGMENTS * mss) {}
+
+    size_t window() const override { return _cwnd; }
+    void on_ack(const size_t bytes_acked) override;
+    void on_timeout(const size_t bytes_in_flight) override;
+    void on_fast_retransmit(const size_t bytes_in_flight) override;
+    void on_duplicate_ack() override { _cwnd += _mss; }
+    void on_partial_ack(const size_t bytes_acked) override;
+    void on_recovery_exit() override;
+
+    //! \returns the slow start threshold, in bytes
+    size_t ssthresh() const { return _ssthresh; }
+};
+
+//! \brief CUBIC window growth as in [RFC 9438](https://www.rfc-editor.org/rfc/rfc9438)
+//! \details Slow start and fast recovery are shared with NewRenoController;
+//! congestion avoidance follows the cubic function of the time since the last congestion event,
+//! but never grows more slowly than an equivalent Reno flow would (the "Reno-friendly" region).
+class CubicController : public NewRenoController {
+  private:
+    static constexpr double C = 0.4;     //!< Scaling constant, in segments per second cubed
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    //! Reno-friendly additive increase, in segments per window acked
+    static constexpr double ALPHA = 3 * (1 - BETA) / (1 + BETA);
+
+    uint64_t _now_ms{0};                        //!< Time as seen through tick()
+    std::optional<uint64_t> _epoch_start_ms{};  //!< Start of the current congestion avoidance epoch
+    double _w_max{0};                           //!< Plateau of the cubic function (W_max), in segments
+    double _w_last_max{0};                      //!< _w_max before the last reduction, for fast convergence
+    double _cwnd_prior{0};                      //!< Window before the last reduction, without fast convergence
+    double _k{0};                               //!< Seconds for the cubic function to climb back to _w_max
+    double _w_est{0};                           //!< Estimated Reno-friendly window, in segments
+    double _cwnd_fraction{0};                   //!< Fractional window growth (bytes) carried between acks
+
+  protected:
+    size_t _congestion_event(const size_t bytes_in_flight) override;
+
+  public:
+    explicit CubicController(const size_t mss) : NewRenoController(mss) {}
+
+    void on_ack(const size_t bytes_acked) override;
+    void tick(const size_t ms_since_last_tick) override { _now_ms += ms_since_last_tick; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
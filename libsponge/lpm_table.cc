@@ -0,0 +1,260 @@
+#include "lpm_table.hh"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+using namespace std;
+
+//! \param[in] algorithm is the longest-prefix-match algorithm to use
+unique_ptr<LPMTable> LPMTable::make(const LPMAlgorithm algorithm) {
+    switch (algorithm) {
+        case LPMAlgorithm::Linear:
+            return make_unique<LinearLPMTable>();
+        case LPMAlgorithm::Dir24_8:
+            return make_unique<Dir24_8LPMTable>();
+        default:
+            return make_unique<TrieLPMTable>();
+    }
+}
+
+void LPMTable::lookup_batch(const vector<uint32_t> &addresses, vector<optional<size_t>> &results) const {
+    results.resize(addresses.size());
+    for (size_t i = 0; i < addresses.size(); i++) {
+        results[i] = lookup(addresses[i]);
+    }
+}
+
+void LinearLPMTable::insert(const uint32_t prefix, const uint8_t length, const size_t value) {
+    const uint32_t masked = mask(prefix, length);
+    const auto [existing, added] = _index.try_emplace((uint64_t{masked} << 8) | length, _entries.size());
+    if (added) {
+        _entries.push_back({masked, length, value});
+    } else {
+        _entries[existing->second].value = value;
+    }
+}
+
+optional<size_t> LinearLPMTable::lookup(const uint32_t address) const {
+    const Entry *best = nullptr;
+    for (const auto &entry : _entries) {
+        if (mask(address, entry.length) == entry.prefix and (best == nullptr or entry.length > best->length)) {
+            best = &entry;
+        }
+    }
+    if (best == nullptr) {
+        return {};
+    }
+    return best->value;
+}
+
+TrieLPMTable::NodeIndex TrieLPMTable::_add_node(const uint32_t prefix,
+                                                const uint8_t length,
+                                                const uint32_t value) {
+    _nodes.push_back({prefix, length, value, {NONE, NONE}});
+    return _nodes.size() - 1;
+}
+
+//! \details Walks down from the root while the nodes' prefixes are prefixes of the new one. Where the
+//! walk stops, the new prefix goes either at the node it reached, or as a new child, or above the child
+//! it diverges from (with a new node where they diverge, if that isn't the new prefix itself).
+void TrieLPMTable::insert(const uint32_t prefix, const uint8_t length, const size_t value) {
+    if (value >= MAX_VALUE) {
+        throw out_of_range("TrieLPMTable: value too large");
+    }
+    if (length > 32) {
+        throw out_of_range("TrieLPMTable: prefix longer than 32 bits");
+    }
+
+    const uint32_t masked = mask(prefix, length);
+
+    NodeIndex parent = 0;
+    while (_nodes[parent].length < length) {
+        const unsigned bit = _next_bit(masked, _nodes[parent].length);
+        const NodeIndex child = _nodes[parent].children[bit];
+        if (child == NONE) {
+            const NodeIndex leaf = _add_node(masked, length, value);
+            _nodes[parent].children[bit] = leaf;
+            return;
+        }
+
+        // length of the prefix shared by the child and the new prefix
+        const uint32_t difference = _nodes[child].prefix ^ masked;
+        const auto first_difference = static_cast<uint8_t>(difference == 0 ? 32 : __builtin_clz(difference));
+        const auto common = static_cast<uint8_t>(min<uint32_t>({first_difference, _nodes[child].length, length}));
+
+        if (common == _nodes[child].length) {
+            parent = child;  // the child's prefix is a prefix of the new one
+            continue;
+        }
+
+        // the new prefix (or where it diverges from the child's) goes between parent and child
+        const bool is_new = common == length;
+        const NodeIndex middle = _add_node(mask(masked, common), common, is_new ? uint32_t(value) : NO_VALUE);
+        _nodes[middle].children[_next_bit(_nodes[child].prefix, common)] = child;
+        if (not is_new) {
+            const NodeIndex leaf = _add_node(masked, length, value);
+            _nodes[middle].children[_next_bit(masked, common)] = leaf;
+        }
+        _nodes[parent].children[bit] = middle;
+        return;
+    }
+
+    _nodes[parent].value = uint32_t(value);  // the prefix is already a node
+}
+
+optional<size_t> TrieLPMTable::lookup(const uint32_t address) const {
+    const Node *node = &_nodes.front();
+    uint32_t best = node->value;
+    while (node->length < 32) {
+        const NodeIndex child = node->children[_next_bit(address, node->length)];
+        if (child == NONE) {
+            break;
+        }
+        node = &_nodes[child];
+        if (mask(address, node->length) != node->prefix) {
+            break;
+        }
+        if (node->value != NO_VALUE) {
+            best = node->value;
+        }
+    }
+    if (best == NO_VALUE) {
+        return {};
+    }
+    return best;
+}
+
+void TrieLPMTable::lookup_batch(const vector<uint32_t> &addresses, vector<optional<size_t>> &results) const {
+    results.resize(addresses.size());
+    for (size_t base = 0; base < addresses.size(); base += LANES) {
+        const size_t lanes = min(LANES, addresses.size() - base);
+
+        // each lane's next node to visit (already prefetched), or nullptr once its walk is over
+        array<const Node *, LANES> next{};
+        array<uint32_t, LANES> best{};
+        next.fill(&_nodes.front());
+        best.fill(NO_VALUE);
+
+        for (size_t active = lanes; active > 0;) {
+            active = 0;
+            for (size_t lane = 0; lane < lanes; lane++) {
+                const Node *node = next[lane];
+                if (node == nullptr) {
+                    continue;
+                }
+                next[lane] = nullptr;
+
+                const uint32_t address = addresses[base + lane];
+                if (mask(address, node->length) != node->prefix) {
+                    continue;
+                }
+                if (node->value != NO_VALUE) {
+                    best[lane] = node->value;
+                }
+                if (node->length == 32) {
+                    continue;
+                }
+                const NodeIndex child = node->children[_next_bit(address, node->length)];
+                if (child != NONE) {
+                    next[lane] = &_nodes[child];
+                    __builtin_prefetch(next[lane]);
+                    active++;
+                }
+            }
+        }
+
+        for (size_t lane = 0; lane < lanes; lane++) {
+            results[base + lane] = best[lane] == NO_VALUE ? nullopt : optional<size_t>{best[lane]};
+        }
+    }
+}
+
+//! \param[in] first is the first entry to fill
+//! \param[in] count is the number of entries
+//! \param[in] length is the length of the prefix being added
+//! \param[in] entry is the new (unextended) entry
+void Dir24_8LPMTable::_fill(uint32_t *first, const size_t count, const uint8_t length, const uint32_t entry) {
+    for (uint32_t *it = first; it != first + count; ++it) {
+        if ((*it >> LENGTH_SHIFT) <= length) {
+            *it = entry;
+        }
+    }
+}
+
+//! \details A prefix of up to 24 bits fills every first-level entry it covers, and every second-level
+//! entry in the groups they point to. A longer prefix fills part of one group, which is created (from
+//! the first-level entry it replaces) if needed.
+void Dir24_8LPMTable::insert(const uint32_t prefix, const uint8_t length, const size_t value) {
+    if (value >= MAX_VALUE) {
+        throw out_of_range("Dir24_8LPMTable: value too large");
+    }
+    if (length > 32) {
+        throw out_of_range("Dir24_8LPMTable: prefix longer than 32 bits");
+    }
+
+    const uint32_t masked = mask(prefix, length);
+    const uint32_t entry = (uint32_t{length} << LENGTH_SHIFT) | static_cast<uint32_t>(value + 1);
+
+    if (length <= 24) {
+        const size_t first = masked >> 8;
+        const size_t count = size_t{1} << (24 - length);
+        for (size_t i = first; i < first + count; i++) {
+            if (_tbl24[i] & EXTENDED) {
+                _fill(&_tbl8[size_t{_tbl24[i] & ~EXTENDED} << 8], 256, length, entry);
+            } else if ((_tbl24[i] >> LENGTH_SHIFT) <= length) {
+                _tbl24[i] = entry;
+            }
+        }
+        return;
+    }
+
+    uint32_t &slot = _tbl24[masked >> 8];
+    if (not(slot & EXTENDED)) {
+        const size_t group = _tbl8.size() >> 8;
+        _tbl8.resize(_tbl8.size() + 256, slot);
+        slot = EXTENDED | static_cast<uint32_t>(group);
+    }
+    _fill(&_tbl8[(size_t{slot & ~EXTENDED} << 8) | (masked & 0xff)], size_t{1} << (32 - length), length, entry);
+}
+
+optional<size_t> Dir24_8LPMTable::lookup(const uint32_t address) const {
+    uint32_t entry = _tbl24[address >> 8];
+    if (entry & EXTENDED) {
+        entry = _tbl8[_tbl8_index(entry, address)];
+    }
+    const uint32_t value = entry & VALUE_MASK;
+    if (value == 0) {
+        return {};
+    }
+    return value - 1;
+}
+
+void Dir24_8LPMTable::lookup_batch(const vector<uint32_t> &addresses, vector<optional<size_t>> &results) const {
+    results.resize(addresses.size());
+    for (size_t base = 0; base < addresses.size(); base += GROUP) {
+        const size_t count = min(GROUP, addresses.size() - base);
+
+        for (size_t i = 0; i < count; i++) {
+            __builtin_prefetch(&_tbl24[addresses[base + i] >> 8]);
+        }
+
+        // read the first-level entries, prefetching the second-level entries they point to
+        array<uint32_t, GROUP> entries{};
+        for (size_t i = 0; i < count; i++) {
+            entries[i] = _tbl24[addresses[base + i] >> 8];
+            if (entries[i] & EXTENDED) {
+                __builtin_prefetch(&_tbl8[_tbl8_index(entries[i], addresses[base + i])]);
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t entry = entries[i];
+            if (entry & EXTENDED) {
+                entry = _tbl8[_tbl8_index(entry, addresses[base + i])];
+            }
+            const uint32_t value = entry & VALUE_MASK;
+            results[base + i] = value == 0 ? nullopt : optional<size_t>{value - 1};
+        }
+    }
+}
@@ -0,0 +1,175 @@
+#ifndef SPONGE_LIBSPONGE_LPM_TABLE_HH
+#define SPONGE_LIBSPONGE_LPM_TABLE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! Longest-prefix-match algorithms for a Router's forwarding table
+enum class LPMAlgorithm {
+    Linear,  //!< Scan every prefix (LinearLPMTable)
+    Trie,    //!< Path-compressed binary trie (TrieLPMTable)
+    Dir24_8  //!< Two-level direct-indexed array (Dir24_8LPMTable)
+};
+
+//! \brief Interface for a table that maps IPv4 prefixes to values and finds the longest prefix that
+//! matches an address.
+
+//! Adding a prefix that is already in the table replaces its value. Lookups don't allocate.
+class LPMTable {
+  public:
+    virtual ~LPMTable() = default;
+
+    //! \brief Add a prefix, or replace its value
+    //! \param[in] prefix is the prefix; bits beyond `length` are ignored
+    //! \param[in] length is the number of high-order bits of `prefix` that an address must match (0 to 32)
+    //! \param[in] value is returned by lookup() for addresses that this is the longest matching prefix of
+    virtual void insert(const uint32_t prefix, const uint8_t length, const size_t value) = 0;
+
+    //! \returns the value of the longest prefix that matches `address`, or nothing if none does
+    virtual std::optional<size_t> lookup(const uint32_t address) const = 0;
+
+    //! \brief Look up many addresses at once
+    //! \param[in] addresses are the addresses to look up
+    //! \param[out] results receives what lookup() would return for each address, in the same order
+    virtual void lookup_batch(const std::vector<uint32_t> &addresses,
+                              std::vector<std::optional<size_t>> &results) const;
+
+    //! \returns a table implementing `algorithm`
+    static std::unique_ptr<LPMTable> make(const LPMAlgorithm algorithm);
+
+    //! \returns the high-order `length` bits of `address`, with the rest cleared
+    static uint32_t mask(const uint32_t address, const uint8_t length) {
+        return length == 0 ? 0 : address & (std::numeric_limits<uint32_t>::max() << (32 - length));
+    }
+};
+
+//! \brief Checks every prefix on each lookup
+class LinearLPMTable : public LPMTable {
+    //! A prefix and its value
+    struct Entry {
+        uint32_t prefix;  //!< The prefix, masked to its length
+        uint8_t length;   //!< Length of the prefix
+        size_t value;     //!< Value of the prefix
+    };
+
+    std::vector<Entry> _entries{};
+
+    //! Index in `_entries` of each prefix, keyed by (prefix << 8) | length
+    std::unordered_map<uint64_t, size_t> _index{};
+
+  public:
+    void insert(const uint32_t prefix, const uint8_t length, const size_t value) override;
+    std::optional<size_t> lookup(const uint32_t address) const override;
+};
+
+//! \brief A binary trie in which each node holds a prefix, and a chain of nodes with one child each is
+//! collapsed into its last node (a Patricia trie)
+
+//! A lookup visits at most 33 nodes (one for each prefix length), and usually far fewer. A node's
+//! prefix length and value share one 32-bit word, so that four nodes fit in a cache line; that leaves
+//! 26 bits for the value, which must be less than MAX_VALUE.
+class TrieLPMTable : public LPMTable {
+    //! Index of a node in `_nodes`
+    using NodeIndex = uint32_t;
+
+    //! Marks a missing child
+    static constexpr NodeIndex NONE = 0;
+
+    //! Bits of a node that hold the length of its prefix (0 to 32)
+    static constexpr unsigned LENGTH_BITS = 6;
+
+    //! Bits of a node that hold its value
+    static constexpr unsigned VALUE_BITS = 32 - LENGTH_BITS;
+
+    //! Marks a node whose prefix isn't in the table
+    static constexpr uint32_t NO_VALUE = (uint32_t{1} << VALUE_BITS) - 1;
+
+    //! A prefix, which is either in the table or where two subtries diverge
+    struct Node {
+        uint32_t prefix;                //!< The prefix, masked to its length
+        uint32_t length : LENGTH_BITS;  //!< Length of the prefix
+        uint32_t value : VALUE_BITS;    //!< Value, or NO_VALUE if this prefix isn't in the table
+        NodeIndex children[2];          //!< Subtries whose next bit after this prefix is 0 or 1 (or NONE)
+    };
+    static_assert(sizeof(Node) == 16, "TrieLPMTable::Node should be 16 bytes");
+
+    //! Every node; the root (the empty prefix) is first, so no node has it as a child
+    std::vector<Node> _nodes{{0, 0, NO_VALUE, {NONE, NONE}}};
+
+    //! \returns the bit of `address` just after the first `length` bits
+    static unsigned _next_bit(const uint32_t address, const uint32_t length) { return (address >> (31 - length)) & 1; }
+
+    //! Append a node to `_nodes`
+    //! \returns its index
+    NodeIndex _add_node(const uint32_t prefix, const uint8_t length, const uint32_t value);
+
+  public:
+    //! Values must be less than this
+    static constexpr size_t MAX_VALUE = NO_VALUE;
+
+    void insert(const uint32_t prefix, const uint8_t length, const size_t value) override;
+    std::optional<size_t> lookup(const uint32_t address) const override;
+
+    //! Walks the trie for up to LANES addresses in lockstep, prefetching each one's next node, so that
+    //! their cache misses overlap instead of following one another
+    void lookup_batch(const std::vector<uint32_t> &addresses,
+                      std::vector<std::optional<size_t>> &results) const override;
+
+    //! Addresses walked at once by lookup_batch()
+    static constexpr size_t LANES = 16;
+};
+
+//! \brief The DIR-24-8 scheme: an array indexed by the top 24 bits of an address, whose entries either
+//! hold the answer or point to a group of 256 entries indexed by the last 8 bits
+
+//! A lookup takes one or two memory accesses. The first-level array takes 64 MiB, so this is meant for
+//! large tables. Each entry records the length of the prefix it came from, so that a shorter prefix
+//! added later doesn't overwrite a longer one. Values must be less than MAX_VALUE.
+class Dir24_8LPMTable : public LPMTable {
+    //! Set in a first-level entry that points to a second-level group
+    static constexpr uint32_t EXTENDED = uint32_t{1} << 31;
+
+    //! Position of the prefix length in an entry
+    static constexpr unsigned LENGTH_SHIFT = 25;
+
+    //! Bits of an entry that hold the value plus one (zero means no prefix matches)
+    static constexpr uint32_t VALUE_MASK = (uint32_t{1} << LENGTH_SHIFT) - 1;
+
+    //! Entries for the first 24 bits
+    std::vector<uint32_t> _tbl24;
+
+    //! Groups of 256 entries for the last 8 bits, under prefixes longer than 24 bits
+    std::vector<uint32_t> _tbl8{};
+
+    //! \returns the index in `_tbl8` of the entry for `address`, whose first-level entry `entry` is EXTENDED
+    static size_t _tbl8_index(const uint32_t entry, const uint32_t address) {
+        return (size_t{entry & ~EXTENDED} << 8) | (address & 0xff);
+    }
+
+    //! Replace each of `count` entries from `first` that came from a prefix no longer than `length`
+    static void _fill(uint32_t *first, const size_t count, const uint8_t length, const uint32_t entry);
+
+  public:
+    //! Values must be less than this
+    static constexpr size_t MAX_VALUE = VALUE_MASK;
+
+    Dir24_8LPMTable() : _tbl24(size_t{1} << 24) {}
+
+    void insert(const uint32_t prefix, const uint8_t length, const size_t value) override;
+    std::optional<size_t> lookup(const uint32_t address) const override;
+
+    //! Prefetches the first-level entries of a group of addresses, then reads them and prefetches any
+    //! second-level entries they point to, before reading those
+    void lookup_batch(const std::vector<uint32_t> &addresses,
+                      std::vector<std::optional<size_t>> &results) const override;
+
+    //! Addresses prefetched at once by lookup_batch()
+    static constexpr size_t GROUP = 32;
+};
+
+#endif  // SPONGE_LIBSPONGE_LPM_TABLE_HH
@@ -1,6 +1,9 @@
 #include "router.hh"
 
+#include <atomic>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
 
 using namespace std;
 
@@ -29,58 +32,36 @@ void Router::add_route(const uint32_t route_prefix,
     cerr << "DEBUG: adding route " << Address::from_ipv4_numeric(route_prefix).ip() << "/" << int(prefix_length)
          << " => " << (next_hop.has_value() ? next_hop->ip() : "(direct)") << " on interface " << interface_num << "\n";
 
-    // The code is not strong yet, need to check whether this is a duplicate entry.
-    _route_table.emplace_back(route_prefix, prefix_length, next_hop, interface_num);
+    _prefixes->insert(route_prefix, prefix_length, _route_table.size());
+    _route_table.push_back({next_hop, interface_num});
 }
 
-std::string uint32_to_ip(uint32_t ip) {
-    return std::to_string((ip >> 24) & 0xFF) + "." + std::to_string((ip >> 16) & 0xFF) + "." +
-           std::to_string((ip >> 8) & 0xFF) + "." + std::to_string(ip & 0xFF);
-}
-
-//! \param[in] dgram The datagram to be routed
-void Router::route_one_datagram(InternetDatagram &dgram) {
-    ssize_t index = -1;
-    int8_t longest_prefix_length = -1;
-
-    if (_route_table.empty())
-        return;
-
+//! \param[in,out] dgram The datagram to be routed, whose TTL is decremented if it isn't dropped
+optional<size_t> Router::_find_route(InternetDatagram &dgram) const {
     // The router decrements the datagram’s TTL (time to live).
     // If the TTL was zero already, or hits zero after the decrement, the router should drop the datagram.
     if (dgram.header().ttl <= 1)
-        return;
-    dgram.header().ttl--;
-
-    const uint32_t dest_ip = dgram.header().dst;
-    // Search the routing table to find the route that not only match the datagram's destination address,
-    // but also has the biggest value of prefix length.
-    for (size_t i = 0; i < _route_table.size(); i++) {
-        const RouteEntry route_entry = _route_table[i];
-        uint8_t shift_cnt = 32 - route_entry.prefix_length;
-        // 这里存在一个特殊情况，当我们匹配默认路由0.0.0.0/0时，由于dest_ip>>32等价与dest_ip>>0，
-        // 右移32并不会将dest_ip变为0，因此我们需要判断这种特殊情况
-        if ((dest_ip >> shift_cnt) == (route_entry.route_prefix >> shift_cnt) or route_entry.prefix_length == 0) {
-            if (longest_prefix_length < route_entry.prefix_length) {  // Record the current longest prefix length
-                longest_prefix_length = route_entry.prefix_length;
-                index = i;
-            }
-        }
-    }
+        return {};
 
+    // Find the route with the longest prefix that matches the datagram's destination address.
     // If no routes matched, the router drops the datagram.
-    if (longest_prefix_length == -1) {
-        return;
+    const optional<size_t> index = _prefixes->lookup(dgram.header().dst);
+    if (index.has_value()) {
+        dgram.decrement_ttl();
     }
+    return index;
+}
 
-    RouteEntry route_entry = _route_table[index];
+//! \param[in] dgram The datagram to send
+//! \param[in] route The index of its route in `_route_table`
+void Router::_send(const InternetDatagram &dgram, const size_t route) {
+    const RouteEntry &route_entry = _route_table[route];
     // The next hop address is the datagram's destination address, if next_hop is empty.
-    Address next_hop(Address::from_ipv4_numeric(dgram.header().dst));
     if (route_entry.next_hop.has_value()) {
-        next_hop = route_entry.next_hop.value();
+        interface(route_entry.interface_num).send_datagram(dgram, route_entry.next_hop.value());
+    } else {
+        interface(route_entry.interface_num).send_datagram(dgram, Address::from_ipv4_numeric(dgram.header().dst));
     }
-
-    interface(route_entry.interface_num).send_datagram(dgram, next_hop);
 }
 
 void Router::route() {
@@ -88,8 +69,181 @@ void Router::route() {
     for (auto &interface : _interfaces) {
         auto &queue = interface.datagrams_out();
         while (not queue.empty()) {
-            route_one_datagram(queue.front());
-            queue.pop();
+            for (; not queue.empty() and _batch.size() < ROUTE_BATCH_SIZE; queue.pop()) {
+                _batch.push_back(move(queue.front()));
+            }
+            route_batch(_batch);
+        }
+    }
+}
+
+//! \param[in,out] datagrams The datagrams to be routed; the vector is left empty
+//! \details Looks up every destination with LPMTable::lookup_batch, then sends the datagrams one
+//! outbound interface at a time (in their original order within each interface), so that each
+//! interface's state stays in cache while it sends.
+void Router::route_batch(vector<InternetDatagram> &datagrams) {
+    _batch_destinations.clear();
+    for (const auto &dgram : datagrams) {
+        _batch_destinations.push_back(dgram.header().dst);
+    }
+    _prefixes->lookup_batch(_batch_destinations, _batch_routes);
+
+    // group the datagrams that have a route (and TTL to spare) by interface, with a counting sort
+    _batch_starts.assign(_interfaces.size() + 1, 0);
+    for (size_t i = 0; i < datagrams.size(); i++) {
+        if (datagrams[i].header().ttl <= 1 or not _batch_routes[i].has_value()) {
+            _batch_routes[i].reset();
+            continue;
+        }
+        const size_t interface_num = _route_table[_batch_routes[i].value()].interface_num;
+        if (interface_num >= _interfaces.size()) {
+            throw out_of_range("Router: route to a nonexistent interface");
+        }
+        _batch_starts[interface_num + 1]++;
+    }
+    for (size_t i = 1; i < _batch_starts.size(); i++) {
+        _batch_starts[i] += _batch_starts[i - 1];
+    }
+    _batch_order.resize(_batch_starts.back());
+    for (size_t i = 0; i < datagrams.size(); i++) {
+        if (_batch_routes[i].has_value()) {
+            _batch_order[_batch_starts[_route_table[_batch_routes[i].value()].interface_num]++] = i;
+        }
+    }
+
+    for (const size_t i : _batch_order) {
+        datagrams[i].decrement_ttl();
+        _send(datagrams[i], _batch_routes[i].value());
+    }
+    datagrams.clear();
+}
+
+//! \param[in] workers The number of threads to use; interface `i` is owned by worker `i % workers`
+//! \details Returns once every datagram that had been received has been routed. The first call (or the
+//! first with a different number of workers) starts the other workers' threads, and each later call
+//! just starts a new round, which every worker (including the caller) does its share of.
+//! \note Throws std::runtime_error if more than one worker would run in a build that counts Buffer
+//! references without atomic operations (`-DSPONGE_NONATOMIC_BUFFERS=ON`).
+void Router::route_parallel(const size_t workers) {
+    const size_t count = min(workers, _interfaces.size());
+    if (count <= 1) {
+        route();
+        return;
+    }
+
+#if defined(SPONGE_NONATOMIC_BUFFER_REFCOUNT)
+    // the workers pass datagrams (and so their Buffers) between threads, which needs atomic reference counts
+    throw runtime_error("Router::route_parallel: built with SPONGE_NONATOMIC_BUFFERS, so Buffers can't cross threads");
+#endif
+
+    if (count != _worker_count) {
+        _stop_workers();
+        _rings.clear();
+        for (size_t i = 0; i < count * count; i++) {
+            _rings.push_back(make_unique<SPSCRing<Forwarded>>(RING_CAPACITY));
+        }
+        _round = 0;
+        _finished.store(0);
+        _done.store(0);
+        _worker_count = count;
+        for (size_t self = 1; self < count; self++) {
+            _workers.emplace_back([this, self] { _worker_main(self); });
+        }
+    }
+
+    size_t round = 0;
+    {
+        const lock_guard<mutex> lock{_round_mutex};
+        round = ++_round;
+    }
+    _round_cv.notify_all();
+
+    _route_share(0, round);
+    while (_done.load(memory_order_acquire) < round * count) {
+        this_thread::yield();
+    }
+}
+
+//! \param[in] self The worker
+//! \param[in] round The round (numbered from 1) that the worker is doing its share of
+//! \details Each worker drains the rings coming to it whenever the ring it is filling is full, so workers
+//! can't wait on each other in a cycle; once every worker has finished its interfaces, each drains its
+//! rings one last time.
+void Router::_route_share(const size_t self, const size_t round) {
+    const size_t count = _worker_count;
+
+    // send the datagrams other workers have passed to this one
+    const auto drain = [&] {
+        bool drained = false;
+        for (size_t from = 0; from < count; from++) {
+            SPSCRing<Forwarded> &ring = *_rings[from * count + self];
+            for (auto item = ring.try_pop(); item.has_value(); item = ring.try_pop()) {
+                _send(item->dgram, item->route);
+                drained = true;
+            }
+        }
+        return drained;
+    };
+
+    for (size_t i = self; i < _interfaces.size(); i += count) {
+        auto &queue = _interfaces[i].datagrams_out();
+        for (; not queue.empty(); queue.pop()) {
+            const optional<size_t> route = _find_route(queue.front());
+            if (not route.has_value()) {
+                continue;
+            }
+
+            const size_t owner = _route_table[route.value()].interface_num % count;
+            if (owner == self) {
+                _send(queue.front(), route.value());
+                continue;
+            }
+
+            Forwarded item{move(queue.front()), route.value()};
+            while (not _rings[self * count + owner]->try_push(item)) {
+                if (not drain()) {
+                    this_thread::yield();
+                }
+            }
+        }
+    }
+
+    _finished.fetch_add(1, memory_order_release);
+    while (_finished.load(memory_order_acquire) < round * count) {
+        if (not drain()) {
+            this_thread::yield();
         }
     }
+    drain();
+    _done.fetch_add(1, memory_order_release);
+}
+
+//! \param[in] self The worker (at least 1; the caller of route_parallel() is worker 0)
+void Router::_worker_main(const size_t self) {
+    size_t round = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock{_round_mutex};
+            _round_cv.wait(lock, [&] { return _stopping or _round != round; });
+            if (_stopping) {
+                return;
+            }
+            round = _round;
+        }
+        _route_share(self, round);
+    }
+}
+
+void Router::_stop_workers() {
+    {
+        const lock_guard<mutex> lock{_round_mutex};
+        _stopping = true;
+    }
+    _round_cv.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+    _worker_count = 0;
+    _stopping = false;
 }
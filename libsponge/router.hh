@@ -1,10 +1,18 @@
 #ifndef SPONGE_LIBSPONGE_ROUTER_HH
 #define SPONGE_LIBSPONGE_ROUTER_HH
 
+#include "lpm_table.hh"
 #include "network_interface.hh"
+#include "spsc_ring.hh"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
+#include <thread>
+#include <vector>
 
 //! \brief A wrapper for NetworkInterface that makes the host-side
 //! interface asynchronous: instead of returning received datagrams
@@ -41,33 +49,80 @@ class AsyncNetworkInterface : public NetworkInterface {
 //! \brief A router that has multiple network interfaces and
 //! performs longest-prefix-match routing between them.
 class Router {
+    //! Where to send datagrams that match a route
     struct RouteEntry {
-        uint32_t route_prefix;
-        uint8_t prefix_length;
-        std::optional<Address> next_hop;
-        size_t interface_num;
-
-        RouteEntry(uint32_t _route_prefix,
-                   uint8_t _prefix_length,
-                   std::optional<Address> _next_hop,
-                   size_t _interface_num)
-            : route_prefix(_route_prefix)
-            , prefix_length(_prefix_length)
-            , next_hop(_next_hop)
-            , interface_num(_interface_num) {}
+        std::optional<Address> next_hop;  //!< Next hop, or empty if the network is directly attached
+        size_t interface_num;             //!< Interface to send on
     };
 
     //! The router's collection of network interfaces
     std::vector<AsyncNetworkInterface> _interfaces{};
 
+    //! Every route added, indexed by the values in `_prefixes`
     std::vector<RouteEntry> _route_table{};
 
-    //! Send a single datagram from the appropriate outbound interface to the next hop,
-    //! as specified by the route with the longest prefix_length that matches the
-    //! datagram's destination address.
-    void route_one_datagram(InternetDatagram &dgram);
+    //! Maps each route's prefix to its index in `_route_table`
+    std::unique_ptr<LPMTable> _prefixes;
+
+    //! A datagram on its way from the worker that received it to the worker that sends it
+    struct Forwarded {
+        InternetDatagram dgram{};  //!< The datagram, with its TTL already decremented
+        size_t route{};            //!< Index of its route in `_route_table`
+    };
+
+    //! Slots in each ring between route_parallel() workers
+    static constexpr size_t RING_CAPACITY = 256;
+
+    //! Rings between route_parallel() workers: `_rings[from * workers + to]`
+    std::vector<std::unique_ptr<SPSCRing<Forwarded>>> _rings{};
+
+    //! \name State of the route_parallel() worker threads
+    //!@{
+    std::vector<std::thread> _workers{};  //!< Workers 1 and up (the caller of route_parallel() is worker 0)
+    size_t _worker_count{0};              //!< Number of workers, including the caller, while any are running
+    std::mutex _round_mutex{};            //!< Guards `_round` and `_stopping`
+    std::condition_variable _round_cv{};  //!< Signalled when a round starts, or the workers should stop
+    size_t _round{0};                     //!< Number of rounds (calls to route_parallel()) started so far
+    bool _stopping{false};                //!< Should the workers exit?
+    std::atomic<size_t> _finished{0};     //!< Number of times a worker has finished its interfaces
+    std::atomic<size_t> _done{0};         //!< Number of times a worker has finished a round
+    //!@}
+
+    //! \name Scratch space for route_batch()
+    //!@{
+    std::vector<InternetDatagram> _batch{};              //!< Datagrams taken from a queue by route()
+    std::vector<uint32_t> _batch_destinations{};         //!< Destination of each datagram
+    std::vector<std::optional<size_t>> _batch_routes{};  //!< Route of each datagram
+    std::vector<size_t> _batch_starts{};                 //!< Start of each interface's run in `_batch_order`
+    std::vector<size_t> _batch_order{};                  //!< Datagrams to send, grouped by interface
+    //!@}
+
+    //! Decrement a datagram's TTL and find the route with the longest prefix that matches its destination
+    //! \returns the index of the route in `_route_table`, or nothing if the datagram should be dropped
+    std::optional<size_t> _find_route(InternetDatagram &dgram) const;
+
+    //! Send a datagram from the interface of a route to its next hop
+    void _send(const InternetDatagram &dgram, const size_t route);
+
+    //! Route the datagrams received by worker `self`'s interfaces in round `round` of route_parallel()
+    void _route_share(const size_t self, const size_t round);
+
+    //! Wait for each round of route_parallel() and do worker `self`'s share of it, until told to stop
+    void _worker_main(const size_t self);
+
+    //! Stop and join the route_parallel() worker threads, if any are running
+    void _stop_workers();
 
   public:
+    //! Construct a router that looks up routes with `algorithm`
+    explicit Router(const LPMAlgorithm algorithm = LPMAlgorithm::Trie) : _prefixes(LPMTable::make(algorithm)) {}
+
+    //! Stop the route_parallel() worker threads
+    ~Router() { _stop_workers(); }
+
+    Router(const Router &other) = delete;
+    Router &operator=(const Router &other) = delete;
+
     //! Add an interface to the router
     //! \param[in] interface an already-constructed network interface
     //! \returns The index of the interface after it has been added to the router
@@ -79,7 +134,7 @@ class Router {
     //! Access an interface by index
     AsyncNetworkInterface &interface(const size_t N) { return _interfaces.at(N); }
 
-    //! Add a route (a forwarding rule)
+    //! Add a route (a forwarding rule), replacing any earlier route for the same prefix
     void add_route(const uint32_t route_prefix,
                    const uint8_t prefix_length,
                    const std::optional<Address> next_hop,
@@ -87,6 +142,26 @@ class Router {
 
     //! Route packets between the interfaces
     void route();
+
+    //! Most datagrams that route() takes from a queue for each call to route_batch()
+    static constexpr size_t ROUTE_BATCH_SIZE = 64;
+
+    //! Route (and remove) every datagram in `datagrams`, looking up all their routes in one pass
+    void route_batch(std::vector<InternetDatagram> &datagrams);
+
+    //! Route packets between the interfaces, with `workers` threads (including the caller's)
+    //! \note The other threads are started by the first call, and kept (waiting) for later calls with
+    //! the same number of workers, until the router is destroyed.
+    void route_parallel(const size_t workers);
 };
 
+//! \class Router
+//! route_parallel() gives each worker thread a share of the interfaces. A worker reads the datagrams
+//! its interfaces have received, looks up their routes, and either sends each one itself or passes
+//! it through a lock-free ring to the worker that owns the outbound interface, so that every
+//! interface is only touched by one thread. The routes are only read while workers run (add_route()
+//! must not be called from another thread meanwhile), so lookups don't lock. The worker threads
+//! outlive each call: they wait on a condition variable for the next round, and are joined when the
+//! number of workers changes or the router is destroyed.
+
 #endif  // SPONGE_LIBSPONGE_ROUTER_HH
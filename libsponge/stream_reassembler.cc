@@ -1,6 +1,8 @@
 #include "stream_reassembler.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <string>
 
 // Dummy implementation of a stream reassembler.
@@ -15,58 +17,85 @@ void DUMMY_CODE(Targs &&.../* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity), _capacity(capacity), _buf(capacity) {}
+StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity), _capacity(capacity) {}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    size_t max_idx = _base_index + _capacity - _output.buffer_size();  // Index of the first unacceptable bytes
-    // Calculate the actual start and end index since the start and end index of data may exceed _base_index and max_idx
-    size_t seg_start_idx = std::max(index, _base_index);
-    size_t seg_end_idx = std::min(index + data.size(), max_idx);
-    size_t pos, i;
+    push_substring(Buffer::copy_of(data), index, eof);
+}
+
+//! \details Out-of-order data is kept as non-overlapping [start, end) slices in an ordered map,
+//! so a segment costs O(log n) to place, however many bytes it carries, and fully duplicate
+//! retransmissions are dropped without touching their payload.
+void StreamReassembler::push_substring(Buffer data, const uint64_t index, const bool eof) {
+    const uint64_t first_unassembled = _first_unassembled();
+    const uint64_t first_unacceptable = first_unassembled + _capacity - _output.buffer_size();
+    // Calculate the actual start and end index since the start and end index of data may exceed
+    // first_unassembled and first_unacceptable
+    uint64_t seg_start_idx = std::max(index, first_unassembled);
+    uint64_t seg_end_idx = std::min(index + data.size(), first_unacceptable);
 
     if (eof) {
         _eof_index = index + data.size();
     }
 
-    // Store data segment in _buf
-    for (i = seg_start_idx; i < seg_end_idx; i++) {
-        pos = i % _capacity;
-        if (_buf[pos].is_filled == false) {
-            _buf[pos].is_filled = true;
-            _buf[pos].byte_value = data[i - index];
-            ++_unassembled_bytes_cnt;
+    if (seg_start_idx < seg_end_idx) {
+        // Trim against the stored segment (if any) that begins before us and reaches into our range
+        auto it = _segments.upper_bound(seg_start_idx);
+        if (it != _segments.begin()) {
+            const auto prev = std::prev(it);
+            seg_start_idx = std::max(seg_start_idx, prev->first + prev->second.size());
         }
-    }
-
-    // Update _last_index to the last unassembled byte
-    if (_last_index < seg_end_idx)
-        _last_index = seg_end_idx;
 
-    // Write reassembled bytes to _output once the bytes with correct indexes have arrived
-    if (_base_index == seg_start_idx) {
-        string assembled_bytes;
-        for (i = _base_index; i < _last_index; i++) {
-            pos = i % _capacity;
-            if (_buf[pos].is_filled == false)
+        // Drop stored segments that we cover completely, and trim against one that sticks out past our end
+        while (it != _segments.end() && it->first < seg_end_idx) {
+            const uint64_t stored_end_idx = it->first + it->second.size();
+            if (stored_end_idx > seg_end_idx) {
+                seg_end_idx = it->first;
                 break;
-            assembled_bytes.push_back(_buf[pos].byte_value);
-            --_unassembled_bytes_cnt;
-            _buf[pos].is_filled = false;
-        };
-        _base_index = i;  // Update _base_index to the first unassembled byte
-        _output.write(assembled_bytes);
-        if (_base_index == _eof_index) {  // All bytes have been reassembled
-            _output.end_input();
+            }
+            _unassembled_bytes_cnt -= it->second.size();
+            it = _segments.erase(it);
+        }
+
+        if (seg_start_idx < seg_end_idx) {
+            data.remove_prefix(seg_start_idx - index);
+            data.remove_suffix(data.size() - (seg_end_idx - seg_start_idx));
+            _unassembled_bytes_cnt += data.size();
+            _segments.emplace_hint(it, seg_start_idx, std::move(data));
         }
     }
+
+    // Write reassembled bytes to _output once the bytes with correct indexes have arrived
+    while (!_segments.empty() && _segments.begin()->first == _first_unassembled()) {
+        auto first = _segments.begin();
+        _unassembled_bytes_cnt -= first->second.size();
+        _output.write(std::move(first->second));
+        _segments.erase(first);
+    }
+
+    if (_first_unassembled() == _eof_index) {  // All bytes have been reassembled
+        _output.end_input();
+    }
 }
 
 size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes_cnt; }
 
-bool StreamReassembler::empty() const { return _base_index == _last_index; }
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    for (const auto &[index, data] : _segments) {
+        if (not ranges.empty() and ranges.back().second == index) {
+            ranges.back().second += data.size();
+        } else {
+            ranges.emplace_back(index, index + data.size());
+        }
+    }
+    return ranges;
+}
+
+bool StreamReassembler::empty() const { return _segments.empty(); }
 
 // int main() {
 //     StreamReassembler reassembler(8);
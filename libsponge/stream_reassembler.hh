@@ -1,10 +1,13 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "buffer.hh"
 #include "byte_stream.hh"
 
 #include <cstdint>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
@@ -12,19 +15,18 @@
 class StreamReassembler {
   private:
     // Your code here -- add private members as necessary.
-    struct ByteState {
-        bool is_filled = false;
-        char byte_value = 0;
-    };
-
-    ByteStream _output;                 //!< The reassembled in-order byte stream
-    size_t _capacity;                   //!< The maximum number of bytes
-    std::vector<ByteState> _buf;        // _buf is a Circular Queue that is used to store
-    size_t _unassembled_bytes_cnt = 0;  // Number of unassembled bytes in _buf
-    size_t _base_index = 0;             // _base_index      is the index(sequence number) of first unassembled byte
-                                        // _base_index  - 1 is the index(sequence number) of the last unread byte
-    size_t _last_index = 0;             // _last_index  - 1 is the index(sequence number) of the last unassembled byte
-    size_t _eof_index = -1;             // _eof_index - 1 is the index of this last byte in this sequence
+    ByteStream _output;  //!< The reassembled in-order byte stream
+    size_t _capacity;    //!< The maximum number of bytes
+
+    // Out-of-order substrings, keyed by the index of their first byte.
+    // The stored ranges [index, index + size) never overlap, so each byte is held (and counted) only once.
+    // The Buffers share storage with the segments they came from; nothing is copied byte by byte.
+    std::map<uint64_t, Buffer> _segments{};
+    size_t _unassembled_bytes_cnt = 0;  // Number of bytes held in _segments
+    uint64_t _eof_index = -1;           // _eof_index - 1 is the index of this last byte in this sequence
+
+    //! Index of the first byte that hasn't been written to the output stream yet
+    uint64_t _first_unassembled() const { return _output.bytes_written(); }
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
@@ -42,6 +44,10 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer (no copy is made of the bytes that are kept).
+    //! \copydetails push_substring(const std::string &, const uint64_t, const bool)
+    void push_substring(Buffer data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -54,6 +60,10 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The ranges [first, last) of stream indices stored but not yet reassembled, in ascending order
+    //! \note Adjacent substrings are reported as a single range
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
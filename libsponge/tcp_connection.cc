@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -23,7 +25,8 @@ size_t TCPConnection::time_since_last_segment_received() const { return _timer.t
 void TCPConnection::segment_received(const TCPSegment &seg) {
     // cerr << "\n[conn] segment_received" << endl;
     // cerr << " ********** " + seg.header().to_string() << endl;
-    const TCPHeader header = seg.header();
+    const TCPHeader &header = seg.header();
+    const bool first_syn = header.syn && !_receiver.ackno().has_value();
 
     if (header.rst) {  // check if RST is received
         // cerr << "[segment_received]: RST received" << endl;
@@ -59,9 +62,37 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         _receiver.segment_received(seg);
     }
 
+    if (first_syn) {  // the options that only a SYN carries decide what this connection will use
+        _peer_syn_options = header.options;
+        size_t mss = min(_cfg.mss, size_t{header.options.mss.value_or(numeric_limits<uint16_t>::max())});
+        // the MSS doesn't count options (RFC 6691), so leave room for the most any later segment can carry
+        TCPOptions largest{};
+        if (_timestamps_enabled()) {
+            largest.timestamps = TCPTimestamps{};
+        }
+        if (_sack_enabled()) {
+            largest.sack_blocks.resize(TCPOptions::MAX_SACK_BLOCKS);
+        }
+        mss -= min(mss - 1, largest.length());
+        _sender.set_mss(mss);
+        _sender.set_sack(_sack_enabled());
+    }
+
     _timer.restart();
     if (header.ack) {  // 除了最初的第一次TCP握手报文，其他报文都会有ack都为true
-        _sender.ack_received(header.ackno, header.win);
+        const bool carries_data = seg.length_in_sequence_space() != 0;
+        // the window field of a SYN is never scaled (RFC 7323 section 2.2)
+        size_t window = header.win;
+        if (!header.syn && _window_scale_enabled()) {
+            window <<= _peer_syn_options.window_scale.value();
+        }
+        const vector<TCPSACKBlock> no_sack_blocks{};
+        const vector<TCPSACKBlock> &sack_blocks = _sack_enabled() ? header.options.sack_blocks : no_sack_blocks;
+        optional<uint32_t> timestamp_echo{};
+        if (_timestamps_enabled() && header.options.timestamps.has_value()) {
+            timestamp_echo = header.options.timestamps.value().echo;
+        }
+        _sender.ack_received(header.ackno, window, carries_data, sack_blocks, timestamp_echo);
     } else if (header.syn) {  // 作为接受方接受到SYN（也就是说，我们充当tcp连接的server）
         bool syn_sent_but_not_yet_received =
             _sender.next_seqno_absolute() != 0 && _sender.next_seqno_absolute() == _sender.bytes_in_flight();
@@ -93,10 +124,7 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     }
 }
 
-bool TCPConnection::active() const {
-    if (_is_rst_received_or_sent)
-        return false;
-
+bool TCPConnection::_streams_finished() const {
     // Prereq #1 The inbound stream has been fully assembled and has ended.
     bool inbound_ended = _receiver.stream_out().eof();
     // Prereq #2 The outbound stream has been ended by the local application and fully sent (including the fact that it
@@ -106,7 +134,14 @@ bool TCPConnection::active() const {
     // Prereq #3 The outbound stream has been fully acknowledged by the remote peer.
     bool outbound_fin_acked = outbound_fin_sent && bytes_in_flight() == 0;
 
-    if (inbound_ended && outbound_fin_sent && outbound_fin_acked) {  // Check if Prerequisites #1 through #3 are true
+    return inbound_ended && outbound_fin_sent && outbound_fin_acked;
+}
+
+bool TCPConnection::active() const {
+    if (_is_rst_received_or_sent)
+        return false;
+
+    if (_streams_finished()) {  // Check if Prerequisites #1 through #3 are true
         if (_linger_after_streams_finish) {
             // 由于是我们主动关闭连接，因此需要判断我们是否等待了足够多时间，即是否满足 Prereq #4的Option A
             return time_since_last_segment_received() < 10 * _cfg.rt_timeout;
@@ -131,6 +166,13 @@ size_t TCPConnection::write(const string &data) {
     return nwritten;
 }
 
+size_t TCPConnection::write(Buffer data) {
+    const size_t nwritten = _sender.stream_in().write(std::move(data));
+    _sender.fill_window();
+    _send_all_segments();
+    return nwritten;
+}
+
 void TCPConnection::_send_rst_segment() {
     TCPSegment rst_segment;
 
@@ -159,6 +201,7 @@ void TCPConnection::_send_all_segments() {
         // cerr << "[conn] send_all_segments resend SYN start" << endl;
         seg = _sender.segments_out().front();
         _sender.segments_out().pop();
+        _set_options(seg.header());
         _segments_out.push(std::move(seg));
         // cerr << "[conn] send_all_segments resend SYN end" << endl;
         return;
@@ -169,13 +212,54 @@ void TCPConnection::_send_all_segments() {
         seg = _sender.segments_out().front();
         seg.header().ack = true;  // 除TCP握手的第一个报文和RST外，所有其他报文的ACk都为true
         seg.header().ackno = _receiver.ackno().value();
-        seg.header().win = _receiver.window_size();
+        seg.header().win = _window_field(seg.header().syn);
+        _set_options(seg.header());
         _sender.segments_out().pop();
         _segments_out.push(seg);
         // cerr << "[conn] send_all_segments in while loop end" << endl;
     }
 }
 
+//! \details The smallest shift that lets the whole receive capacity be advertised
+uint8_t TCPConnection::_receive_window_scale() const {
+    uint8_t shift = 0;
+    while (shift < TCPOptions::MAX_WINDOW_SCALE && (_cfg.recv_capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        shift++;
+    }
+    return shift;
+}
+
+//! \param[in] syn whether the segment is a SYN, whose window is never scaled
+//! \returns the receive window, scaled down if window scaling is in use and capped at what the field can hold
+uint16_t TCPConnection::_window_field(const bool syn) const {
+    const uint8_t shift = (!syn && _window_scale_enabled()) ? _receive_window_scale() : 0;
+    return min(_receiver.window_size() >> shift, size_t{numeric_limits<uint16_t>::max()});
+}
+
+//! \details Our SYN announces our MSS and offers whichever of window scaling, SACK and timestamps are
+//! configured. When answering the peer's SYN, we offer an option only if the peer did too (RFC 7323,
+//! RFC 2018). Once both have, every segment carries timestamps, and every ack carries SACK blocks for
+//! the out-of-order data.
+void TCPConnection::_set_options(TCPHeader &header) const {
+    TCPOptions &options = header.options;
+    const bool our_syn = header.syn && !_receiver.ackno().has_value();
+
+    if (header.syn) {
+        options.mss = min(_cfg.mss, size_t{numeric_limits<uint16_t>::max()});
+        if (_cfg.window_scale && (our_syn || _peer_syn_options.window_scale.has_value())) {
+            options.window_scale = _receive_window_scale();
+        }
+        options.sack_permitted = _cfg.sack && (our_syn || _peer_syn_options.sack_permitted);
+    }
+    if (_timestamps_enabled() || (our_syn && _cfg.timestamps)) {
+        options.timestamps = TCPTimestamps{_sender.timestamp(), _receiver.timestamp_echo().value_or(0)};
+    }
+    if (header.ack && _sack_enabled()) {
+        options.sack_blocks = _receiver.sack_blocks();
+    }
+    header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     // cerr << "[conn] tick " << ms_since_last_tick << endl;
@@ -191,6 +275,30 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     }
 }
 
+optional<size_t> TCPConnection::time_until_next_timeout() const {
+    if (!active()) {
+        return {};
+    }
+
+    optional<size_t> timeout = _sender.time_until_timeout();
+    if (_linger_after_streams_finish && _streams_finished()) {
+        // active() turns false once the connection has lingered this long without hearing from the peer
+        const size_t linger_remaining = 10 * _cfg.rt_timeout - time_since_last_segment_received();
+        timeout = min(timeout.value_or(linger_remaining), linger_remaining);
+    }
+    return timeout;
+}
+
+void TCPConnection::abort() {
+    if (!active()) {
+        return;
+    }
+    _send_rst_segment();
+    _is_rst_received_or_sent = true;
+    _sender.stream_in().set_error();
+    _receiver.stream_out().set_error();
+}
+
 void TCPConnection::end_input_stream() {
     // cerr << "[conn] end_input_stream" << endl;
     _sender.stream_in().end_input();
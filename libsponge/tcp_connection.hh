@@ -13,7 +13,7 @@ class TCPConnection {
   private:
     TCPConfig _cfg;
     TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
@@ -30,10 +30,29 @@ class TCPConnection {
 
     bool _is_server{true};  // indicates that TCPConnection act as server
 
+    TCPOptions _peer_syn_options{};  // the options of the peer's SYN
+
+    //! Have both ends agreed to use SACK?
+    bool _sack_enabled() const { return _cfg.sack && _peer_syn_options.sack_permitted; }
+
+    //! Have both ends agreed to scale their windows?
+    bool _window_scale_enabled() const { return _cfg.window_scale && _peer_syn_options.window_scale.has_value(); }
+
+    //! Have both ends agreed to send timestamps?
+    bool _timestamps_enabled() const { return _cfg.timestamps && _peer_syn_options.timestamps.has_value(); }
+
+    uint8_t _receive_window_scale() const;  // The shift we ask the peer to apply to our window field
+
+    uint16_t _window_field(const bool syn) const;  // The receive window as advertised in the header
+
+    void _set_options(TCPHeader &header) const;  // Fill in the TCP options of an outbound segment
+
     void _send_rst_segment();  // Send a segment that contain RST flag
 
     void _send_all_segments();  // Send all available segment
 
+    bool _streams_finished() const;  // Have both streams ended, and ours been fully acknowledged?
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -45,6 +64,10 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write a Buffer to the outbound byte stream without copying it
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(Buffer data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
@@ -72,6 +95,15 @@ class TCPConnection {
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
 
+    //! \name Accessors for monitoring
+    //!@{
+
+    //! \brief Smoothed round-trip time in milliseconds, if the RTO is adaptive and a sample has been taken
+    std::optional<unsigned int> smoothed_rtt() const { return _sender.smoothed_rtt(); }
+    //! \brief Current retransmission timeout in milliseconds, including any backoff
+    unsigned int retransmission_timeout() const { return _sender.retransmission_timeout(); }
+    //!@}
+
     //! \name Methods for the owner or operating system to call
     //!@{
 
@@ -81,6 +113,13 @@ class TCPConnection {
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Milliseconds until tick() next has work to do (a retransmission, or the end of lingering)
+    //! \returns nothing if no timer is running, in which case only a segment or a write needs attention
+    std::optional<size_t> time_until_next_timeout() const;
+
+    //! \brief Abort the connection: send a RST and put both streams in the error state
+    void abort();
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
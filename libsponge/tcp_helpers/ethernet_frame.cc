@@ -17,8 +17,11 @@ ParseResult EthernetFrame::parse(const Buffer buffer) {
 }
 
 BufferList EthernetFrame::serialize() const {
+    Headroom headroom;
+    _header.serialize(headroom);
+
     BufferList ret;
-    ret.append(_header.serialize());
+    ret.append(headroom.to_buffer());
     ret.append(_payload);
     return ret;
 }
@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -28,24 +29,22 @@ ParseResult EthernetHeader::parse(NetParser &p) {
     return p.get_error();
 }
 
-string EthernetHeader::serialize() const {
-    string ret;
-    ret.reserve(LENGTH);
-
-    /* write destination address */
-    for (auto &byte : dst) {
-        NetUnparser::u8(ret, byte);
-    }
+//! \param[in,out] headroom receives the header, ahead of what it already holds
+void EthernetHeader::serialize(Headroom &headroom) const {
+    char *out = headroom.prepend(LENGTH);
 
-    /* write source address */
-    for (auto &byte : src) {
-        NetUnparser::u8(ret, byte);
-    }
+    /* write destination and source addresses */
+    memcpy(out, dst.data(), dst.size());
+    memcpy(out + dst.size(), src.data(), src.size());
 
     /* write the frame's type (e.g. IPv4, ARP or something else) */
-    NetUnparser::u16(ret, type);
+    write_big_endian(out + 12, type);
+}
 
-    return ret;
+string EthernetHeader::serialize() const {
+    Headroom headroom;
+    serialize(headroom);
+    return string(headroom.str());
 }
 
 //! \returns A string with a textual representation of an Ethernet address
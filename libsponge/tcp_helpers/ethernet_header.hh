@@ -4,6 +4,7 @@
 #include "parser.hh"
 
 #include <array>
+#include <cstring>
 
 //! Helper type for an Ethernet address (an array of six bytes)
 using EthernetAddress = std::array<uint8_t, 6>;
@@ -33,6 +34,9 @@ struct EthernetHeader {
     //! Serialize the Ethernet fields to a string
     std::string serialize() const;
 
+    //! Serialize the Ethernet fields into `headroom`, without allocating
+    void serialize(Headroom &headroom) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 };
@@ -40,4 +44,29 @@ struct EthernetHeader {
 //! \struct EthernetHeader
 //! This struct can be used to parse an existing Ethernet header or to create a new one.
 
+//! \brief Read-only view of an Ethernet header in place in a Buffer
+//! \details Reads the same fields as EthernetHeader::parse, but only when they're asked for.
+class EthernetHeaderView : public HeaderView {
+    //! \returns the Ethernet address at `offset`
+    EthernetAddress _address(const size_t offset) const {
+        EthernetAddress address;
+        std::memcpy(address.data(), _data(offset), address.size());
+        return address;
+    }
+
+  public:
+    //! View the header at the start of `buffer`
+    explicit EthernetHeaderView(Buffer buffer) : HeaderView(std::move(buffer), EthernetHeader::LENGTH) {}
+
+    //! \name Ethernet header fields
+    //!@{
+    EthernetAddress dst() const { return _address(0); }     //!< destination address
+    EthernetAddress src() const { return _address(6); }     //!< source address
+    uint16_t type() const { return _field<uint16_t>(12); }  //!< type of the payload
+    //!@}
+
+    //! \returns what follows the header, i.e., the payload
+    Buffer payload() const { return _after(EthernetHeader::LENGTH); }
+};
+
 #endif  // SPONGE_LIBSPONGE_ETHERNET_HEADER_HH
@@ -1,6 +1,8 @@
 #include "fd_adapter.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <stdexcept>
 #include <utility>
 
@@ -18,24 +20,94 @@ using namespace std;
 //! `_listen` flag and calls calls connect() on the underlying UDP socket, with
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
+//! \details Datagrams are read as by read_batch(), and any segments beyond the first are returned by the
+//! next calls.
 optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
-    auto datagram = _sock.recv();
+    if (_next_unread == _unread.size()) {
+        _unread.clear();
+        _next_unread = 0;
+        _read_waiting(_unread);
+    }
+    if (_next_unread == _unread.size()) {
+        return {};
+    }
+    return move(_unread[_next_unread++]);
+}
+
+//! \param[out] segments receives the segments, as read() would return them
+//! \details Reads up to BATCH_SIZE datagrams with one call to UDPSocket::recv_batch.
+void TCPOverUDPSocketAdapter::read_batch(vector<TCPSegment> &segments) {
+    if (_next_unread < _unread.size()) {
+        move(_unread.begin() + _next_unread, _unread.end(), back_inserter(segments));
+        _unread.clear();
+        _next_unread = 0;
+        return;
+    }
+    _read_waiting(segments);
+}
+
+//! \param[out] segments receives the segments
+//! \details The payloads are received into pooled slabs, which the segments share rather than copy.
+void TCPOverUDPSocketAdapter::_read_waiting(vector<TCPSegment> &segments) {
+    if (_offloading()) {
+        _read_coalesced(segments);
+        return;
+    }
+
+    // a UDP payload is no bigger than the MTU, so with one configured, slabs that fit it are kept instead
+    constexpr size_t MAX_DATAGRAM = 65536;
+    const size_t slab_size = min(max(UDPSocket::RecvBatch::DEFAULT_SLAB_SIZE, config().mtu.value_or(0)), MAX_DATAGRAM);
+    if (_recv_batch.slab_size() != slab_size) {
+        _recv_batch = UDPSocket::RecvBatch{BATCH_SIZE, MAX_DATAGRAM, slab_size};
+    }
+
+    _sock.recv_batch(_recv_batch);
+    for (size_t i = 0; i < _recv_batch.size(); i++) {
+        auto seg = _accept(_recv_batch.source_address(i), _recv_batch.payload(i));
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+    }
+}
+
+bool TCPOverUDPSocketAdapter::_offloading() {
+    if (config().udp_offload and not _gro_enabled) {
+        _sock.enable_gro();
+        _gro_enabled = true;
+    }
+    return _gro_enabled;
+}
+
+//! \param[out] segments receives the segments, as read() would return them
+void TCPOverUDPSocketAdapter::_read_coalesced(vector<TCPSegment> &segments) {
+    _sock.recv_coalesced(_coalesced);
+    for (auto &payload : _coalesced.payloads) {
+        auto seg = _accept(_coalesced.source_address, move(payload));
+        if (seg.has_value()) {
+            segments.push_back(move(seg.value()));
+        }
+    }
+}
 
+//! \param[in] source is the sender of the UDP datagram
+//! \param[in] payload is the UDP payload
+//! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
+optional<TCPSegment> TCPOverUDPSocketAdapter::_accept(const Address &source, Buffer payload) {
     // is it for us?
-    if (not listening() and (datagram.source_address != config().destination)) {
+    if (not listening() and (source != config().destination)) {
         return {};
     }
 
     // is the payload a valid TCP segment?
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(move(payload), 0)) {
         return {};
     }
 
     // should we target this source in all future replies?
     if (listening()) {
         if (seg.header().syn and not seg.header().rst) {
-            config_mutable().destination = datagram.source_address;
+            config_mutable().destination = source;
             set_listening(false);
         } else {
             return {};
@@ -45,12 +117,77 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
     return seg;
 }
 
+//! \param[in,out] seg is the TCP segment to serialize, whose ports are set from the configuration
+//! \param[out] headroom receives the TCP header, and must outlive the returned views
+BufferViewList TCPOverUDPSocketAdapter::_serialize(TCPSegment &seg, Headroom &headroom) const {
+    seg.header().sport = config().source.port();
+    seg.header().dport = config().destination.port();
+
+    headroom.clear();
+    seg.serialize(headroom, 0);
+    BufferViewList ret{seg.payload().str()};
+    ret.prepend(headroom.str());
+    return ret;
+}
+
+//! \param[in,out] segments are the TCP segments to serialize, which are popped
+//! \param[in] count is the most segments to take
+void TCPOverUDPSocketAdapter::_serialize_batch(queue<TCPSegment> &segments, const size_t count) {
+    _sending.clear();
+    while (not segments.empty() and _sending.size() < count) {
+        _sending.push_back(move(segments.front()));
+        segments.pop();
+    }
+
+    if (_headrooms.size() < _sending.size()) {
+        _headrooms.resize(_sending.size());
+    }
+    _datagrams.clear();
+    for (size_t i = 0; i < _sending.size(); i++) {
+        _datagrams.push_back(_serialize(_sending[i], _headrooms[i]));
+    }
+}
+
 //! Serialize a TCP segment and send it as the payload of a UDP datagram.
 //! \param[in] seg is the TCP segment to write
+//! \details The header is serialized on the stack and sent ahead of the payload, which isn't copied.
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    Headroom headroom;
+    _sock.sendto(config().destination, _serialize(seg, headroom));
+}
+
+//! \param[in,out] segments are the TCP segments to write, which are popped as they are sent
+//! \details Sends up to BATCH_SIZE datagrams with each call to UDPSocket::send_batch, or with offload,
+//! each run of equal-sized segments (plus a shorter one to finish it) with one UDPSocket::send_segmented.
+//! Headers are serialized into reused space, and sent ahead of the payloads, which aren't copied.
+void TCPOverUDPSocketAdapter::write_batch(queue<TCPSegment> &segments) {
+    if (config().udp_offload) {
+        _serialize_batch(segments, segments.size());
+
+        for (size_t first = 0; first < _datagrams.size();) {
+            const size_t segment_size = _datagrams[first].size();
+            BufferViewList run = _datagrams[first];
+            size_t run_size = segment_size;
+            size_t end = first + 1;
+            while (end < _datagrams.size() and end - first < UDPSocket::MAX_GSO_SEGMENTS and
+                   _datagrams[end - 1].size() == segment_size and _datagrams[end].size() <= segment_size and
+                   run_size + _datagrams[end].size() <= UDPSocket::MAX_GSO_PAYLOAD) {
+                run.append(_datagrams[end]);
+                run_size += _datagrams[end].size();
+                end++;
+            }
+            _sock.send_segmented(config().destination, run, segment_size);
+            first = end;
+        }
+        _sending.clear();
+        return;
+    }
+
+    while (not segments.empty()) {
+        _serialize_batch(segments, BATCH_SIZE);
+        _sock.send_batch(config().destination, _datagrams);
+    }
+    _sending.clear();
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
@@ -2,14 +2,18 @@
 #define SPONGE_LIBSPONGE_FD_ADAPTER_HH
 
 #include "file_descriptor.hh"
+#include "ipv4_header.hh"
 #include "lossy_fd_adapter.hh"
+#include "parser.hh"
 #include "socket.hh"
 #include "tcp_config.hh"
 #include "tcp_header.hh"
 #include "tcp_segment.hh"
 
 #include <optional>
+#include <queue>
 #include <utility>
+#include <vector>
 
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
@@ -44,9 +48,58 @@ class FdAdapterBase {
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
 class TCPOverUDPSocketAdapter : public FdAdapterBase {
+  public:
+    //! Bytes of IPv4, UDP and TCP headers (without options) around each TCP payload
+    static constexpr size_t HEADERS_LENGTH = IPv4Header::LENGTH + 8 + TCPHeader::LENGTH;
+
+    //! Most datagrams read by one call to read_batch()
+    static constexpr size_t BATCH_SIZE = 16;
+
   private:
     UDPSocket _sock;
 
+    //! Buffers for read_batch()
+    UDPSocket::RecvBatch _recv_batch{BATCH_SIZE};
+
+    //! Buffers for reads with offload
+    UDPSocket::coalesced_datagrams _coalesced{{"0", 0}, {}};
+
+    //! Has GRO been enabled on the socket?
+    bool _gro_enabled{false};
+
+    //! Segments read together, of which read() has returned the first `_next_unread`
+    std::vector<TCPSegment> _unread{};
+    size_t _next_unread{0};
+
+    //! Parse a UDP payload from `source`, and check that it's related to the current connection
+    std::optional<TCPSegment> _accept(const Address &source, Buffer payload);
+
+    //! Enable GRO on the socket if the configuration asks for offload
+    //! \returns whether a read may return coalesced datagrams
+    bool _offloading();
+
+    //! Read the datagrams that are waiting (at least one), appending the related TCP segments to `segments`
+    void _read_waiting(std::vector<TCPSegment> &segments);
+
+    //! Read the datagrams that arrived together, appending the related TCP segments to `segments`
+    void _read_coalesced(std::vector<TCPSegment> &segments);
+
+    //! Segments being sent by write_batch(), whose payloads the datagrams point into
+    std::vector<TCPSegment> _sending{};
+
+    //! Space for the headers of the segments in `_sending`
+    std::vector<Headroom> _headrooms{};
+
+    //! The UDP payloads sent by write_batch()
+    std::vector<BufferViewList> _datagrams{};
+
+    //! Set the ports of a TCP segment and serialize its header into `headroom`
+    //! \returns the UDP payload: the header in `headroom`, followed by the segment's payload
+    BufferViewList _serialize(TCPSegment &seg, Headroom &headroom) const;
+
+    //! Move up to `count` segments from `segments` into `_sending`, and serialize them into `_datagrams`
+    void _serialize_batch(std::queue<TCPSegment> &segments, const size_t count);
+
   public:
     //! Construct from a UDPSocket sliced into a FileDescriptor
     explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
@@ -54,9 +107,16 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
 
+    //! Reads the UDP datagrams that are waiting (at least one), appending the TCP segments related
+    //! to the current connection to `segments`
+    void read_batch(std::vector<TCPSegment> &segments);
+
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
+    //! Writes every TCP segment in `segments` (emptying it), each into a UDP payload
+    void write_batch(std::queue<TCPSegment> &segments);
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
@@ -64,6 +124,11 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     operator const UDPSocket &() const { return _sock; }
 };
 
+//! \class TCPOverUDPSocketAdapter
+//! With FdAdapterConfig::udp_offload set, write_batch() sends each run of equal-sized segments with one
+//! UDPSocket::send_segmented, and reads use UDPSocket::recv_coalesced, splitting what arrives back into
+//! segments without copying. Either end can use offload without the other.
+
 //! Typedef for TCPOverUDPSocketAdapter
 using LossyTCPOverUDPSocketAdapter = LossyFdAdapter<TCPOverUDPSocketAdapter>;
 
@@ -3,6 +3,7 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <cstring>
 #include <stdexcept>
 #include <string>
 
@@ -10,32 +11,83 @@ using namespace std;
 
 ParseResult IPv4Datagram::parse(const Buffer buffer) {
     NetParser p{buffer};
-    _header.parse(p);
+    const ParseResult header_result = _header.parse(p);
     _payload = p.buffer();
+    _serialized_header = {};
 
     if (_payload.size() != _header.payload_length()) {
         return ParseResult::PacketTooShort;
     }
+    if (p.error()) {
+        return p.get_error();
+    }
 
-    return p.get_error();
+    // keep a view of the header's bytes for serialize() to reuse, unless they're bad (e.g., a wrong checksum)
+    if (header_result == ParseResult::NoError) {
+        _serialized_header = buffer;
+        _serialized_header.remove_suffix(_payload.size());
+        _serialized_fields = _header;
+    }
+    return ParseResult::NoError;
 }
 
+//! \details If the header hasn't changed since it was parsed (other than by decrement_ttl()), its
+//! original bytes are reused, so a forwarded datagram is neither re-serialized nor re-checksummed.
 BufferList IPv4Datagram::serialize() const {
     if (_payload.size() != _header.payload_length()) {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
-    IPv4Header header_out = _header;
-    header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
-
-    // calculate checksum -- taken over header only
-    InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
-
     BufferList ret;
-    ret.append(header_out.serialize());
+    if (_serialized_header_valid()) {
+        ret.append(_serialized_header);
+    } else {
+        Headroom headroom;
+        serialize(headroom);
+        ret.append(headroom.to_buffer());
+    }
     ret.append(_payload);
     return ret;
 }
+
+//! \param[in,out] headroom receives the header, ahead of what it already holds
+void IPv4Datagram::serialize(Headroom &headroom) const {
+    if (_serialized_header_valid()) {
+        const string_view header_bytes = _serialized_header.str();
+        memcpy(headroom.prepend(header_bytes.size()), header_bytes.data(), header_bytes.size());
+        return;
+    }
+
+    // calculate checksum -- taken over header only
+    IPv4Header header_out = _header;
+    header_out.cksum = header_out.compute_cksum();
+    header_out.serialize(headroom);
+}
+
+//! \details Applies [RFC 1624](\ref rfc::rfc1624)'s incremental update, HC' = ~(~HC + ~m + m'), to the
+//! 16-bit word holding the TTL and protocol. If the header's bytes are being reused, they are patched
+//! the same way (in a copy of just the header, since the original may be shared), so the datagram
+//! still serializes without touching the rest of the header or the payload.
+void IPv4Datagram::decrement_ttl() {
+    const bool patch_serialized = _serialized_header_valid();
+
+    const uint16_t old_word = (_header.ttl << 8) | _header.proto;
+    _header.ttl--;
+    const uint16_t new_word = (_header.ttl << 8) | _header.proto;
+
+    uint32_t sum = uint16_t(~_header.cksum) + uint16_t(~old_word) + new_word;
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    _header.cksum = ~sum;
+
+    if (patch_serialized) {
+        const string_view original = _serialized_header.str();
+        Headroom headroom;
+        char *header_bytes = headroom.prepend(original.size());
+        memcpy(header_bytes, original.data(), original.size());
+        header_bytes[8] = static_cast<char>(_header.ttl);
+        write_big_endian(header_bytes + 10, _header.cksum);
+        _serialized_header = headroom.to_buffer();
+        _serialized_fields = _header;
+    }
+}
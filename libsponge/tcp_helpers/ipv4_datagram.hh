@@ -10,6 +10,15 @@ class IPv4Datagram {
     IPv4Header _header{};
     BufferList _payload{};
 
+    //! \name The header as it was parsed (or last patched by decrement_ttl()), reused by serialize()
+    //!@{
+    Buffer _serialized_header{};       //!< Wire bytes of the header, or empty if there are none
+    IPv4Header _serialized_fields{};  //!< What `_header` held when `_serialized_header` was made
+    //!@}
+
+    //! \returns `true` if `_serialized_header` still matches `_header`
+    bool _serialized_header_valid() const { return _serialized_header.size() > 0 and _header == _serialized_fields; }
+
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer);
@@ -17,6 +26,12 @@ class IPv4Datagram {
     //! \brief Serialize the segment to a string
     BufferList serialize() const;
 
+    //! \brief Serialize the header, with its checksum, into `headroom` (the payload is sent after it)
+    void serialize(Headroom &headroom) const;
+
+    //! \brief Decrement the TTL and update the checksum to match, without recomputing it
+    void decrement_ttl();
+
     //! \name Accessors
     //!@{
     const IPv4Header &header() const { return _header; }
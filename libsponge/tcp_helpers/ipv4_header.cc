@@ -3,6 +3,7 @@
 #include "util.hh"
 
 #include <arpa/inet.h>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 
@@ -74,8 +75,9 @@ ParseResult IPv4Header::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the IPv4Header to a string (does not recompute the checksum)
-string IPv4Header::serialize() const {
+//! Serialize the IPv4Header into headroom (does not recompute the checksum)
+//! \param[in,out] headroom receives the header, ahead of what it already holds
+void IPv4Header::serialize(Headroom &headroom) const {
     // sanity checks
     if (ver != 4) {
         throw runtime_error("wrong IP version");
@@ -84,33 +86,51 @@ string IPv4Header::serialize() const {
         throw runtime_error("IP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * hlen);
+    char *out = headroom.prepend(4 * hlen);
 
     const uint8_t first_byte = (ver << 4) | (hlen & 0xf);
-    NetUnparser::u8(ret, first_byte);  // version and header length
-    NetUnparser::u8(ret, tos);         // type of service
-    NetUnparser::u16(ret, len);        // length
-    NetUnparser::u16(ret, id);         // id
+    write_big_endian(out, first_byte);  // version and header length
+    write_big_endian(out + 1, tos);     // type of service
+    write_big_endian(out + 2, len);     // length
+    write_big_endian(out + 4, id);      // id
 
     const uint16_t fo_val = (df ? 0x4000 : 0) | (mf ? 0x2000 : 0) | (offset & 0x1fff);
-    NetUnparser::u16(ret, fo_val);  // flags and offset
+    write_big_endian(out + 6, fo_val);  // flags and offset
 
-    NetUnparser::u8(ret, ttl);    // time to live
-    NetUnparser::u8(ret, proto);  // protocol number
+    write_big_endian(out + 8, ttl);    // time to live
+    write_big_endian(out + 9, proto);  // protocol number
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    write_big_endian(out + 10, cksum);  // checksum
 
-    NetUnparser::u32(ret, src);  // src address
-    NetUnparser::u32(ret, dst);  // dst address
+    write_big_endian(out + 12, src);  // src address
+    write_big_endian(out + 16, dst);  // dst address
 
-    ret.resize(4 * hlen);  // expand header to advertised size
+    memset(out + LENGTH, 0, 4 * hlen - LENGTH);  // expand header to advertised size
+}
 
-    return ret;
+//! Serialize the IPv4Header to a string (does not recompute the checksum)
+string IPv4Header::serialize() const {
+    Headroom headroom;
+    serialize(headroom);
+    return string(headroom.str());
 }
 
 uint16_t IPv4Header::payload_length() const { return len - 4 * hlen; }
 
+//! \details Sums the fields as 16-bit words, in the order they're serialized in, so no serialization is
+//! needed. (Options aren't supported, so the rest of a longer header is zeros and adds nothing.)
+uint16_t IPv4Header::compute_cksum() const {
+    uint32_t sum = (uint32_t{ver} << 12) + (uint32_t{hlen & 0xfu} << 8) + tos;
+    sum += len + id;
+    sum += (df ? 0x4000 : 0) + (mf ? 0x2000 : 0) + (offset & 0x1fff);
+    sum += (uint32_t{ttl} << 8) + proto;
+    sum += (src >> 16) + (src & 0xffff) + (dst >> 16) + (dst & 0xffff);
+    while (sum > 0xffff) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return ~sum;
+}
+
 //! \details This value is needed when computing the checksum of an encapsulated TCP segment.
 //! ~~~{.txt}
 //!   0      7 8     15 16    23 24    31
@@ -130,6 +150,12 @@ uint32_t IPv4Header::pseudo_cksum() const {
     return pcksum;
 }
 
+bool IPv4Header::operator==(const IPv4Header &other) const {
+    return ver == other.ver and hlen == other.hlen and tos == other.tos and len == other.len and id == other.id and
+           df == other.df and mf == other.mf and offset == other.offset and ttl == other.ttl and
+           proto == other.proto and cksum == other.cksum and src == other.src and dst == other.dst;
+}
+
 //! \returns A string with the header's contents
 std::string IPv4Header::to_string() const {
     stringstream ss{};
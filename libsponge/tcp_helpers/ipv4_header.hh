@@ -52,12 +52,21 @@ struct IPv4Header {
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! Serialize the IP fields into `headroom`, without allocating
+    void serialize(Headroom &headroom) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
+    //! The checksum the header should carry, computed from the other fields
+    uint16_t compute_cksum() const;
+
     //! [pseudo-header's](\ref rfc::rfc793) contribution to the TCP checksum
     uint32_t pseudo_cksum() const;
 
+    //! \returns `true` if every field equals the same field of `other`
+    bool operator==(const IPv4Header &other) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -68,4 +77,34 @@ struct IPv4Header {
 //! \struct IPv4Header
 //! This struct can be used to parse an existing IP header or to create a new one.
 
+//! \brief Read-only view of an [IPv4](\ref rfc::rfc791) header in place in a Buffer
+//! \details Reads the same fields as IPv4Header::parse, but only when they're asked for, and without
+//! checking the version, lengths or checksum. For filtering and dispatching datagrams before (or instead
+//! of) parsing them.
+class IPv4HeaderView : public HeaderView {
+  public:
+    //! View the header at the start of `buffer`
+    explicit IPv4HeaderView(Buffer buffer) : HeaderView(std::move(buffer), IPv4Header::LENGTH) {}
+
+    //! \name IPv4 Header fields
+    //!@{
+    uint8_t ver() const { return _field<uint8_t>(0) >> 4; }           //!< IP version
+    uint8_t hlen() const { return _field<uint8_t>(0) & 0x0f; }        //!< header length (multiples of 32 bits)
+    uint8_t tos() const { return _field<uint8_t>(1); }                //!< type of service
+    uint16_t len() const { return _field<uint16_t>(2); }              //!< total length of packet
+    uint16_t id() const { return _field<uint16_t>(4); }               //!< identification number
+    bool df() const { return _field<uint8_t>(6) & 0x40; }             //!< don't fragment flag
+    bool mf() const { return _field<uint8_t>(6) & 0x20; }             //!< more fragments flag
+    uint16_t offset() const { return _field<uint16_t>(6) & 0x1fff; }  //!< fragment offset field
+    uint8_t ttl() const { return _field<uint8_t>(8); }                //!< time to live field
+    uint8_t proto() const { return _field<uint8_t>(9); }              //!< protocol field
+    uint16_t cksum() const { return _field<uint16_t>(10); }           //!< checksum field
+    uint32_t src() const { return _field<uint32_t>(12); }             //!< src address
+    uint32_t dst() const { return _field<uint32_t>(16); }             //!< dst address
+    //!@}
+
+    //! \returns what follows the header (as long as hlen() says), i.e., the payload
+    Buffer payload() const { return _after(4 * hlen()); }
+};
+
 #endif  // SPONGE_LIBSPONGE_IPV4_HEADER_HH
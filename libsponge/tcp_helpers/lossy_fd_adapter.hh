@@ -6,16 +6,38 @@
 #include "tcp_segment.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <optional>
+#include <queue>
 #include <random>
 #include <utility>
+#include <vector>
+
+//! Independent random loss with a fixed probability (the loss model used by LossyFdAdapter)
+class LossModel {
+  private:
+    //! Fast RNG used by should_drop()
+    std::mt19937 _rand{get_random_generator()};
+
+  public:
+    //! Seed the RNG randomly
+    LossModel() = default;
+
+    //! Seed the RNG with `seed`, so that the same decisions are made every run
+    explicit LossModel(const uint32_t seed) : _rand(seed) {}
+
+    //! \brief Decide whether to drop a packet
+    //! \param[in] loss is the loss probability, scaled so that 65535 drops (nearly) everything
+    //! \returns `true` if the packet should be dropped
+    bool should_drop(const uint16_t loss) { return loss != 0 && uint16_t(_rand()) < loss; }
+};
 
 //! An adapter class that adds random dropping behavior to an FD adapter
 template <typename AdapterT>
 class LossyFdAdapter {
   private:
-    //! Fast RNG used by _should_drop()
-    std::mt19937 _rand{get_random_generator()};
+    //! Loss model used by _should_drop()
+    LossModel _loss_model{};
 
     //! The underlying FD adapter
     AdapterT _adapter;
@@ -25,11 +47,13 @@ class LossyFdAdapter {
     //! \returns `true` if the segment should be dropped
     bool _should_drop(bool uplink) {
         const auto &cfg = _adapter.config();
-        const uint16_t loss = uplink ? cfg.loss_rate_up : cfg.loss_rate_dn;
-        return loss != 0 && uint16_t(_rand()) < loss;
+        return _loss_model.should_drop(uplink ? cfg.loss_rate_up : cfg.loss_rate_dn);
     }
 
   public:
+    //! Bytes of headers around each TCP payload, as for AdapterT
+    static constexpr size_t HEADERS_LENGTH = AdapterT::HEADERS_LENGTH;
+
     //! Conversion to a FileDescriptor by returning the underlying AdapterT
     operator const FileDescriptor &() const { return _adapter; }
 
@@ -56,6 +80,30 @@ class LossyFdAdapter {
         return _adapter.write(seg);
     }
 
+    //! \brief Read a batch from the underlying AdapterT instance, potentially dropping each segment
+    //! \param[out] segments receives the segments that weren't dropped
+    void read_batch(std::vector<TCPSegment> &segments) {
+        const size_t first = segments.size();
+        _adapter.read_batch(segments);
+        segments.erase(std::remove_if(segments.begin() + first,
+                                      segments.end(),
+                                      [&](const TCPSegment &) { return _should_drop(false); }),
+                       segments.end());
+    }
+
+    //! \brief Write a batch to the underlying AdapterT instance, potentially dropping each segment
+    //! \param[in,out] segments are the packets to either write or drop (emptied)
+    void write_batch(std::queue<TCPSegment> &segments) {
+        std::queue<TCPSegment> kept{};
+        while (not segments.empty()) {
+            if (not _should_drop(true)) {
+                kept.push(std::move(segments.front()));
+            }
+            segments.pop();
+        }
+        _adapter.write_batch(kept);
+    }
+
     //! \name
     //! Passthrough functions to the underlying AdapterT instance
 
@@ -8,18 +8,36 @@
 #include <cstdint>
 #include <optional>
 
+//! Congestion control algorithm used by the TCPSender (see CongestionController)
+enum class CongestionControl {
+    None,     //!< Limited only by the receiver's advertised window
+    NewReno,  //!< [RFC 5681](\ref rfc::rfc5681) slow start and congestion avoidance
+    Cubic     //!< [RFC 9438](https://www.rfc-editor.org/rfc/rfc9438) CUBIC
+};
+
 //! Config for TCP sender and receiver
 class TCPConfig {
   public:
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Default MSS: conservative max payload size for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr unsigned DUP_ACK_THRESHOLD = 3;   //!< Duplicate acks that trigger a fast retransmit
+    static constexpr uint16_t RTO_MIN_DFLT = 200;      //!< Default lower bound of an adaptive RTO, in milliseconds
+    static constexpr uint16_t RTO_MAX_DFLT = 60000;    //!< Default upper bound of an adaptive RTO, in milliseconds
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
+    size_t mss = MAX_PAYLOAD_SIZE;            //!< Largest payload to send or (via the MSS option) to receive
     std::optional<WrappingInt32> fixed_isn{};
+    CongestionControl congestion_control = CongestionControl::None;  //!< Sender's congestion control algorithm
+    bool adaptive_rto = false;        //!< Derive the RTO from measured round-trip times ([RFC 6298](\ref rfc::rfc6298))
+    uint16_t rto_min = RTO_MIN_DFLT;  //!< Lower bound of an adaptive RTO, in milliseconds
+    uint16_t rto_max = RTO_MAX_DFLT;  //!< Upper bound of an adaptive RTO (including backoff), in milliseconds
+    bool sack = false;          //!< Offer and use selective acknowledgments ([RFC 2018](\ref rfc::rfc2018))
+    bool window_scale = true;   //!< Offer window scaling, so windows can exceed 64 KiB ([RFC 7323](\ref rfc::rfc7323))
+    bool timestamps = false;    //!< Offer and use the Timestamps option ([RFC 7323](\ref rfc::rfc7323))
 };
 
 //! Config for classes derived from FdAdapter
@@ -28,8 +46,12 @@ class FdAdapterConfig {
     Address source{"0", 0};       //!< Source address and port
     Address destination{"0", 0};  //!< Destination address and port
 
+    std::optional<size_t> mtu{};  //!< Largest datagram the link carries; if set, it determines TCPConfig::mss
+
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    bool udp_offload = false;  //!< Use UDP segmentation offload, GSO and GRO (for TCPOverUDPSocketAdapter)
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
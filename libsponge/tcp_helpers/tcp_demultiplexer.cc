@@ -0,0 +1,189 @@
+#include "tcp_demultiplexer.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] address is the local address to accept connections on, or 0 for any
+//! \param[in] port is the local port to accept connections on
+//! \param[in] backlog is the most connections that may be half-open or waiting to be accepted at once
+void TCPDemultiplexer::listen(const uint32_t address, const uint16_t port, const size_t backlog) {
+    _listen_address = {address, port};
+    _backlog = backlog;
+}
+
+//! \param[in] tuple gives the addresses and ports of the new connection
+TCPConnection &TCPDemultiplexer::connect(const TCPFourTuple &tuple) {
+    auto [it, inserted] = _connections.try_emplace(tuple, _cfg, true);
+    if (not inserted) {
+        throw runtime_error("TCPDemultiplexer::connect(): connection to " + tuple.remote().to_string() +
+                            " already exists");
+    }
+    it->second.connection.connect();
+    _collect(tuple, it->second);
+    return it->second.connection;
+}
+
+//! \param[in] tuple identifies the connection, as parsed from the segment's datagram
+//! \param[in] seg is the segment received
+//! \details A SYN that matches no connection opens one if it is for the listening address and the backlog
+//! has room. Any other segment that matches no connection is answered with a RST (unless it is a RST).
+void TCPDemultiplexer::segment_received(const TCPFourTuple &tuple, TCPSegment seg) {
+    auto it = _connections.find(tuple);
+    if (it != _connections.end()) {
+        it->second.connection.segment_received(seg);
+        _collect(tuple, it->second);
+        return;
+    }
+
+    const TCPHeader &header = seg.header();
+    if (header.rst) {
+        return;
+    }
+
+    const bool for_listener = _listen_address.has_value() and _listen_address->second == tuple.local_port and
+                              (_listen_address->first == 0 or _listen_address->first == tuple.local_address);
+    if (not for_listener) {
+        _send_reset(tuple, header, seg.length_in_sequence_space());
+        return;
+    }
+
+    if (not header.syn or header.ack) {
+        // no connection to synchronize with (an ACK here is a leftover from one that has been forgotten)
+        if (header.ack) {
+            _send_reset(tuple, header, seg.length_in_sequence_space());
+        }
+        return;
+    }
+
+    if (_unaccepted >= _backlog) {
+        return;  // the peer will retransmit its SYN, by which time the owner may have caught up
+    }
+
+    it = _connections.try_emplace(tuple, _cfg, false).first;
+    _unaccepted++;
+    it->second.connection.segment_received(seg);
+    _collect(tuple, it->second);
+}
+
+//! \param[in] ms_since_last_tick is the number of milliseconds since the last call to this method
+void TCPDemultiplexer::tick(const size_t ms_since_last_tick) {
+    for (auto it = _connections.begin(); it != _connections.end();) {
+        Entry &entry = it->second;
+        entry.connection.tick(ms_since_last_tick);
+        _collect(it->first, entry);
+
+        if (not entry.accepted and not entry.connection.active()) {
+            auto dead = it++;
+            _erase(dead);
+        } else {
+            ++it;
+        }
+    }
+}
+
+optional<size_t> TCPDemultiplexer::time_until_next_timeout() const {
+    optional<size_t> timeout{};
+    for (const auto &[tuple, entry] : _connections) {
+        const auto connection_timeout = entry.connection.time_until_next_timeout();
+        if (connection_timeout.has_value()) {
+            timeout = min(timeout.value_or(connection_timeout.value()), connection_timeout.value());
+        }
+    }
+    return timeout;
+}
+
+optional<TCPFourTuple> TCPDemultiplexer::accept() {
+    if (_accept_queue.empty()) {
+        return {};
+    }
+
+    const TCPFourTuple tuple = _accept_queue.front();
+    _accept_queue.pop_front();
+
+    Entry &entry = _connections.at(tuple);
+    entry.accepted = true;
+    entry.queued = false;
+    _unaccepted--;
+    return tuple;
+}
+
+//! \param[in] tuple identifies the connection to forget
+void TCPDemultiplexer::erase(const TCPFourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    if (it == _connections.end()) {
+        return;
+    }
+
+    it->second.connection.abort();
+    _collect(tuple, it->second);
+    _erase(it);
+}
+
+//! \param[in] tuple identifies the connection the owner wrote to, or whose outbound stream it ended
+void TCPDemultiplexer::connection_updated(const TCPFourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    if (it != _connections.end()) {
+        _collect(tuple, it->second);
+    }
+}
+
+//! \param[in] tuple identifies the connection
+//! \returns a pointer to the connection, valid until it is erased
+TCPConnection *TCPDemultiplexer::connection(const TCPFourTuple &tuple) {
+    const auto it = _connections.find(tuple);
+    return it == _connections.end() ? nullptr : &it->second.connection;
+}
+
+void TCPDemultiplexer::_collect(const TCPFourTuple &tuple, Entry &entry) {
+    auto &segments = entry.connection.segments_out();
+    while (not segments.empty()) {
+        _segments_out.emplace(tuple, move(segments.front()));
+        segments.pop();
+    }
+
+    if (entry.accepted or entry.queued or not entry.connection.active()) {
+        return;
+    }
+
+    const auto state = entry.connection.state();
+    if (state != TCPState::State::LISTEN and state != TCPState::State::SYN_RCVD) {
+        entry.queued = true;
+        _accept_queue.push_back(tuple);
+    }
+}
+
+//! \param[in] tuple identifies the connection the segment was addressed to
+//! \param[in] header is the header of the segment that belongs to no connection
+//! \param[in] length_in_sequence_space is the length of that segment, counting SYN and FIN
+void TCPDemultiplexer::_send_reset(const TCPFourTuple &tuple,
+                                   const TCPHeader &header,
+                                   const size_t length_in_sequence_space) {
+    TCPSegment rst;
+    rst.header().rst = true;
+    if (header.ack) {
+        rst.header().seqno = header.ackno;
+    } else {
+        rst.header().ack = true;
+        rst.header().ackno = header.seqno + length_in_sequence_space;
+    }
+    _segments_out.emplace(tuple, move(rst));
+}
+
+void TCPDemultiplexer::_erase(unordered_map<TCPFourTuple, Entry, TCPFourTupleHash>::iterator it) {
+    Entry &entry = it->second;
+    if (not entry.accepted) {
+        _unaccepted--;
+    }
+    if (entry.queued) {
+        for (auto q = _accept_queue.begin(); q != _accept_queue.end(); ++q) {
+            if (*q == it->first) {
+                _accept_queue.erase(q);
+                break;
+            }
+        }
+    }
+    _connections.erase(it);
+}
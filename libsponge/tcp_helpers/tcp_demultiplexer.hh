@@ -0,0 +1,135 @@
+#ifndef SPONGE_LIBSPONGE_TCP_DEMULTIPLEXER_HH
+#define SPONGE_LIBSPONGE_TCP_DEMULTIPLEXER_HH
+
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+//! \brief Many TCPConnections sharing one stream of segments, told apart by their TCPFourTuple
+class TCPDemultiplexer {
+  public:
+    //! An outbound segment, with the connection that sent it
+    using OutboundSegment = std::pair<TCPFourTuple, TCPSegment>;
+
+  private:
+    //! A connection and what the owner knows about it
+    struct Entry {
+        TCPConnection connection;
+        bool accepted;       //!< has the connection been handed to the owner (by connect() or accept())?
+        bool queued{false};  //!< is the connection established and waiting in the accept queue?
+
+        Entry(const TCPConfig &cfg, const bool accepted_) : connection(cfg), accepted(accepted_) {}
+    };
+
+    TCPConfig _cfg;
+
+    //! every connection, by its four-tuple
+    std::unordered_map<TCPFourTuple, Entry, TCPFourTupleHash> _connections{};
+
+    //! local address (0 for any) and port on which to accept new connections
+    std::optional<std::pair<uint32_t, uint16_t>> _listen_address{};
+
+    //! most connections that may be opened by a peer but not yet accepted
+    size_t _backlog{0};
+
+    //! number of connections opened by a peer but not yet accepted
+    size_t _unaccepted{0};
+
+    //! established connections that have not yet been accepted, oldest first
+    std::deque<TCPFourTuple> _accept_queue{};
+
+    //! outbound queue of segments, from all connections
+    std::queue<OutboundSegment> _segments_out{};
+
+    //! Move a connection's outbound segments to _segments_out and, if it has just been established, to the
+    //! accept queue
+    void _collect(const TCPFourTuple &tuple, Entry &entry);
+
+    //! Reply to a segment that belongs to no connection (RFC 793, "Reset Generation")
+    void _send_reset(const TCPFourTuple &tuple, const TCPHeader &header, const size_t length_in_sequence_space);
+
+    //! Forget a connection
+    void _erase(std::unordered_map<TCPFourTuple, Entry, TCPFourTupleHash>::iterator it);
+
+  public:
+    //! Initialize with the configuration of every connection
+    explicit TCPDemultiplexer(const TCPConfig &cfg) : _cfg{cfg} {}
+
+    //! Accept SYNs to `address` (0 for any local address) and `port`, with at most `backlog` unaccepted
+    //! connections at a time. SYNs beyond the backlog are dropped, so that the peer retries later.
+    void listen(const uint32_t address, const uint16_t port, const size_t backlog);
+
+    //! Stop accepting new connections; those already open are unaffected
+    void stop_listening() { _listen_address.reset(); }
+
+    //! Open a connection from `tuple`'s local end to its remote end
+    //! \returns the new connection
+    TCPConnection &connect(const TCPFourTuple &tuple);
+
+    //! Give a segment to the connection it belongs to, opening one if it's a SYN to the listening address
+    void segment_received(const TCPFourTuple &tuple, TCPSegment seg);
+
+    //! Tell every connection that time has passed, and forget those that closed before being accepted
+    void tick(const size_t ms_since_last_tick);
+
+    //! Milliseconds until some connection next has work to do in tick(), or nothing if none has a timer running
+    std::optional<size_t> time_until_next_timeout() const;
+
+    //! Take the oldest established connection that hasn't been accepted yet
+    //! \returns its four-tuple, or nothing if no connection is waiting
+    std::optional<TCPFourTuple> accept();
+
+    //! Forget an accepted connection (which sends a RST if it is still active)
+    void erase(const TCPFourTuple &tuple);
+
+    //! Let the demultiplexer collect the segments a connection sent after the owner wrote to it or closed it
+    void connection_updated(const TCPFourTuple &tuple);
+
+    //! \name Accessors
+    //!@{
+
+    //! The connection with the given four-tuple, or nullptr if there is none
+    TCPConnection *connection(const TCPFourTuple &tuple);
+
+    //! Number of connections, in any state
+    size_t size() const { return _connections.size(); }
+
+    //! Number of connections opened by a peer and not yet accepted (counted against the backlog)
+    size_t unaccepted() const { return _unaccepted; }
+
+    //! Established connections waiting to be accepted
+    size_t accept_queue_size() const { return _accept_queue.size(); }
+
+    //! Outbound segments, each with the connection that sent it
+    std::queue<OutboundSegment> &segments_out() { return _segments_out; }
+
+    //! Call `f(tuple, connection)` on every connection
+    template <typename F>
+    void for_each(F &&f) {
+        for (auto &[tuple, entry] : _connections) {
+            f(tuple, entry.connection);
+        }
+    }
+    //!@}
+};
+
+//! \class TCPDemultiplexer
+//! A TCPDemultiplexer does for many connections what a TCPConnection does for one: it takes in
+//! segments (each with the TCPFourTuple parsed from its datagram, see TCPOverIPv4Adapter::parse_tcp_in_ip),
+//! hands them to the right TCPConnection, and gathers the segments those connections send. A connection
+//! opened by a peer waits in the backlog until it is established, and then in the accept queue until
+//! accept() hands it to the owner; connections that die before that are forgotten. Accepted connections
+//! stay until the owner erases them, so that it can read whatever data they still hold.
+//!
+//! It does no I/O and starts no threads, so it can be driven by any event loop (see TCPSpongeServer).
+
+#endif  // SPONGE_LIBSPONGE_TCP_DEMULTIPLEXER_HH
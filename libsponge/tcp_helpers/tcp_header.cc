@@ -1,5 +1,7 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 using namespace std;
@@ -37,44 +39,56 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse the options from a view of the rest of the header, then skip past them
+    const size_t options_size = doff * 4 - TCPHeader::LENGTH;
+    Buffer options_view = p.buffer();
+    options_view.remove_suffix(options_view.size() - min(options_view.size(), options_size));
+    p.remove_prefix(options_size);
 
     if (p.error()) {
         return p.get_error();
     }
 
+    options.parse(options_view);
+
     return ParseResult::NoError;
 }
 
-//! Serialize the TCPHeader to a string (does not recompute the checksum)
-string TCPHeader::serialize() const {
+//! Serialize the TCPHeader into headroom (does not recompute the checksum)
+//! \param[in,out] headroom receives the header, ahead of what it already holds
+void TCPHeader::serialize(Headroom &headroom) const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * doff);
+    char *out = headroom.prepend(4 * doff);
 
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    write_big_endian(out, sport);                    // source port
+    write_big_endian(out + 2, dport);                // destination port
+    write_big_endian(out + 4, seqno.raw_value());    // sequence number
+    write_big_endian(out + 8, ackno.raw_value());    // ack number
+    write_big_endian<uint8_t>(out + 12, doff << 4);  // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    write_big_endian(out + 13, fl_b);  // flags
+    write_big_endian(out + 14, win);   // window size
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    write_big_endian(out + 16, cksum);  // checksum
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    write_big_endian(out + 18, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    // options that fit in the advertised size, then padding to expand the header to it
+    const size_t options_size = options.serialize(out + LENGTH, 4 * doff - LENGTH);
+    memset(out + LENGTH + options_size, 0, 4 * doff - LENGTH - options_size);
+}
 
-    return ret;
+//! Serialize the TCPHeader to a string (does not recompute the checksum)
+string TCPHeader::serialize() const {
+    Headroom headroom;
+    serialize(headroom);
+    return string(headroom.str());
 }
 
 //! \returns A string with the header's contents
@@ -89,14 +103,28 @@ string TCPHeader::to_string() const {
        << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << options.to_string();
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (options.mss.has_value()) {
+        ss << ",mss=" << options.mss.value();
+    }
+    if (options.window_scale.has_value()) {
+        ss << ",wscale=" << +options.window_scale.value();
+    }
+    if (options.timestamps.has_value()) {
+        ss << ",ts=" << options.timestamps.value().value << "/" << options.timestamps.value().echo;
+    }
+    for (const auto &block : options.sack_blocks) {
+        ss << ",sack=" << block.left << "-" << block.right;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +132,5 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && options == other.options;
 }
@@ -2,12 +2,13 @@
 #define SPONGE_LIBSPONGE_TCP_HEADER_HH
 
 #include "parser.hh"
+#include "tcp_options.hh"
 #include "wrapping_integers.hh"
 
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_LENGTH = LENGTH + TCPOptions::MAX_LENGTH;  //!< Header length, including options
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +51,23 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \brief TCP options
+    //! \note serialize() writes only the options that fit in the `doff` words of the header;
+    //! set `doff` with options_length() to make room for all of them.
+    TCPOptions options{};
+
+    //! Number of bytes the options occupy, padded to a multiple of four
+    size_t options_length() const { return options.length(); }
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! Serialize the TCP fields into `headroom`, without allocating
+    void serialize(Headroom &headroom) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -63,6 +75,37 @@ struct TCPHeader {
     std::string summary() const;
 
     bool operator==(const TCPHeader &other) const;
+
+};
+
+//! \brief Read-only view of a [TCP](\ref rfc::rfc793) header in place in a Buffer
+//! \details Reads the same fields as TCPHeader::parse (except the options), but only when they're asked
+//! for, and without checking the data offset or checksum.
+class TCPHeaderView : public HeaderView {
+  public:
+    //! View the header at the start of `buffer`
+    explicit TCPHeaderView(Buffer buffer) : HeaderView(std::move(buffer), TCPHeader::LENGTH) {}
+
+    //! \name TCP Header fields
+    //!@{
+    uint16_t sport() const { return _field<uint16_t>(0); }                      //!< source port
+    uint16_t dport() const { return _field<uint16_t>(2); }                      //!< destination port
+    WrappingInt32 seqno() const { return WrappingInt32{_field<uint32_t>(4)}; }  //!< sequence number
+    WrappingInt32 ackno() const { return WrappingInt32{_field<uint32_t>(8)}; }  //!< ack number
+    uint8_t doff() const { return _field<uint8_t>(12) >> 4; }                   //!< data offset
+    bool urg() const { return _field<uint8_t>(13) & 0b0010'0000; }              //!< urgent flag
+    bool ack() const { return _field<uint8_t>(13) & 0b0001'0000; }              //!< ack flag
+    bool psh() const { return _field<uint8_t>(13) & 0b0000'1000; }              //!< push flag
+    bool rst() const { return _field<uint8_t>(13) & 0b0000'0100; }              //!< rst flag
+    bool syn() const { return _field<uint8_t>(13) & 0b0000'0010; }              //!< syn flag
+    bool fin() const { return _field<uint8_t>(13) & 0b0000'0001; }              //!< fin flag
+    uint16_t win() const { return _field<uint16_t>(14); }                       //!< window size
+    uint16_t cksum() const { return _field<uint16_t>(16); }                     //!< checksum
+    uint16_t uptr() const { return _field<uint16_t>(18); }                      //!< urgent pointer
+    //!@}
+
+    //! \returns what follows the header (as long as doff() says), i.e., the payload
+    Buffer payload() const { return _after(4 * doff()); }
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_HEADER_HH
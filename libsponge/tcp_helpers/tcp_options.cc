@@ -0,0 +1,176 @@
+#include "tcp_options.hh"
+
+#include "parser.hh"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+using namespace std;
+
+//! \param[in] options holds the bytes between the fixed header and the payload
+//! \details Unknown options are skipped. A malformed option ends the list without failing the parse,
+//! so that the segment can still be processed without it. An option whose length doesn't match its
+//! kind is ignored.
+void TCPOptions::parse(const Buffer options) {
+    *this = {};
+
+    NetParser p{options};
+    while (p.buffer().size() > 0) {
+        const auto kind = static_cast<TCPOptionKind>(p.u8());
+        if (kind == TCPOptionKind::EndOfList) {
+            break;
+        }
+        if (kind == TCPOptionKind::NoOperation) {
+            continue;
+        }
+
+        if (p.buffer().size() == 0) {
+            break;
+        }
+        const size_t length = p.u8();
+        if (length < 2 or length - 2 > p.buffer().size()) {
+            break;
+        }
+        const size_t body_length = length - 2;
+
+        switch (kind) {
+            case TCPOptionKind::MaxSegmentSize:
+                if (length == 4) {
+                    mss = p.u16();
+                } else {
+                    p.remove_prefix(body_length);
+                }
+                break;
+            case TCPOptionKind::WindowScale:
+                if (length == 3) {
+                    // RFC 7323 section 2.3: a shift greater than 14 is treated as 14
+                    window_scale = min(p.u8(), MAX_WINDOW_SCALE);
+                } else {
+                    p.remove_prefix(body_length);
+                }
+                break;
+            case TCPOptionKind::SACKPermitted:
+                sack_permitted = true;
+                p.remove_prefix(body_length);
+                break;
+            case TCPOptionKind::SACK:
+                for (size_t i = 0; i < body_length / 8; i++) {
+                    const WrappingInt32 left{p.u32()};
+                    const WrappingInt32 right{p.u32()};
+                    sack_blocks.push_back({left, right});
+                }
+                p.remove_prefix(body_length % 8);
+                break;
+            case TCPOptionKind::Timestamps:
+                if (length == 10) {
+                    const uint32_t value = p.u32();
+                    const uint32_t echo = p.u32();
+                    timestamps = TCPTimestamps{value, echo};
+                } else {
+                    p.remove_prefix(body_length);
+                }
+                break;
+            default:
+                p.remove_prefix(body_length);
+                break;
+        }
+    }
+}
+
+//! \param[out] out receives the options that fit in `room` bytes, each aligned as recommended by RFC 7323
+//! appendix A
+//! \param[in] room is the number of bytes available for options
+//! \returns the number of bytes written
+size_t TCPOptions::serialize(char *out, const size_t room) const {
+    size_t written = 0;
+
+    const auto u8 = [&](const uint8_t value) { write_big_endian(out + written++, value); };
+    const auto u16 = [&](const uint16_t value) {
+        write_big_endian(out + written, value);
+        written += 2;
+    };
+    const auto u32 = [&](const uint32_t value) {
+        write_big_endian(out + written, value);
+        written += 4;
+    };
+    const auto nop = [&](const size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            u8(static_cast<uint8_t>(TCPOptionKind::NoOperation));
+        }
+    };
+    const auto option = [&](const TCPOptionKind kind, const uint8_t length) {
+        u8(static_cast<uint8_t>(kind));
+        u8(length);
+    };
+
+    if (mss.has_value() and written + 4 <= room) {
+        option(TCPOptionKind::MaxSegmentSize, 4);
+        u16(mss.value());
+    }
+
+    if (window_scale.has_value() and written + 4 <= room) {
+        nop(1);
+        option(TCPOptionKind::WindowScale, 3);
+        u8(window_scale.value());
+    }
+
+    if (sack_permitted and written + 4 <= room) {
+        nop(2);
+        option(TCPOptionKind::SACKPermitted, 2);
+    }
+
+    if (timestamps.has_value() and written + TIMESTAMPS_LENGTH <= room) {
+        nop(2);
+        option(TCPOptionKind::Timestamps, 10);
+        u32(timestamps.value().value);
+        u32(timestamps.value().echo);
+    }
+
+    const size_t blocks_that_fit = room < written + 4 + 8 ? 0 : (room - written - 4) / 8;
+    const size_t n_blocks = min({sack_blocks.size(), blocks_that_fit, MAX_SACK_BLOCKS});
+    if (n_blocks > 0) {
+        nop(2);
+        option(TCPOptionKind::SACK, 2 + 8 * n_blocks);
+        for (size_t i = 0; i < n_blocks; i++) {
+            u32(sack_blocks[i].left.raw_value());
+            u32(sack_blocks[i].right.raw_value());
+        }
+    }
+
+    return written;
+}
+
+string TCPOptions::serialize(const size_t room) const {
+    array<char, MAX_LENGTH> bytes;
+    return string(bytes.data(), serialize(bytes.data(), min(room, MAX_LENGTH)));
+}
+
+size_t TCPOptions::length() const {
+    array<char, MAX_LENGTH> bytes;
+    return serialize(bytes.data(), MAX_LENGTH);
+}
+
+//! \returns A string with the options that are present, one per line
+string TCPOptions::to_string() const {
+    stringstream ss{};
+    if (mss.has_value()) {
+        ss << "TCP mss: " << mss.value() << '\n';
+    }
+    if (window_scale.has_value()) {
+        ss << "TCP window scale: " << +window_scale.value() << '\n';
+    }
+    ss << "TCP sack_permitted: " << boolalpha << sack_permitted << '\n';
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: " << timestamps.value().value << " echo " << timestamps.value().echo << '\n';
+    }
+    for (const auto &block : sack_blocks) {
+        ss << "TCP sack block: " << block.left << "-" << block.right << '\n';
+    }
+    return ss.str();
+}
+
+bool TCPOptions::operator==(const TCPOptions &other) const {
+    return mss == other.mss && window_scale == other.window_scale && sack_permitted == other.sack_permitted &&
+           timestamps == other.timestamps && sack_blocks == other.sack_blocks;
+}
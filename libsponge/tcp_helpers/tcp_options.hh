@@ -0,0 +1,73 @@
+#ifndef SPONGE_LIBSPONGE_TCP_OPTIONS_HH
+#define SPONGE_LIBSPONGE_TCP_OPTIONS_HH
+
+#include "buffer.hh"
+#include "wrapping_integers.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+//! \brief Kinds of [TCP](\ref rfc::rfc793) options understood by TCPOptions (others are skipped)
+enum class TCPOptionKind : uint8_t {
+    EndOfList = 0,         //!< End of the option list
+    NoOperation = 1,       //!< Padding between options
+    MaxSegmentSize = 2,    //!< Largest payload the sender of the SYN will accept
+    WindowScale = 3,       //!< Window scale shift ([RFC 7323](\ref rfc::rfc7323))
+    SACKPermitted = 4,     //!< Selective acknowledgment may be used ([RFC 2018](\ref rfc::rfc2018))
+    SACK = 5,              //!< Selective acknowledgment blocks
+    Timestamps = 8         //!< Timestamp value and echo reply ([RFC 7323](\ref rfc::rfc7323))
+};
+
+//! \brief A contiguous block of data that the receiver holds beyond its ackno
+struct TCPSACKBlock {
+    WrappingInt32 left{0};   //!< sequence number of the first byte of the block
+    WrappingInt32 right{0};  //!< sequence number just past the last byte of the block
+
+    bool operator==(const TCPSACKBlock &other) const { return left == other.left && right == other.right; }
+};
+
+//! \brief The contents of a Timestamps option
+struct TCPTimestamps {
+    uint32_t value{0};  //!< TSval: the sender's clock when the segment was sent
+    uint32_t echo{0};   //!< TSecr: the most recent TSval received from the peer
+
+    bool operator==(const TCPTimestamps &other) const { return value == other.value && echo == other.echo; }
+};
+
+//! \brief The [TCP](\ref rfc::rfc793) options of a segment
+//! \details Unset fields are not sent. MSS, window scale and SACK-permitted are only meaningful on SYN segments.
+struct TCPOptions {
+    static constexpr size_t MAX_LENGTH = 40;      //!< Room for options in the largest TCP header
+    static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< The most SACK blocks that fit, without timestamps
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;  //!< Largest shift allowed by RFC 7323
+    static constexpr size_t TIMESTAMPS_LENGTH = 12;  //!< Bytes the Timestamps option takes, with its padding
+
+    std::optional<uint16_t> mss{};             //!< Maximum segment size
+    std::optional<uint8_t> window_scale{};     //!< Shift applied to the window field of the sender's segments
+    bool sack_permitted = false;               //!< SACK-permitted option
+    std::optional<TCPTimestamps> timestamps{};  //!< Timestamps option
+    std::vector<TCPSACKBlock> sack_blocks{};    //!< SACK option blocks
+
+    //! Parse the options from the bytes between the fixed TCP header and the payload
+    void parse(const Buffer options);
+
+    //! Serialize the options that fit in `room` bytes, padded with NOPs to a multiple of four
+    //! \note SACK blocks come last and are cut to fit, so with timestamps at most three are sent
+    std::string serialize(const size_t room = MAX_LENGTH) const;
+
+    //! Serialize the options that fit in `room` bytes into `out`, without allocating
+    size_t serialize(char *out, const size_t room) const;
+
+    //! Number of bytes the options occupy, padded to a multiple of four
+    size_t length() const;
+
+    //! Return a string containing the options in human-readable format
+    std::string to_string() const;
+
+    bool operator==(const TCPOptions &other) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_OPTIONS_HH
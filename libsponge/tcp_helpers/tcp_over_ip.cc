@@ -11,6 +11,28 @@
 
 using namespace std;
 
+//! \returns the remote end of the connection as an Address
+Address TCPFourTuple::remote() const { return {Address::from_ipv4_numeric(remote_address).ip(), remote_port}; }
+
+//! \param[in] ip_dgram is the datagram to parse
+//! \param[out] tuple is set to the connection the segment belongs to: our end is the datagram's destination
+//! \returns a std::optional<TCPSegment> that is empty if the datagram doesn't carry a valid TCP segment
+optional<TCPSegment> TCPOverIPv4Adapter::parse_tcp_in_ip(const InternetDatagram &ip_dgram, TCPFourTuple &tuple) {
+    // does the IPv4 datagram claim that its payload is a TCP segment?
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    // is the payload a valid TCP segment?
+    TCPSegment tcp_seg;
+    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+        return {};
+    }
+
+    tuple = {ip_dgram.header().dst, tcp_seg.header().dport, ip_dgram.header().src, tcp_seg.header().sport};
+    return tcp_seg;
+}
+
 //! \details This function attempts to parse a TCP segment from
 //! the IP datagram's payload.
 //!
@@ -35,27 +57,22 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         return {};
     }
 
-    // does the IPv4 datagram claim that its payload is a TCP segment?
-    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
-        return {};
-    }
-
-    // is the payload a valid TCP segment?
-    TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    TCPFourTuple tuple;
+    auto tcp_seg = parse_tcp_in_ip(ip_dgram, tuple);
+    if (not tcp_seg.has_value()) {
         return {};
     }
 
     // is the TCP segment for us?
-    if (tcp_seg.header().dport != config().source.port()) {
+    if (tuple.local_port != config().source.port()) {
         return {};
     }
 
     // should we target this source addr/port (and use its destination addr as our source) in reply?
     if (listening()) {
-        if (tcp_seg.header().syn and not tcp_seg.header().rst) {
-            config_mutable().source = {inet_ntoa({htobe32(ip_dgram.header().dst)}), config().source.port()};
-            config_mutable().destination = {inet_ntoa({htobe32(ip_dgram.header().src)}), tcp_seg.header().sport};
+        if (tcp_seg->header().syn and not tcp_seg->header().rst) {
+            config_mutable().source = {Address::from_ipv4_numeric(tuple.local_address).ip(), tuple.local_port};
+            config_mutable().destination = tuple.remote();
             set_listening(false);
         } else {
             return {};
@@ -63,28 +80,91 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
     }
 
     // is the TCP segment from our peer?
-    if (tcp_seg.header().sport != config().destination.port()) {
+    if (tuple.remote_port != config().destination.port()) {
         return {};
     }
 
     return tcp_seg;
 }
 
-//! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
-//! \param[in] seg is the TCP segment to convert
-InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+//! \param[in] datagram is a serialized IPv4 datagram
+//! \returns `false` if the datagram's addresses, protocol, ports or flags rule out its being accepted by
+//! unwrap_tcp_in_ip(), which (on `true`) still has to parse and checksum it
+//! \details Reads the IPv4 and TCP headers in place with header views, so that traffic for other
+//! connections can be dropped without being parsed.
+bool TCPOverIPv4Adapter::may_unwrap(const Buffer &datagram) const {
+    const IPv4HeaderView ip_header{datagram};
+    if (not ip_header.valid() or ip_header.proto() != IPv4Header::PROTO_TCP) {
+        return false;
+    }
+    if (not listening() and (ip_header.dst() != config().source.ipv4_numeric() or
+                             ip_header.src() != config().destination.ipv4_numeric())) {
+        return false;
+    }
+
+    const TCPHeaderView tcp_header{ip_header.payload()};
+    if (not tcp_header.valid() or tcp_header.dport() != config().source.port()) {
+        return false;
+    }
+    if (listening()) {
+        return tcp_header.syn() and not tcp_header.rst();
+    }
+    return tcp_header.sport() == config().destination.port();
+}
+
+//! \param[in,out] seg is the TCP segment, whose port numbers are set
+//! \param[in] tuple gives the addresses and port numbers
+//! \returns an IPv4 header with the addresses, and the length of a datagram carrying the segment
+IPv4Header TCPOverIPv4Adapter::_ip_header_for(TCPSegment &seg, const TCPFourTuple &tuple) {
     // set the port numbers in the TCP segment
-    seg.header().sport = config().source.port();
-    seg.header().dport = config().destination.port();
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
 
-    // create an Internet Datagram and set its addresses and length
+    // set the addresses and length of the Internet Datagram
+    IPv4Header ip_header;
+    ip_header.src = tuple.local_address;
+    ip_header.dst = tuple.remote_address;
+    ip_header.len = ip_header.hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    return ip_header;
+}
+
+TCPFourTuple TCPOverIPv4Adapter::_config_tuple() const {
+    return {config().source.ipv4_numeric(),
+            config().source.port(),
+            config().destination.ipv4_numeric(),
+            config().destination.port()};
+}
+
+//! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
+//! \param[in] seg is the TCP segment to convert
+//! \param[in] tuple gives the addresses and port numbers
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg, const TCPFourTuple &tuple) {
     InternetDatagram ip_dgram;
-    ip_dgram.header().src = config().source.ipv4_numeric();
-    ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header() = _ip_header_for(seg, tuple);
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
 
     return ip_dgram;
 }
+
+//! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
+//! \param[in] seg is the TCP segment to convert
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) { return wrap_tcp_in_ip(seg, _config_tuple()); }
+
+//! \param[in,out] seg is the TCP segment, whose port numbers are set
+//! \param[in] tuple gives the addresses and port numbers
+//! \param[out] headroom receives the IPv4 header followed by the TCP header, both with their checksums
+void TCPOverIPv4Adapter::serialize_tcp_in_ip(TCPSegment &seg, const TCPFourTuple &tuple, Headroom &headroom) {
+    IPv4Header ip_header = _ip_header_for(seg, tuple);
+    seg.serialize(headroom, ip_header.pseudo_cksum());
+
+    ip_header.cksum = ip_header.compute_cksum();
+    ip_header.serialize(headroom);
+}
+
+//! \param[in,out] seg is the TCP segment, whose port numbers are set from the configuration
+//! \param[out] headroom receives the IPv4 header followed by the TCP header
+void TCPOverIPv4Adapter::serialize_tcp_in_ip(TCPSegment &seg, Headroom &headroom) {
+    serialize_tcp_in_ip(seg, _config_tuple(), headroom);
+}
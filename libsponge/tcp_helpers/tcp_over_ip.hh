@@ -2,18 +2,89 @@
 #define SPONGE_LIBSPONGE_TCP_OVER_IP_HH
 
 #include "buffer.hh"
+#include "ethernet_header.hh"
 #include "fd_adapter.hh"
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <optional>
 
+//! \brief The addresses and ports that identify a TCP connection, as seen from this end
+struct TCPFourTuple {
+    uint32_t local_address{0};   //!< our IPv4 address (numeric, host byte order)
+    uint16_t local_port{0};      //!< our TCP port
+    uint32_t remote_address{0};  //!< the peer's IPv4 address (numeric, host byte order)
+    uint16_t remote_port{0};     //!< the peer's TCP port
+
+    //! The same connection, as seen from the other end
+    TCPFourTuple reversed() const { return {remote_address, remote_port, local_address, local_port}; }
+
+    //! The peer's address and port
+    Address remote() const;
+
+    bool operator==(const TCPFourTuple &other) const {
+        return local_address == other.local_address && local_port == other.local_port &&
+               remote_address == other.remote_address && remote_port == other.remote_port;
+    }
+};
+
+//! Hash for TCPFourTuple, so that it can key an unordered container
+struct TCPFourTupleHash {
+    size_t operator()(const TCPFourTuple &t) const {
+        const uint64_t addresses = (uint64_t{t.local_address} << 32) | t.remote_address;
+        const uint64_t ports = (uint64_t{t.local_port} << 16) | t.remote_port;
+        return std::hash<uint64_t>{}(addresses ^ (ports * 0x9e3779b97f4a7c15ULL));
+    }
+};
+
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
+    //! Set the ports of a TCP segment from `tuple`, and make the header of an IPv4 datagram to carry it
+    static IPv4Header _ip_header_for(TCPSegment &seg, const TCPFourTuple &tuple);
+
+    //! The connection in the configuration
+    TCPFourTuple _config_tuple() const;
+
+    BufferPool _packet_pool;        //!< Slabs that packets are read into
+    BufferPool _large_packet_pool;  //!< Slabs for packets too big for `_packet_pool`'s
+
+  protected:
+    //! Read a packet (e.g., from a TUN or TAP device) into a pooled Buffer
+    Buffer _read_packet(FileDescriptor &fd) { return fd.read_into(_packet_pool, _large_packet_pool); }
+
   public:
+    //! Bytes of IPv4 and TCP headers (without options) around each TCP payload
+    static constexpr size_t HEADERS_LENGTH = IPv4Header::LENGTH + TCPHeader::LENGTH;
+
+    //! Size of the slabs that packets are read into, enough for a 1500-byte MTU and an Ethernet header
+    static constexpr size_t PACKET_SLAB_SIZE = 2048;
+
+    //! Size of the slabs that larger packets are read into, enough for the largest IPv4 datagram in a frame
+    static constexpr size_t LARGE_PACKET_SLAB_SIZE = 65536 + EthernetHeader::LENGTH;
+
+    TCPOverIPv4Adapter() : _packet_pool(PACKET_SLAB_SIZE), _large_packet_pool(LARGE_PACKET_SLAB_SIZE, 4) {}
+
+    //! Parse the TCP segment in an IPv4 datagram, and the connection it belongs to, without filtering
+    static std::optional<TCPSegment> parse_tcp_in_ip(const InternetDatagram &ip_dgram, TCPFourTuple &tuple);
+
+    //! Wrap a TCP segment in an IPv4 datagram from `tuple`'s local end to its remote end
+    static InternetDatagram wrap_tcp_in_ip(TCPSegment &seg, const TCPFourTuple &tuple);
+
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
+    //! Check a serialized datagram's headers, without parsing it, for whether unwrap_tcp_in_ip() could accept it
+    bool may_unwrap(const Buffer &datagram) const;
+
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! Like wrap_tcp_in_ip(), but serializes just the IPv4 and TCP headers, into `headroom`; the datagram is
+    //! those followed by the segment's payload
+    static void serialize_tcp_in_ip(TCPSegment &seg, const TCPFourTuple &tuple, Headroom &headroom);
+
+    void serialize_tcp_in_ip(TCPSegment &seg, Headroom &headroom);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -26,19 +26,28 @@ size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+//! \param[in,out] headroom receives the header, ahead of what it already holds
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
+//! \details Serializes the header once, with a zero checksum, and then writes the checksum into place.
+void TCPSegment::serialize(Headroom &headroom, const uint32_t datagram_layer_checksum) const {
+    _header.serialize(headroom);
+    char *header_bytes = headroom.front();
+    write_big_endian<uint16_t>(header_bytes + 16, 0);
 
     // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
+    check.add({header_bytes, size_t{4} * _header.doff});
     check.add(_payload);
-    header_out.cksum = check.value();
+    write_big_endian(header_bytes + 16, check.value());
+}
+
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
+    Headroom headroom;
+    serialize(headroom, datagram_layer_checksum);
 
     BufferList ret;
-    ret.append(header_out.serialize());
+    ret.append(headroom.to_buffer());
     ret.append(_payload);
 
     return ret;
@@ -7,35 +7,72 @@
 
 #include <cstddef>
 #include <exception>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
-static constexpr size_t TCP_TICK_MS = 10;
+//! \returns an eventfd with which the owner wakes up the TCP thread
+static FileDescriptor wake_signal_helper() {
+    return FileDescriptor(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)));
+}
+
+//! \param[in] wake_signal is an eventfd from wake_signal_helper, which is made readable
+static void raise_wake_signal(FileDescriptor &wake_signal) {
+    const uint64_t one = 1;
+    wake_signal.write(string(reinterpret_cast<const char *>(&one), sizeof(one)));
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_tick() {
+    const auto next_time = timestamp_ms();
+    if (_tcp.value().active() and next_time != _base_time) {
+        _tcp.value().tick(next_time - _base_time);
+        _datagram_adapter.tick(next_time - _base_time);
+        _base_time = next_time;
+    }
+}
+
+//! \details Call right after _tick(), since the TCPConnection's timeout counts from its last tick.
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_schedule_tick() {
+    if (_tick_timer.has_value()) {
+        _eventloop.cancel_timer(_tick_timer.value());
+        _tick_timer.reset();
+    }
+
+    const auto timeout = _tcp.value().time_until_next_timeout();
+    if (timeout.has_value()) {
+        _tick_timer = _eventloop.add_timer(timeout.value(), [&] {
+            _tick_timer.reset();
+            _tick();
+        });
+    }
+}
 
 //! \param[in] condition is a function returning true if loop should continue
+//! \details Rather than waking up periodically to tick the TCPConnection, the loop sleeps until an fd is
+//! ready or the connection's next timeout, and ticks it with the time that has passed whenever it wakes up.
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
-    auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        _tick();
+        _schedule_tick();
+
+        auto ret = _eventloop.wait_next_event(-1);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
-
-        if (_tcp.value().active()) {
-            const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
-            _datagram_adapter.tick(next_time - base_time);
-            base_time = next_time;
-        }
     }
 }
 
@@ -46,13 +83,15 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
                                          AdaptT &&datagram_interface)
     : LocalStreamSocket(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
-    , _datagram_adapter(move(datagram_interface)) {
+    , _datagram_adapter(move(datagram_interface))
+    , _wake_signal(wake_signal_helper()) {
     _thread_data.set_blocking(false);
 }
 
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    _base_time = timestamp_ms();
 
     // Set up the event loop
 
@@ -76,9 +115,13 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                            vector<TCPSegment> segments{};
+                            _datagram_adapter.read_batch(segments);
+                            if (not segments.empty()) {
+                                _tick();  // so that the segments are processed at the right time
+                            }
+                            for (auto &seg : segments) {
+                                _tcp->segment_received(move(seg));
                             }
 
                             // debugging output:
@@ -96,8 +139,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            Buffer data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
+            _tick();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
                 throw runtime_error("TCPConnection::write() accepted less than advertised length");
@@ -129,8 +173,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_buffers(amount_to_write), false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
@@ -153,13 +196,15 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     // rule 4: read outbound segments from TCPConnection and send as datagrams
     _eventloop.add_rule(_datagram_adapter,
                         Direction::Out,
-                        [&] {
-                            while (not _tcp->segments_out().empty()) {
-                                _datagram_adapter.write(_tcp->segments_out().front());
-                                _tcp->segments_out().pop();
-                            }
-                        },
+                        [&] { _datagram_adapter.write_batch(_tcp->segments_out()); },
                         [&] { return not _tcp->segments_out().empty(); });
+
+    // rule 5: wake up when the owner sets _abort (while any of the other rules might still need to wait)
+    _eventloop.add_rule(
+        _wake_signal,
+        Direction::In,
+        [&] { _wake_signal.read(sizeof(uint64_t)); },
+        [&] { return _tcp->active() or not _inbound_shutdown; });
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
@@ -183,6 +228,7 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
             cerr << "Warning: unclean shutdown of TCPSpongeSocket\n";
             // force the other side to exit
             _abort.store(true);
+            raise_wake_signal(_wake_signal);
             _tcp_thread.join();
         }
     } catch (const exception &e) {
@@ -200,6 +246,18 @@ void TCPSpongeSocket<AdaptT>::wait_until_closed() {
     }
 }
 
+//! \returns `c_tcp`, with its MSS set to fill a datagram of `c_ad.mtu` bytes if an MTU is configured
+template <typename AdaptT>
+static TCPConfig with_mss_for_mtu(TCPConfig c_tcp, const FdAdapterConfig &c_ad) {
+    if (c_ad.mtu.has_value()) {
+        if (c_ad.mtu.value() <= AdaptT::HEADERS_LENGTH) {
+            throw runtime_error("MTU of " + to_string(c_ad.mtu.value()) + " bytes leaves no room for TCP payload");
+        }
+        c_tcp.mss = c_ad.mtu.value() - AdaptT::HEADERS_LENGTH;
+    }
+    return c_tcp;
+}
+
 //! \param[in] c_tcp is the TCPConfig for the TCPConnection
 //! \param[in] c_ad is the FdAdapterConfig for the FdAdapter
 template <typename AdaptT>
@@ -208,7 +266,7 @@ void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterCon
         throw runtime_error("connect() with TCPConnection already initialized");
     }
 
-    _initialize_TCP(c_tcp);
+    _initialize_TCP(with_mss_for_mtu<AdaptT>(c_tcp, c_ad));
 
     _datagram_adapter.config_mut() = c_ad;
 
@@ -236,7 +294,7 @@ void TCPSpongeSocket<AdaptT>::listen_and_accept(const TCPConfig &c_tcp, const Fd
         throw runtime_error("listen_and_accept() with TCPConnection already initialized");
     }
 
-    _initialize_TCP(c_tcp);
+    _initialize_TCP(with_mss_for_mtu<AdaptT>(c_tcp, c_ad));
 
     _datagram_adapter.config_mut() = c_ad;
     _datagram_adapter.set_listening(true);
@@ -270,6 +328,302 @@ void TCPSpongeSocket<AdaptT>::_tcp_main() {
     }
 }
 
+//! \param[in] adapter is the underlying interface (IPv4 over TUN or Ethernet, or one queue of it)
+template <typename AdaptT>
+TCPSpongeServer<AdaptT>::Worker::Worker(AdaptT &&adapter)
+    : datagram_adapter(move(adapter)), wake_signal(wake_signal_helper()) {}
+
+//! \param[in] datagram_interface is the underlying interface (IPv4 over TUN or Ethernet)
+template <typename AdaptT>
+TCPSpongeServer<AdaptT>::TCPSpongeServer(AdaptT &&datagram_interface) {
+    _workers.push_back(make_unique<Worker>(move(datagram_interface)));
+}
+
+//! \param[in] queue_interfaces are the underlying interfaces, one per queue of the same device
+template <typename AdaptT>
+TCPSpongeServer<AdaptT>::TCPSpongeServer(vector<AdaptT> &&queue_interfaces) {
+    if (queue_interfaces.empty()) {
+        throw runtime_error("TCPSpongeServer needs at least one interface");
+    }
+    for (auto &interface : queue_interfaces) {
+        _workers.push_back(make_unique<Worker>(move(interface)));
+    }
+}
+
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::_tick(Worker &worker) {
+    const auto next_time = timestamp_ms();
+    if (next_time != worker.base_time) {
+        worker.demux->tick(next_time - worker.base_time);
+        worker.datagram_adapter.tick(next_time - worker.base_time);
+        worker.base_time = next_time;
+    }
+}
+
+//! \details Call right after _tick(), since each connection's timeout counts from its last tick.
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::_schedule_tick(Worker &worker) {
+    if (worker.tick_timer.has_value()) {
+        worker.eventloop.cancel_timer(worker.tick_timer.value());
+        worker.tick_timer.reset();
+    }
+
+    const auto timeout = worker.demux->time_until_next_timeout();
+    if (timeout.has_value()) {
+        worker.tick_timer = worker.eventloop.add_timer(timeout.value(), [this, &worker] {
+            worker.tick_timer.reset();
+            _tick(worker);
+        });
+    }
+}
+
+//! \param[in] worker runs the accepted connection
+//! \param[in] tuple identifies the accepted connection, whose Stream has just been added
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::_add_stream_rules(Worker &worker, const TCPFourTuple &tuple) {
+    Stream &stream = worker.streams.at(tuple);
+
+    // read from the owner's writes into the connection's outbound stream
+    worker.eventloop.add_rule(
+        stream.thread_data,
+        Direction::In,
+        [this, &worker, tuple] {
+            Stream &s = worker.streams.at(tuple);
+            TCPConnection &tcp = *worker.demux->connection(tuple);
+            Buffer data = s.thread_data.read(tcp.remaining_outbound_capacity());
+            const auto len = data.size();
+            _tick(worker);
+            if (tcp.write(move(data)) != len) {
+                throw runtime_error("TCPConnection::write() accepted less than advertised length");
+            }
+            if (s.thread_data.eof()) {
+                tcp.end_input_stream();
+                s.outbound_shutdown = true;
+            }
+            worker.demux->connection_updated(tuple);
+        },
+        [&worker, tuple] {
+            const TCPConnection *tcp = worker.demux->connection(tuple);
+            return tcp and tcp->active() and not worker.streams.at(tuple).outbound_shutdown and
+                   tcp->remaining_outbound_capacity() > 0;
+        },
+        [&worker, tuple] {
+            const auto it = worker.streams.find(tuple);
+            TCPConnection *tcp = worker.demux->connection(tuple);
+            if (it != worker.streams.end() and tcp) {
+                tcp->end_input_stream();
+                it->second.outbound_shutdown = true;
+                worker.demux->connection_updated(tuple);
+            }
+        });
+
+    // write the connection's inbound stream to the owner
+    worker.eventloop.add_rule(
+        stream.thread_data,
+        Direction::Out,
+        [&worker, tuple] {
+            Stream &s = worker.streams.at(tuple);
+            ByteStream &inbound = worker.demux->connection(tuple)->inbound_stream();
+            const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
+            const auto bytes_written = s.thread_data.write(inbound.peek_buffers(amount_to_write), false);
+            inbound.pop_output(bytes_written);
+
+            if (inbound.eof() or inbound.error()) {
+                s.thread_data.shutdown(SHUT_WR);
+                s.inbound_shutdown = true;
+            }
+        },
+        [&worker, tuple] {
+            TCPConnection *tcp = worker.demux->connection(tuple);
+            if (not tcp) {
+                return false;
+            }
+            const ByteStream &inbound = tcp->inbound_stream();
+            return (not inbound.buffer_empty()) or
+                   ((inbound.eof() or inbound.error()) and not worker.streams.at(tuple).inbound_shutdown);
+        });
+}
+
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::_add_datagram_rules(Worker &worker) {
+    // read datagrams and hand their segments to the demultiplexer
+    worker.eventloop.add_rule(worker.datagram_adapter, Direction::In, [this, &worker] {
+        const auto ip_dgram = worker.datagram_adapter.read_datagram();
+        if (not ip_dgram.has_value()) {
+            return;
+        }
+        TCPFourTuple tuple;
+        auto seg = TCPOverIPv4Adapter::parse_tcp_in_ip(ip_dgram.value(), tuple);
+        if (seg.has_value()) {
+            _tick(worker);  // so that the segment is processed at the right time
+            worker.demux->segment_received(tuple, move(seg.value()));
+        }
+    });
+
+    // send the segments of every connection
+    worker.eventloop.add_rule(
+        worker.datagram_adapter,
+        Direction::Out,
+        [&worker] {
+            while (not worker.demux->segments_out().empty()) {
+                auto &[tuple, seg] = worker.demux->segments_out().front();
+                worker.datagram_adapter.write_datagram(TCPOverIPv4Adapter::wrap_tcp_in_ip(seg, tuple));
+                worker.demux->segments_out().pop();
+            }
+        },
+        [&worker] { return not worker.demux->segments_out().empty(); });
+
+    // wake up when the owner sets _abort or starts waiting in accept()
+    worker.eventloop.add_rule(
+        worker.wake_signal, Direction::In, [&worker] { worker.wake_signal.read(sizeof(uint64_t)); });
+}
+
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::_hand_off_connections(Worker &worker) {
+    lock_guard<mutex> lock(_mutex);
+    while (_accepted.size() < _accepts_waiting) {
+        const auto tuple = worker.demux->accept();
+        if (not tuple.has_value()) {
+            break;
+        }
+
+        auto [owner_end, thread_end] = socket_pair_helper(SOCK_STREAM);
+        LocalStreamSocket thread_data{move(thread_end)};
+        thread_data.set_blocking(false);
+        worker.streams.emplace(tuple.value(), Stream{move(thread_data)});
+        _add_stream_rules(worker, tuple.value());
+
+        _accepted.emplace(LocalStreamSocket{move(owner_end)}, tuple->remote());
+        _accept_cv.notify_all();
+    }
+}
+
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::_reap_connections(Worker &worker) {
+    for (auto it = worker.streams.begin(); it != worker.streams.end();) {
+        const TCPConnection *tcp = worker.demux->connection(it->first);
+        if (tcp and (tcp->active() or not it->second.inbound_shutdown)) {
+            ++it;
+            continue;
+        }
+
+        // closing the stream socket cancels its rules
+        it->second.thread_data.close();
+        worker.demux->erase(it->first);
+        it = worker.streams.erase(it);
+    }
+}
+
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::_tcp_main(Worker &worker) {
+    try {
+        while (not _abort) {
+            _tick(worker);
+            _hand_off_connections(worker);
+            _reap_connections(worker);
+            _schedule_tick(worker);
+
+            if (worker.eventloop.wait_next_event(-1) == EventLoop::Result::Exit) {
+                break;
+            }
+        }
+
+        // reset whatever is still open
+        vector<TCPFourTuple> open_connections;
+        worker.demux->for_each(
+            [&](const TCPFourTuple &tuple, TCPConnection &) { open_connections.push_back(tuple); });
+        for (const auto &tuple : open_connections) {
+            worker.demux->erase(tuple);
+        }
+        while (not worker.demux->segments_out().empty()) {
+            auto &[tuple, seg] = worker.demux->segments_out().front();
+            worker.datagram_adapter.write_datagram(TCPOverIPv4Adapter::wrap_tcp_in_ip(seg, tuple));
+            worker.demux->segments_out().pop();
+        }
+    } catch (const exception &e) {
+        cerr << "Exception in TCPSpongeServer thread: " << e.what() << "\n";
+    }
+
+    lock_guard<mutex> lock(_mutex);
+    _stopped++;
+    _accept_cv.notify_all();
+}
+
+//! \param[in] c_tcp is the TCPConfig for every TCPConnection
+//! \param[in] c_ad is the FdAdapterConfig for the adapters; its `source` is the address to listen on
+//! \param[in] backlog is the most connections that may be half-open or waiting to be accepted at once, on
+//! each queue
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::listen(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad, const size_t backlog) {
+    if (_workers.front()->demux) {
+        throw runtime_error("listen() with TCPSpongeServer already listening");
+    }
+
+    for (auto &worker : _workers) {
+        worker->datagram_adapter.config_mut() = c_ad;
+        worker->demux.emplace(with_mss_for_mtu<AdaptT>(c_tcp, c_ad));
+        worker->base_time = timestamp_ms();
+        worker->demux->listen(c_ad.source.ipv4_numeric(), c_ad.source.port(), backlog);
+        _add_datagram_rules(*worker);
+    }
+
+    cerr << "DEBUG: Listening for incoming connections on " << c_ad.source.to_string() << " with "
+         << _workers.size() << " queue(s)...\n";
+    for (auto &worker : _workers) {
+        worker->tcp_thread = thread(&TCPSpongeServer::_tcp_main, this, ref(*worker));
+    }
+}
+
+template <typename AdaptT>
+pair<LocalStreamSocket, Address> TCPSpongeServer<AdaptT>::accept() {
+    unique_lock<mutex> lock(_mutex);
+    if (not _workers.front()->demux) {
+        throw runtime_error("accept() before listen()");
+    }
+
+    // a connection may already be waiting to be handed off, by any of the TCP threads
+    _accepts_waiting++;
+    for (auto &worker : _workers) {
+        raise_wake_signal(worker->wake_signal);
+    }
+    _accept_cv.wait(lock, [&] { return _stopped == _workers.size() or not _accepted.empty(); });
+    _accepts_waiting--;
+    if (_accepted.empty()) {
+        throw runtime_error("accept(): TCPSpongeServer has stopped");
+    }
+
+    auto ret = move(_accepted.front());
+    _accepted.pop();
+    return ret;
+}
+
+//! \details An accept() waiting in another thread wakes once the last TCP thread has exited, and throws.
+template <typename AdaptT>
+void TCPSpongeServer<AdaptT>::stop() {
+    _abort.store(true);
+    for (auto &worker : _workers) {
+        if (worker->tcp_thread.joinable()) {
+            raise_wake_signal(worker->wake_signal);
+            worker->tcp_thread.join();
+        }
+    }
+}
+
+template <typename AdaptT>
+TCPSpongeServer<AdaptT>::~TCPSpongeServer() {
+    try {
+        stop();
+    } catch (const exception &e) {
+        cerr << "Exception destructing TCPSpongeServer: " << e.what() << endl;
+    }
+}
+
+//! Specialization of TCPSpongeServer for TCPOverIPv4OverTunFdAdapter
+template class TCPSpongeServer<TCPOverIPv4OverTunFdAdapter>;
+
+//! Specialization of TCPSpongeServer for TCPOverIPv4OverEthernetAdapter
+template class TCPSpongeServer<TCPOverIPv4OverEthernetAdapter>;
+
 //! Specialization of TCPSpongeSocket for TCPOverUDPSocketAdapter
 template class TCPSpongeSocket<TCPOverUDPSocketAdapter>;
 
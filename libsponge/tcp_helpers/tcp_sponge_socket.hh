@@ -8,12 +8,19 @@
 #include "network_interface.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
+#include "tcp_demultiplexer.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <queue>
 #include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 //! Multithreaded wrapper around TCPConnection that approximates the Unix sockets API
@@ -37,6 +44,18 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
+    //! Time at which the TCPConnection was last ticked
+    uint64_t _base_time{0};
+
+    //! Timer for the TCPConnection's next timeout, if one is running
+    std::optional<EventLoop::TimerId> _tick_timer{};
+
+    //! Tell the TCPConnection and adapter how much time has passed since they were last told
+    void _tick();
+
+    //! Set _tick_timer to go off at the TCPConnection's next timeout
+    void _schedule_tick();
+
     //! Process events while specified condition is true
     void _tcp_loop(const std::function<bool()> &condition);
 
@@ -51,6 +70,8 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     std::atomic_bool _abort{false};  //!< Flag used by the owner to force the TCPConnection thread to shut down
 
+    FileDescriptor _wake_signal;  //!< Written by the owner after setting _abort, to wake the TCPConnection thread
+
     bool _inbound_shutdown{false};  //!< Has TCPSpongeSocket shut down the incoming data to the owner?
 
     bool _outbound_shutdown{false};  //!< Has the owner shut down the outbound data to the TCP connection?
@@ -117,12 +138,143 @@ using LossyTCPOverIPv4SpongeSocket = TCPSpongeSocket<LossyTCPOverIPv4OverTunFdAd
 //!
 //! There are a few notable differences between the TCPSpongeSocket and TCPSocket interfaces:
 //!
-//! - a TCPSpongeSocket can only accept a single connection
+//! - a TCPSpongeSocket can only accept a single connection (see TCPSpongeServer for more)
 //! - listen_and_accept() is a blocking function call that acts as both [listen(2)](\ref man2::listen)
 //!   and [accept(2)](\ref man2::accept)
 //! - if TCPSpongeSocket is destructed while a TCP connection is open, the connection is
 //!   immediately terminated with a RST (call `wait_until_closed` to avoid this)
 
+//! Many TCP connections over one IPv4 adapter (or one per queue of a device), accepted like a (kernel)
+//! listening socket's
+template <typename AdaptT>
+class TCPSpongeServer {
+  private:
+    //! The TCP thread's end of an accepted connection's stream socket
+    struct Stream {
+        LocalStreamSocket thread_data;  //!< Stream socket for reads and writes between owner and TCP thread
+        bool inbound_shutdown{false};   //!< Has the incoming data to the owner been shut down?
+        bool outbound_shutdown{false};  //!< Has the owner shut down the outbound data?
+    };
+
+    //! An adapter, the connections whose datagrams arrive on it, and the TCP thread that runs them
+    struct Worker {
+        //! Adapter to the underlying device (or one of its queues), read and written as IPv4 datagrams
+        AdaptT datagram_adapter;
+
+        //! The connections, by four-tuple
+        std::optional<TCPDemultiplexer> demux{};
+
+        //! eventloop that handles the datagrams of every connection, and the streams of those accepted
+        EventLoop eventloop{EventLoop::Backend::Epoll};
+
+        //! Streams of the accepted connections
+        std::unordered_map<TCPFourTuple, Stream, TCPFourTupleHash> streams{};
+
+        //! Written by the owner to wake the TCP thread (after setting _abort, or in accept())
+        FileDescriptor wake_signal;
+
+        //! Handle to the TCP thread; owner thread calls join() in the destructor
+        std::thread tcp_thread{};
+
+        //! Time at which the connections were last ticked
+        uint64_t base_time{0};
+
+        //! Timer for the earliest timeout of any connection, if one is running
+        std::optional<EventLoop::TimerId> tick_timer{};
+
+        //! Construct from the adapter the TCP thread will read and write datagrams with
+        explicit Worker(AdaptT &&adapter);
+    };
+
+    //! One per adapter (kept by pointer, since their TCP threads refer to them)
+    std::vector<std::unique_ptr<Worker>> _workers{};
+
+    //! \name State shared by the owner and the TCP threads
+    //!@{
+    std::mutex _mutex{};                                           //!< Protects the members below
+    std::condition_variable _accept_cv{};                          //!< Signaled when a connection is handed off
+    size_t _accepts_waiting{0};                                    //!< Number of accept() calls waiting
+    std::queue<std::pair<LocalStreamSocket, Address>> _accepted{};  //!< Connections handed to accept()
+    size_t _stopped{0};                                            //!< Number of TCP threads that have exited
+    //!@}
+
+    std::atomic_bool _abort{false};  //!< Flag used by the owner to force the TCP threads to shut down
+
+    //! Tell a worker's connections and adapter how much time has passed since they were last told
+    void _tick(Worker &worker);
+
+    //! Set a worker's tick_timer to go off at the earliest timeout of any of its connections
+    void _schedule_tick(Worker &worker);
+
+    //! Add the event loop rules that move data between an accepted connection and its stream socket
+    void _add_stream_rules(Worker &worker, const TCPFourTuple &tuple);
+
+    //! Add the event loop rules that move datagrams between a worker's adapter and its connections
+    void _add_datagram_rules(Worker &worker);
+
+    //! Give a worker's established connections to the accept() calls that are waiting for them
+    void _hand_off_connections(Worker &worker);
+
+    //! Forget a worker's connections that have closed, once everything they received has been delivered
+    void _reap_connections(Worker &worker);
+
+    //! Main loop of a worker's TCP thread
+    void _tcp_main(Worker &worker);
+
+  public:
+    //! Construct from the interface that the TCP thread will use to read and write datagrams
+    explicit TCPSpongeServer(AdaptT &&datagram_interface);
+
+    //! Construct from one interface per queue of a multiqueue device (see TunFD::open_queues), each with a
+    //! TCP thread of its own
+    explicit TCPSpongeServer(std::vector<AdaptT> &&queue_interfaces);
+
+    //! Start accepting connections to `c_ad.source` in the background, with at most `backlog` not yet accepted
+    //! on each queue
+    void listen(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad, const size_t backlog);
+
+    //! Wait for an established connection, from any queue
+    //! \returns a stream socket for the connection's data, and the peer's address
+    std::pair<LocalStreamSocket, Address> accept();
+
+    //! Number of queues, each with a TCP thread
+    size_t queue_count() const { return _workers.size(); }
+
+    //! Stop the TCP threads, resetting the connections still open; accept() then throws instead of waiting
+    void stop();
+
+    //! Stops the TCP threads (see stop())
+    ~TCPSpongeServer();
+
+    //! \name
+    //! This object cannot be safely moved or copied, since it is in use by several threads simultaneously
+
+    //!@{
+    TCPSpongeServer(const TCPSpongeServer &) = delete;
+    TCPSpongeServer(TCPSpongeServer &&) = delete;
+    TCPSpongeServer &operator=(const TCPSpongeServer &) = delete;
+    TCPSpongeServer &operator=(TCPSpongeServer &&) = delete;
+    //!@}
+};
+
+using TCPOverIPv4SpongeServer = TCPSpongeServer<TCPOverIPv4OverTunFdAdapter>;
+using TCPOverIPv4OverEthernetSpongeServer = TCPSpongeServer<TCPOverIPv4OverEthernetAdapter>;
+
+//! \class TCPSpongeServer
+//! Like TCPSpongeSocket, this class involves two threads, but its TCP thread runs any number of
+//! connections: a TCPDemultiplexer sorts the datagrams read from the adapter by four-tuple, and one
+//! event loop serves the adapter and the stream sockets of every accepted connection.
+//!
+//! Given the queues of a multiqueue TUN or TAP device, it runs a TCP thread, demultiplexer and event loop
+//! per queue, sharing nothing but the connections waiting to be accepted. The kernel hashes each flow to a
+//! queue (and keeps it on the queue its datagrams are written to), so every datagram of a connection is
+//! read, and its replies written, by the same thread.
+//!
+//! The owner calls listen() once, then accept() for each connection. accept() returns the owner's end
+//! of a stream socket; shutting down its write side ends the outbound stream (sending a FIN), and it reads
+//! EOF once the peer has finished sending. A connection is forgotten once it is closed and its data has
+//! been delivered.
+
 //! Helper class that makes a TCPOverIPv4SpongeSocket behave more like a (kernel) TCPSocket
 class CS144TCPSocket : public TCPOverIPv4SpongeSocket {
   public:
@@ -16,10 +16,16 @@ TCPOverIPv4OverEthernetAdapter::TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
     _tap.write(dummy_frame.serialize());
 }
 
-optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
+optional<InternetDatagram> TCPOverIPv4OverEthernetAdapter::read_datagram() {
     // Read Ethernet frame from the raw device
+    return _recv_frame(_read_packet(_tap));
+}
+
+//! \param[in] frame_bytes is the frame as read from the raw device
+//! \returns the Internet datagram the frame carried, if any
+optional<InternetDatagram> TCPOverIPv4OverEthernetAdapter::_recv_frame(const Buffer frame_bytes) {
     EthernetFrame frame;
-    if (frame.parse(_tap.read()) != ParseResult::NoError) {
+    if (frame.parse(frame_bytes) != ParseResult::NoError) {
         return {};
     }
 
@@ -29,13 +35,42 @@ optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     // The incoming frame may have caused the NetworkInterface to send a frame.
     send_pending();
 
+    return ip_dgram;
+}
+
+optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
+    // Skip parsing IPv4 frames that can't be for this connection (but ARP frames always go to the NetworkInterface)
+    Buffer frame_bytes = _read_packet(_tap);
+    const EthernetHeaderView ethernet_header{frame_bytes};
+    if (ethernet_header.valid() and ethernet_header.type() == EthernetHeader::TYPE_IPv4 and
+        not may_unwrap(ethernet_header.payload())) {
+        return {};
+    }
+
     // Try to interpret IPv4 datagram as TCP
+    const optional<InternetDatagram> ip_dgram = _recv_frame(move(frame_bytes));
     if (ip_dgram) {
         return unwrap_tcp_in_ip(ip_dgram.value());
     }
     return {};
 }
 
+//! \param[out] segments receives the segment, if the frame carried one
+void TCPOverIPv4OverEthernetAdapter::read_batch(vector<TCPSegment> &segments) {
+    auto seg = read();
+    if (seg.has_value()) {
+        segments.push_back(move(seg.value()));
+    }
+}
+
+//! \param[in,out] segments are the TCP segments to send, which are popped as they are sent
+void TCPOverIPv4OverEthernetAdapter::write_batch(queue<TCPSegment> &segments) {
+    while (not segments.empty()) {
+        write(segments.front());
+        segments.pop();
+    }
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
     _interface.tick(ms_since_last_tick);
@@ -43,8 +78,11 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
 }
 
 //! \param[in] seg the TCPSegment to send
-void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) { write_datagram(wrap_tcp_in_ip(seg)); }
+
+//! \param[in] ip_dgram the IPv4 datagram to send
+void TCPOverIPv4OverEthernetAdapter::write_datagram(const InternetDatagram &ip_dgram) {
+    _interface.send_datagram(ip_dgram, _next_hop);
     send_pending();
 }
 
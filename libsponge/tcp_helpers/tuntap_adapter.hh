@@ -6,8 +6,10 @@
 #include "tun.hh"
 
 #include <optional>
+#include <queue>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TUN device
 class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
@@ -18,17 +20,56 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     //! Construct from a TunFD
     explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
 
+    //! Attempts to read and parse an IPv4 datagram, whichever connection it belongs to
+    std::optional<InternetDatagram> read_datagram() {
+        InternetDatagram ip_dgram;
+        if (ip_dgram.parse(_read_packet(_tun)) != ParseResult::NoError) {
+            return {};
+        }
+        return ip_dgram;
+    }
+
+    //! Writes an IPv4 datagram to the TUN device
+    void write_datagram(const InternetDatagram &ip_dgram) { _tun.write(ip_dgram.serialize()); }
+
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
     std::optional<TCPSegment> read() {
+        Buffer datagram = _read_packet(_tun);
+        if (not may_unwrap(datagram)) {
+            return {};
+        }
         InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
+        if (ip_dgram.parse(std::move(datagram)) != ParseResult::NoError) {
             return {};
         }
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Writes a TCP segment, in an IPv4 datagram, to the TUN device; the headers are serialized on the stack
+    //! and written ahead of the payload, which isn't copied
+    void write(TCPSegment &seg) {
+        Headroom headroom;
+        serialize_tcp_in_ip(seg, headroom);
+        BufferViewList datagram{seg.payload().str()};
+        datagram.prepend(headroom.str());
+        _tun.write(datagram);
+    }
+
+    //! Like read(), appending the segment (if any) to `segments`; a TUN device gives one datagram per read
+    void read_batch(std::vector<TCPSegment> &segments) {
+        auto seg = read();
+        if (seg.has_value()) {
+            segments.push_back(std::move(seg.value()));
+        }
+    }
+
+    //! Writes every TCP segment in `segments` (emptying it)
+    void write_batch(std::queue<TCPSegment> &segments) {
+        while (not segments.empty()) {
+            write(segments.front());
+            segments.pop();
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -51,18 +92,33 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
 
     void send_pending();  //!< Sends any pending Ethernet frames
 
+    //! Parses a serialized Ethernet frame and gives it to the NetworkInterface
+    std::optional<InternetDatagram> _recv_frame(const Buffer frame_bytes);
+
   public:
     //! Construct from a TapFD
     explicit TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
                                             const EthernetAddress &eth_address,
                                             const Address &ip_address,
                                             const Address &next_hop);
+    //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram, whichever connection it belongs to
+    std::optional<InternetDatagram> read_datagram();
+
+    //! Sends an IPv4 datagram (in an Ethernet frame) to the next hop
+    void write_datagram(const InternetDatagram &ip_dgram);
+
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
+    //! Like read(), appending the segment (if any) to `segments`; a TAP device gives one frame per read
+    void read_batch(std::vector<TCPSegment> &segments);
+
+    //! Sends every TCP segment in `segments` (emptying it)
+    void write_batch(std::queue<TCPSegment> &segments);
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
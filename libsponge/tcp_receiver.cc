@@ -2,6 +2,8 @@
 
 #include "tcp_header.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -39,9 +41,20 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         return;
     }
 
+    // RFC 7323 section 4.3: remember the TSval to echo, but not from segments that arrived ahead of a hole,
+    // so that the peer's RTT samples include the time it took to fill the hole
+    const bool reaches_ackno = abs_seqno <= _reassembler.stream_out().bytes_written() + 1;
+    if (header.options.timestamps.has_value() and reaches_ackno) {
+        const uint32_t tsval = header.options.timestamps.value().value;
+        if (not _ts_recent.has_value() or static_cast<int32_t>(tsval - _ts_recent.value()) >= 0) {
+            _ts_recent = tsval;
+        }
+    }
+
     // Push the segment's payload into the reassembler
-    _reassembler.push_substring(payload.copy(), abs_seqno - 1, header.fin);
+    _reassembler.push_substring(payload, abs_seqno - 1, header.fin);
     _checkpoint = abs_seqno;  // Update the checkpoint to the current absolute sequence number.
+    _last_segment_index = abs_seqno - 1;
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -59,4 +72,30 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
     return {};  // Return an empty optional if SYN has not been received.
 }
 
+vector<TCPSACKBlock> TCPReceiver::sack_blocks() const {
+    vector<TCPSACKBlock> blocks;
+    if (not _isn.has_value()) {
+        return blocks;
+    }
+
+    // stream index i has absolute sequence number i + 1
+    const auto to_block = [&](const pair<uint64_t, uint64_t> &range) {
+        return TCPSACKBlock{wrap(range.first + 1, _isn.value()), wrap(range.second + 1, _isn.value())};
+    };
+    const auto ranges = _reassembler.unassembled_ranges();
+    const auto most_recent = find_if(ranges.begin(), ranges.end(), [&](const auto &range) {
+        return range.first <= _last_segment_index and _last_segment_index < range.second;
+    });
+
+    if (most_recent != ranges.end()) {
+        blocks.push_back(to_block(*most_recent));
+    }
+    for (auto it = ranges.begin(); it != ranges.end() and blocks.size() < TCPOptions::MAX_SACK_BLOCKS; ++it) {
+        if (it != most_recent) {
+            blocks.push_back(to_block(*it));
+        }
+    }
+    return blocks;
+}
+
 size_t TCPReceiver::window_size() const { return _capacity - _reassembler.stream_out().buffer_size(); }
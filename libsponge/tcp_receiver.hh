@@ -23,6 +23,12 @@ class TCPReceiver {
     std::optional<WrappingInt32> _isn = {};
     uint64_t _checkpoint = 0;
 
+    //! Stream index of the first byte of the most recently received segment
+    uint64_t _last_segment_index = 0;
+
+    //! TSval of the latest segment that didn't arrive ahead of the ackno ("TS.Recent" in RFC 7323)
+    std::optional<uint32_t> _ts_recent = {};
+
   public:
     //! \brief Construct a TCP receiver
     //!
@@ -51,6 +57,16 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief [SACK](https://www.rfc-editor.org/rfc/rfc2018) blocks for the data held beyond the ackno
+    //!
+    //! The block holding the most recently received segment comes first, and the rest follow in
+    //! sequence order, up to TCPOptions::MAX_SACK_BLOCKS.
+    std::vector<TCPSACKBlock> sack_blocks() const;
+
+    //! \brief The timestamp to echo in the TSecr of the Timestamps option
+    //! \returns empty if no segment with a Timestamps option has been accepted
+    std::optional<uint32_t> timestamp_echo() const { return _ts_recent; }
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
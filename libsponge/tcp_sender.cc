@@ -4,7 +4,9 @@
 #include "wrapping_integers.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <random>
 
 // Dummy implementation of a TCP sender
@@ -20,20 +22,35 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] congestion_control the congestion control algorithm to use
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const CongestionControl congestion_control)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
     , _current_retransmission_timeout{_initial_retransmission_timeout}
     , _stream(capacity)
-    , _timer(retx_timeout) {}
+    , _timer(retx_timeout)
+    , _congestion_control(congestion_control)
+    , _congestion_controller(CongestionController::make(congestion_control, _mss)) {}
+
+//! \param[in] config supplies the capacity, initial RTO, ISN, MSS, congestion control and RTO adaptation
+TCPSender::TCPSender(const TCPConfig &config)
+    : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn, config.congestion_control) {
+    set_mss(config.mss);
+    if (config.adaptive_rto) {
+        _rtt_estimator.emplace(config.rt_timeout, config.rto_min, config.rto_max);
+    }
+}
 
 uint64_t TCPSender::bytes_in_flight() const { return _next_seqno - _base_seqno; }
 
 void TCPSender::fill_window() {
     size_t nread;
     uint64_t bytes_sent;  // count is in "sequence space" i.e. SYN and FIN each count for one byte
-    string data;
-    size_t end_seqno = _base_seqno + _window_size;
+    // Never exceed the congestion window either, but keep probing a zero receive window as before.
+    size_t end_seqno = _base_seqno + min(_window_size, congestion_window());
 
     if (_window_size == 0) {
         end_seqno += 1;
@@ -70,8 +87,11 @@ void TCPSender::fill_window() {
     while (_next_seqno < end_seqno) {
         TCPSegment seg;
         size_t remaining_window_size = end_seqno - _next_seqno;
-        data = _stream.read(min(remaining_window_size, TCPConfig::MAX_PAYLOAD_SIZE));
+        // Slice the payload out of the stream's chunks instead of copying it into a new string.
+        // Only a payload that straddles two chunks needs to be concatenated.
+        const BufferList data = _stream.peek_buffers(min(remaining_window_size, _mss));
         nread = data.size();
+        _stream.pop_output(nread);
 
         if (_next_seqno == 0) {  // No byte has been sent yet.
             seg.header().syn = true;
@@ -87,7 +107,7 @@ void TCPSender::fill_window() {
         }
 
         seg.header().seqno = wrap(_next_seqno, _isn);
-        seg.payload() = Buffer(std::move(data));
+        seg.payload() = data.buffers().size() > 1 ? Buffer(data.concatenate()) : Buffer(data);
         bytes_sent = seg.length_in_sequence_space();
         if (bytes_sent == 0) {
             break;  // There is no data to send.
@@ -99,7 +119,7 @@ void TCPSender::fill_window() {
         }
 
         _segments_out.push(seg);
-        _outstanding_segments.push(seg);
+        _outstanding_segments.push_back({seg, _next_seqno, _time_ms});
 
         _next_seqno += bytes_sent;
     }
@@ -107,11 +127,21 @@ void TCPSender::fill_window() {
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param carries_data Whether the segment carrying the ack occupied any sequence space
+//! \param sack_blocks The SACK blocks carried by the segment
+//! \param timestamp_echo The TSecr of the segment, which gives an RTT sample even for retransmitted data
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const size_t window_size,
+                             const bool carries_data,
+                             const vector<TCPSACKBlock> &sack_blocks,
+                             const optional<uint32_t> timestamp_echo) {
     uint64_t abs_ackno = unwrap(ackno, _isn, _next_seqno);
     uint64_t abs_seqno;
     uint64_t bytes_length;
+    uint64_t bytes_acked = 0;
     bool has_new_data_received = false;
+    std::optional<uint64_t> rtt_sample{};
+    bool rtt_ambiguous = false;
 
     if (0 == abs_ackno || abs_ackno > _next_seqno) {
         // Since the absolute seqno of SYN is 0, the absolute ackno must bigger than 0.
@@ -120,7 +150,8 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     }
 
     while (!_outstanding_segments.empty()) {  // Check whether there is any outstanding data acknowledged
-        const TCPSegment seg = _outstanding_segments.front();
+        const OutstandingSegment &outstanding = _outstanding_segments.front();
+        const TCPSegment &seg = outstanding.segment;
         abs_seqno = unwrap(seg.header().seqno, _isn, abs_ackno);
         bytes_length = seg.length_in_sequence_space();
         if (abs_seqno + bytes_length > abs_ackno) {
@@ -128,15 +159,74 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
             // there is no need to check following outstanding data.
             break;
         }
-        _outstanding_segments.pop();
+        // Karn's algorithm: an ack that covers a retransmitted segment yields no RTT sample
+        rtt_ambiguous |= outstanding.retransmitted;
+        rtt_sample = _time_ms - outstanding.sent_ms;
+        _outstanding_segments.pop_front();
         _base_seqno += bytes_length;
+        bytes_acked += bytes_length;
         has_new_data_received = true;
     }
 
+    _update_scoreboard(sack_blocks);
+
     if (has_new_data_received) {
-        _current_retransmission_timeout = _initial_retransmission_timeout;
+        _duplicate_acks = 0;
+        if (!_in_fast_recovery) {
+            if (_congestion_controller) {
+                _congestion_controller->on_ack(bytes_acked);
+            }
+        } else if (abs_ackno >= _recover) {  // full ack: everything sent before recovery began has arrived
+            _in_fast_recovery = false;
+            _congestion_controller->on_recovery_exit();
+        } else {
+            // partial ack: without SACK the next hole must be lost too, so resend it without waiting for
+            // three more dupacks; with SACK, it is treated like a dupack (RFC 6675 section 5, step C),
+            // since the segments after it may be arriving right behind this ack
+            _retransmit_next_hole(!_sack);
+            _congestion_controller->on_partial_ack(bytes_acked);
+        }
+        if (!_in_fast_recovery && _sack && abs_ackno < _recover) {
+            // after a timeout, the SACK blocks tell which of the segments sent before it are still
+            // missing, so repair them as acks return instead of waiting for a timeout each
+            _retransmit_next_hole(false);
+        }
+        if (timestamp_echo.has_value()) {
+            // RFC 7323 section 4: the echoed timestamp tells exactly which transmission is being acked
+            rtt_sample = static_cast<uint32_t>(timestamp() - timestamp_echo.value());
+            rtt_ambiguous = false;
+        }
+        if (_rtt_estimator) {
+            // Karn's algorithm: a backed-off RTO is kept until an unambiguous sample replaces it
+            if (rtt_sample.has_value() && !rtt_ambiguous) {
+                _rtt_estimator->add_sample(rtt_sample.value());
+                _current_retransmission_timeout = _rtt_estimator->rto();
+            }
+        } else {
+            _current_retransmission_timeout = _initial_retransmission_timeout;
+        }
         _timer.start(_current_retransmission_timeout);
         _n_consecutive_retransimissions = 0;
+    } else if (_congestion_controller && _is_duplicate_ack(abs_ackno, window_size, carries_data)) {
+        // Fast retransmit and fast recovery are part of congestion control (RFC 5681 section 3.2),
+        // so without a controller repeated acks are ignored and only the timer retransmits.
+        _duplicate_acks++;
+        if (_in_fast_recovery) {
+            // each further duplicate means another segment has left the network; with SACK we also
+            // know which of the segments below the highest SACKed one are missing
+            _congestion_controller->on_duplicate_ack();
+            _retransmit_next_hole(false);
+        } else if (_duplicate_acks == TCPConfig::DUP_ACK_THRESHOLD && abs_ackno >= _recover) {
+            // The ackno check keeps the duplicates caused by an earlier recovery or timeout
+            // from starting another one (RFC 6582 section 3.2, step 2).
+            _in_fast_recovery = true;
+            _recover = _next_seqno;
+            // segments resent since the last timeout may still be on their way, so only a timeout
+            // (not another recovery) sends them again
+            _high_rxt = max(_high_rxt, _base_seqno);
+            _retransmit_next_hole(true);
+            _congestion_controller->on_fast_retransmit(bytes_in_flight());
+        }
     }
 
     if (_outstanding_segments.empty()) {
@@ -147,21 +237,45 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     fill_window();
 }
 
+optional<size_t> TCPSender::time_until_timeout() const {
+    if (!_timer.is_running()) {
+        return {};
+    }
+    return _timer.time_remaining();
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    _time_ms += ms_since_last_tick;
+    if (_congestion_controller) {
+        _congestion_controller->tick(ms_since_last_tick);
+    }
     if (!_timer.is_running()) {
         return;
     }
     _timer.elapsed(ms_since_last_tick);
     if (_timer.is_timeout()) {
         // cerr << "[sender] Time out start" << endl;
-        TCPSegment retransmitted_seg = _outstanding_segments.front();
-        _segments_out.push(retransmitted_seg);
+        if (_window_size) {
+            // the segments retransmitted before the timeout may have been lost again
+            _high_rxt = _base_seqno;
+        }
+        _retransmit(_outstanding_segments.front());
 
         if (_window_size) {
+            // A zero-window probe going unanswered says nothing about congestion, but this does.
+            if (_congestion_controller) {
+                _congestion_controller->on_timeout(bytes_in_flight());
+            }
+            _in_fast_recovery = false;
+            _duplicate_acks = 0;
+            _recover = _next_seqno;
             _n_consecutive_retransimissions++;
             // cerr << "[sender] retx: " << _n_consecutive_retransimissions << endl;
             _current_retransmission_timeout *= 2;
+            if (_rtt_estimator) {
+                _current_retransmission_timeout = min(_current_retransmission_timeout, _rtt_estimator->rto_max());
+            }
         }
 
         _timer.start(_current_retransmission_timeout);
@@ -169,11 +283,108 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
     }
 }
 
+//! \details An ack is a duplicate (RFC 5681 section 2) if data is outstanding, the segment carrying it
+//! has no data, SYN or FIN, and it repeats both the highest ackno and the window seen so far.
+bool TCPSender::_is_duplicate_ack(const uint64_t abs_ackno, const size_t window_size, const bool carries_data) const {
+    return !carries_data && !_outstanding_segments.empty() && abs_ackno == _base_seqno && window_size == _window_size;
+}
+
+void TCPSender::_retransmit(OutstandingSegment &outstanding) {
+    outstanding.retransmitted = true;
+    _high_rxt = max(_high_rxt, outstanding.abs_seqno + outstanding.segment.length_in_sequence_space());
+    _segments_out.push(outstanding.segment);
+}
+
+//! \details Blocks that don't lie within the outstanding data are ignored.
+void TCPSender::_update_scoreboard(const vector<TCPSACKBlock> &sack_blocks) {
+    for (const TCPSACKBlock &block : sack_blocks) {
+        const uint64_t left = unwrap(block.left, _isn, _next_seqno);
+        const uint64_t right = unwrap(block.right, _isn, _next_seqno);
+        if (left >= right || left < _base_seqno || right > _next_seqno) {
+            continue;
+        }
+        for (OutstandingSegment &outstanding : _outstanding_segments) {
+            const uint64_t end = outstanding.abs_seqno + outstanding.segment.length_in_sequence_space();
+            if (outstanding.abs_seqno >= right) {
+                break;
+            }
+            if (outstanding.abs_seqno >= left && end <= right) {
+                outstanding.sacked = true;
+            }
+        }
+    }
+}
+
+//! \param[in] front_is_lost whether the oldest outstanding segment is known to be lost regardless of
+//! the SACK information (on entering recovery, and on a partial ack without SACK)
+//! \details As in RFC 6675's IsLost(), a segment that hasn't been SACKed is taken to be lost once
+//! DUP_ACK_THRESHOLD segments after it have been, so that mild reordering doesn't cause retransmissions.
+//! Each hole is resent at most once per recovery, or per timeout.
+void TCPSender::_retransmit_next_hole(const bool front_is_lost) {
+    size_t sacked_above = count_if(_outstanding_segments.begin(),
+                                   _outstanding_segments.end(),
+                                   [](const OutstandingSegment &outstanding) { return outstanding.sacked; });
+    for (OutstandingSegment &outstanding : _outstanding_segments) {
+        if (outstanding.sacked) {
+            sacked_above--;
+            continue;
+        }
+        if (outstanding.abs_seqno < _high_rxt) {
+            continue;
+        }
+        const bool is_front = &outstanding == &_outstanding_segments.front();
+        if (sacked_above < TCPConfig::DUP_ACK_THRESHOLD && !(front_is_lost && is_front)) {
+            return;
+        }
+        _retransmit(outstanding);
+        return;
+    }
+}
+
+//! \param[in] mss the largest payload to send in one segment
+void TCPSender::set_mss(const size_t mss) {
+    _mss = mss;
+    _congestion_controller = CongestionController::make(_congestion_control, _mss);
+}
+
+//! \param[in] sack whether the peer sends SACK blocks (both SYNs offered SACK)
+void TCPSender::set_sack(const bool sack) { _sack = sack; }
+
 unsigned int TCPSender::consecutive_retransmissions() const { return _n_consecutive_retransimissions; }
 
+size_t TCPSender::congestion_window() const {
+    return _congestion_controller ? _congestion_controller->window() : numeric_limits<size_t>::max();
+}
+
+optional<unsigned int> TCPSender::smoothed_rtt() const {
+    return _rtt_estimator ? _rtt_estimator->srtt() : nullopt;
+}
+
 void TCPSender::send_empty_segment() {
     TCPSegment empy_segment;
     empy_segment.header().seqno = next_seqno();
     empy_segment.payload() = Buffer("");
     _segments_out.push(empy_segment);
 }
+
+//! \details The first sample sets SRTT = R and RTTVAR = R/2. Later ones update RTTVAR with the deviation
+//! from the old SRTT before folding R into SRTT. RTO = SRTT + max(G, K * RTTVAR), clamped to [min, max].
+void RTTEstimator::add_sample(const uint64_t rtt_ms) {
+    const double r = rtt_ms;
+    if (!_srtt.has_value()) {
+        _srtt = r;
+        _rttvar = r / 2;
+    } else {
+        _rttvar = (1 - BETA) * _rttvar + BETA * abs(_srtt.value() - r);
+        _srtt = (1 - ALPHA) * _srtt.value() + ALPHA * r;
+    }
+    const double rto = ceil(_srtt.value() + max(GRANULARITY, K * _rttvar));
+    _rto = clamp(static_cast<unsigned int>(rto), _rto_min, _rto_max);
+}
+
+optional<unsigned int> RTTEstimator::srtt() const {
+    if (!_srtt.has_value()) {
+        return nullopt;
+    }
+    return static_cast<unsigned int>(lround(_srtt.value()));
+}
@@ -2,11 +2,16 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_controller.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <vector>
 
 class Timer {
   private:
@@ -34,9 +39,47 @@ class Timer {
 
     size_t time_elapsed() const { return _ms_elapsed_time; }
 
-    bool is_running() { return _is_running; }
+    size_t time_remaining() const {
+        return _ms_elapsed_time >= _ms_timeout_threshold ? 0 : _ms_timeout_threshold - _ms_elapsed_time;
+    }
+
+    bool is_running() const { return _is_running; }
 
-    bool is_timeout() { return _ms_elapsed_time >= _ms_timeout_threshold; }
+    bool is_timeout() const { return _ms_elapsed_time >= _ms_timeout_threshold; }
+};
+
+//! \brief Round-trip time estimation and retransmission timeout calculation of [RFC 6298](\ref rfc::rfc6298)
+class RTTEstimator {
+  private:
+    static constexpr double ALPHA = 1.0 / 8;   //!< Gain of the smoothed RTT
+    static constexpr double BETA = 1.0 / 4;    //!< Gain of the RTT variation
+    static constexpr unsigned int K = 4;       //!< Weight of the RTT variation in the RTO
+    static constexpr double GRANULARITY = 1;   //!< Clock granularity (G), in milliseconds
+
+    std::optional<double> _srtt{};  //!< Smoothed RTT, unset until the first sample
+    double _rttvar{0};              //!< RTT variation
+    unsigned int _rto;              //!< Retransmission timeout, before any backoff
+    unsigned int _rto_min;
+    unsigned int _rto_max;
+
+  public:
+    //! \param[in] initial_rto the RTO to use until the first RTT sample arrives
+    //! \param[in] rto_min lower bound of the computed RTO
+    //! \param[in] rto_max upper bound of the RTO, including backoff
+    RTTEstimator(const unsigned int initial_rto, const unsigned int rto_min, const unsigned int rto_max)
+        : _rto(initial_rto), _rto_min(rto_min), _rto_max(rto_max) {}
+
+    //! \brief Updates SRTT, RTTVAR and the RTO with a new measurement
+    void add_sample(const uint64_t rtt_ms);
+
+    //! \brief Smoothed RTT in milliseconds, if a sample has been taken
+    std::optional<unsigned int> srtt() const;
+
+    //! \brief Retransmission timeout in milliseconds, before backoff
+    unsigned int rto() const { return _rto; }
+
+    //! \brief Upper bound of the backed-off RTO
+    unsigned int rto_max() const { return _rto_max; }
 };
 
 //! \brief The "sender" part of a TCP implementation.
@@ -50,10 +93,19 @@ class TCPSender {
     //! our initial sequence number, the number for our SYN.
     WrappingInt32 _isn;
 
+    //! a segment that has been sent but not yet acknowledged
+    struct OutstandingSegment {
+        TCPSegment segment{};
+        uint64_t abs_seqno{0};      //!< absolute sequence number of its first byte
+        uint64_t sent_ms{0};        //!< when it was first sent, for RTT measurement
+        bool retransmitted{false};  //!< its RTT is ambiguous once it has been sent twice (Karn's algorithm)
+        bool sacked{false};         //!< the receiver has reported holding it in a SACK block
+    };
+
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    std::queue<TCPSegment> _outstanding_segments{};
+    std::deque<OutstandingSegment> _outstanding_segments{};
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
@@ -63,6 +115,9 @@ class TCPSender {
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
 
+    //! largest payload to put in one segment
+    size_t _mss{TCPConfig::MAX_PAYLOAD_SIZE};
+
     /*
      * [0, _base_seqno)                             - Already acknowledged bytes
      * [_base_seqno, _next_seqno)                   - Sent, not yet acknowledged bytes
@@ -86,11 +141,53 @@ class TCPSender {
 
     unsigned int _n_consecutive_retransimissions{0};
 
+    //! duplicate acks received in a row (RFC 5681 section 2)
+    unsigned int _duplicate_acks{0};
+
+    //! whether the sender is in fast recovery
+    bool _in_fast_recovery{false};
+
+    //! _next_seqno when fast recovery last began or the timer last expired ("recover" in RFC 6582)
+    uint64_t _recover{0};
+
+    //! end of the last segment retransmitted since fast recovery began or the timer last expired
+    //! ("HighRxt" in RFC 6675)
+    uint64_t _high_rxt{0};
+
+    //! whether the peer's acks carry SACK blocks
+    bool _sack{false};
+
+    //! congestion control algorithm (nullptr if only the receiver's window limits us)
+    CongestionControl _congestion_control;
+    std::unique_ptr<CongestionController> _congestion_controller;
+
+    //! round-trip time estimator (unset if the RTO is always reset to the initial value)
+    std::optional<RTTEstimator> _rtt_estimator{};
+
+    //! milliseconds since the sender was created, as seen through tick()
+    uint64_t _time_ms{0};
+
+    //! \brief Resends an outstanding segment
+    void _retransmit(OutstandingSegment &outstanding);
+
+    //! \brief Marks the outstanding segments that the receiver reports holding
+    void _update_scoreboard(const std::vector<TCPSACKBlock> &sack_blocks);
+
+    //! \brief Resends the first segment past _high_rxt that is known to be lost
+    void _retransmit_next_hole(const bool front_is_lost);
+
+    //! \brief Does this ack count towards a fast retransmit?
+    bool _is_duplicate_ack(const uint64_t abs_ackno, const size_t window_size, const bool carries_data) const;
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const CongestionControl congestion_control = CongestionControl::None);
+
+    //! Initialize a TCPSender with the sender-side settings of a TCPConfig
+    explicit TCPSender(const TCPConfig &config);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -102,7 +199,23 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param[in] window_size the receiver's window, after any window scaling
+    //! \param[in] carries_data whether the acknowledging segment occupied any sequence space
+    //! (only acks without data can count as duplicate acks)
+    //! \param[in] sack_blocks the segment's SACK blocks, if SACK is in use
+    //! \param[in] timestamp_echo the segment's TSecr, if timestamps are in use
+    void ack_received(const WrappingInt32 ackno,
+                      const size_t window_size,
+                      const bool carries_data = false,
+                      const std::vector<TCPSACKBlock> &sack_blocks = {},
+                      const std::optional<uint32_t> timestamp_echo = std::nullopt);
+
+    //! \brief Limits the payload of each segment, e.g. to the MSS the peer announced in its SYN
+    //! \note This restarts congestion control from its initial window, so call it during the handshake.
+    void set_mss(const size_t mss);
+
+    //! \brief Uses the SACK blocks of acks to decide which segments are lost, once both SYNs have offered SACK
+    void set_sack(const bool sack);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -125,6 +238,24 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Congestion window, in bytes (unlimited if no congestion control is in use)
+    size_t congestion_window() const;
+
+    //! \brief Smoothed round-trip time in milliseconds (unset without an adaptive RTO or before the first sample)
+    std::optional<unsigned int> smoothed_rtt() const;
+
+    //! \brief Current retransmission timeout in milliseconds, including any backoff
+    unsigned int retransmission_timeout() const { return _current_retransmission_timeout; }
+
+    //! \brief Milliseconds until the retransmission timer expires, or nothing if it isn't running
+    std::optional<size_t> time_until_timeout() const;
+
+    //! \brief Largest payload the sender puts in one segment
+    size_t mss() const { return _mss; }
+
+    //! \brief The sender's millisecond clock, as sent in the TSval of the Timestamps option
+    uint32_t timestamp() const { return static_cast<uint32_t>(_time_ms); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
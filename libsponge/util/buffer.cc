@@ -1,15 +1,95 @@
 #include "buffer.hh"
 
+#include <cstring>
+#include <new>
+
 using namespace std;
 
+//! \param[in] size is the number of bytes
+BufferStorage *BufferStorage::make(const size_t size) {
+    void *memory = ::operator new(sizeof(BufferStorage) + size);
+    return new (memory) BufferStorage(size);
+}
+
+//! \param[in] str is the string whose bytes are taken over
+BufferStorage *BufferStorage::make(string &&str) {
+    void *memory = ::operator new(sizeof(BufferStorage));
+    return new (memory) BufferStorage(move(str));
+}
+
+void BufferStorage::_destroy(BufferStorage *storage) {
+    storage->~BufferStorage();
+    ::operator delete(storage);
+}
+
+//! \param[in] str is the string to copy
+Buffer Buffer::copy_of(const string_view str) {
+    if (str.empty()) {
+        return {};
+    }
+    BufferStorage *storage = BufferStorage::make(str.size());
+    memcpy(storage->data(), str.data(), str.size());
+    return Buffer{storage};
+}
+
 void Buffer::remove_prefix(const size_t n) {
     if (n > str().size()) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
-        _storage.reset();
+    _length -= n;
+    if (_length == 0) {
+        _release();
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _length -= n;
+    if (_length == 0) {
+        _release();
+    }
+}
+
+//! \param[in] length is the number of bytes written into the slab
+Buffer BufferPool::Slab::buffer(const size_t length) const {
+    if (length > size()) {
+        throw out_of_range("BufferPool::Slab::buffer");
+    }
+    Buffer ret = _whole;
+    ret.remove_suffix(size() - length);
+    return ret;
+}
+
+//! \details Checks up to SCAN_LIMIT slabs, continuing from where the last search stopped, so that slabs
+//! are reused in about the order they were handed out (which is the order packets tend to be released).
+BufferPool::Slab BufferPool::acquire() {
+    const size_t scan = min(SCAN_LIMIT, _slabs.size());
+    for (size_t i = 0; i < scan; i++) {
+        const Buffer &slab = _slabs[_next_slab];
+        _next_slab = (_next_slab + 1) % _slabs.size();
+        if (slab._storage->use_count() == 1) {
+            return Slab{slab};
+        }
+    }
+
+    Buffer slab{BufferStorage::make(_slab_size)};
+    if (_slabs.size() < _max_slabs) {
+        _slabs.push_back(slab);
+    }
+    return Slab{move(slab)};
+}
+
+//! \param[in] str is the string to copy
+Buffer BufferPool::copy(const string_view str) {
+    Slab slab = acquire();
+    if (str.size() > slab.size()) {
+        throw length_error("BufferPool::copy: string is bigger than a slab");
     }
+    memcpy(slab.data(), str.data(), str.size());
+    return slab.buffer(str.size());
 }
 
 void BufferList::append(const BufferList &other) {
@@ -94,9 +174,8 @@ size_t BufferViewList::size() const {
     return ret;
 }
 
-vector<iovec> BufferViewList::as_iovecs() const {
-    vector<iovec> ret;
-    ret.reserve(_views.size());
+BufferViewList::IOVecs BufferViewList::as_iovecs() const {
+    IOVecs ret;
     for (const auto &x : _views) {
         ret.push_back({const_cast<char *>(x.data()), x.size()});
     }
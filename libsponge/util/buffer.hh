@@ -1,8 +1,10 @@
 #ifndef SPONGE_LIBSPONGE_BUFFER_HH
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
+#include "small_vector.hh"
+
 #include <algorithm>
-#include <deque>
+#include <atomic>
 #include <memory>
 #include <numeric>
 #include <stdexcept>
@@ -11,17 +13,165 @@
 #include <sys/uio.h>
 #include <vector>
 
+#if __has_include(<sys/single_threaded.h>)
+#include <sys/single_threaded.h>
+#endif
+
+//! \brief The bytes shared by copies of a Buffer, with their reference count, in one allocation
+class BufferStorage {
+  private:
+    std::atomic<size_t> _refs{1};
+    std::string _adopted;  //!< The string the bytes are in, if they were taken from one
+    char *_data;           //!< The bytes: in `_adopted`, or just after this header
+    size_t _size;          //!< Number of bytes
+
+    explicit BufferStorage(const size_t size)
+        : _adopted(), _data(reinterpret_cast<char *>(this + 1)), _size(size) {}
+    explicit BufferStorage(std::string &&str)
+        : _adopted(std::move(str)), _data(_adopted.data()), _size(_adopted.size()) {}
+
+    //! Free the storage once nothing refers to it
+    static void _destroy(BufferStorage *storage);
+
+    //! \returns whether references can be counted without atomic operations
+    static bool _single_threaded() {
+#if defined(SPONGE_NONATOMIC_BUFFER_REFCOUNT)
+        return true;
+#elif __has_include(<sys/single_threaded.h>)
+        return __libc_single_threaded;
+#else
+        return false;
+#endif
+    }
+
+  public:
+    //! \brief Allocate room for `size` bytes, referred to once by the caller
+    static BufferStorage *make(const size_t size);
+
+    //! \brief Take over the bytes of a string, referred to once by the caller
+    static BufferStorage *make(std::string &&str);
+
+    //! \brief The bytes, which may be written only until the storage is shared
+    char *data() { return _data; }
+    const char *data() const { return _data; }
+
+    //! \brief Number of bytes
+    size_t size() const { return _size; }
+
+    //! \brief Add a reference
+    void retain() {
+        if (_single_threaded()) {
+            _refs.store(_refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+            _refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    //! \brief Drop a reference, freeing the storage if it was the last
+    void release() {
+        size_t refs_before = 0;
+        if (_single_threaded()) {
+            refs_before = _refs.load(std::memory_order_relaxed);
+            _refs.store(refs_before - 1, std::memory_order_relaxed);
+        } else {
+            refs_before = _refs.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        if (refs_before == 1) {
+            _destroy(this);
+        }
+    }
+
+    //! \brief Number of references
+    size_t use_count() const { return _refs.load(std::memory_order_acquire); }
+
+    BufferStorage(const BufferStorage &) = delete;
+    BufferStorage &operator=(const BufferStorage &) = delete;
+    ~BufferStorage() = default;
+};
+
+//! \class BufferStorage
+//! References are counted atomically once the program has started a second thread, so that Buffers can be
+//! shared between threads; until then (where the C library can tell), plain arithmetic is enough. A program
+//! with other threads whose Buffers all stay on one thread (e.g., one event loop) can always count them with
+//! plain arithmetic, by building with `-DSPONGE_NONATOMIC_BUFFERS=ON`; Router::route_parallel() then refuses
+//! to start its worker threads.
+
 //! \brief A reference-counted read-only string that can discard bytes from the front
 class Buffer {
   private:
-    std::shared_ptr<std::string> _storage{};
+    friend class BufferPool;
+
+    BufferStorage *_storage{nullptr};
     size_t _starting_offset{};
+    size_t _length{};
+
+    //! \brief Construct from all the bytes of `storage`, taking over the caller's reference to it
+    explicit Buffer(BufferStorage *storage) : _storage(storage), _length(storage->size()) {}
+
+    //! \brief Drop the reference to the storage, if any
+    void _release() {
+        if (_storage) {
+            _storage->release();
+            _storage = nullptr;
+        }
+    }
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept {
+        if (not str.empty()) {
+            _storage = BufferStorage::make(std::move(str));
+            _length = _storage->size();
+        }
+    }
+
+    //! \brief Construct from a copy of `str`, in a single allocation
+    static Buffer copy_of(const std::string_view str);
+
+    //! \name Copy and move, sharing the storage
+    //!@{
+    Buffer(const Buffer &other)
+        : _storage(other._storage), _starting_offset(other._starting_offset), _length(other._length) {
+        if (_storage) {
+            _storage->retain();
+        }
+    }
+
+    Buffer(Buffer &&other) noexcept
+        : _storage(other._storage), _starting_offset(other._starting_offset), _length(other._length) {
+        other._storage = nullptr;
+        other._starting_offset = other._length = 0;
+    }
+
+    Buffer &operator=(const Buffer &other) {
+        if (_storage != other._storage) {
+            if (other._storage) {
+                other._storage->retain();
+            }
+            _release();
+            _storage = other._storage;
+        }
+        _starting_offset = other._starting_offset;
+        _length = other._length;
+        return *this;
+    }
+
+    Buffer &operator=(Buffer &&other) noexcept {
+        if (this != &other) {
+            _release();
+            _storage = other._storage;
+            _starting_offset = other._starting_offset;
+            _length = other._length;
+            other._storage = nullptr;
+            other._starting_offset = other._length = 0;
+        }
+        return *this;
+    }
+
+    ~Buffer() { _release(); }
+    //!@}
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +179,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _length};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,16 +197,83 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Used to slice a Buffer into a shorter view that still shares the same storage.
+    void remove_suffix(const size_t n);
 };
 
+//! \brief Fixed-size slabs of memory to make Buffers from, each reused once no Buffer refers to it
+class BufferPool {
+  public:
+    //! Slabs checked for a free one before another is allocated
+    static constexpr size_t SCAN_LIMIT = 8;
+
+    //! \brief A slab to be filled, then shared by the Buffers made from it
+    class Slab {
+      private:
+        friend class BufferPool;
+
+        Buffer _whole;  //!< All of the slab
+
+        explicit Slab(Buffer whole) : _whole(std::move(whole)) {}
+
+      public:
+        //! \brief Where to write into the slab
+        char *data() { return _whole._storage->data(); }
+
+        //! \brief Size of the slab
+        size_t size() const { return _whole._length; }
+
+        //! \brief A Buffer of the first `length` bytes written, which keeps the slab from being reused
+        Buffer buffer(const size_t length) const;
+    };
+
+  private:
+    size_t _slab_size;
+    size_t _max_slabs;
+    std::vector<Buffer> _slabs{};
+    size_t _next_slab{0};  //!< Index in `_slabs` where the next search for a free slab starts
+
+  public:
+    //! \param[in] slab_size is the size of each slab
+    //! \param[in] max_slabs is the most slabs kept for reuse; beyond it, slabs are allocated and freed as needed
+    explicit BufferPool(const size_t slab_size, const size_t max_slabs = 1024)
+        : _slab_size(slab_size), _max_slabs(max_slabs) {}
+
+    //! \brief A slab that nothing else refers to, reused if one is free
+    Slab acquire();
+
+    //! \brief A Buffer holding a copy of `str`, which must fit in a slab
+    Buffer copy(const std::string_view str);
+
+    //! \brief Size of each slab
+    size_t slab_size() const { return _slab_size; }
+
+    //! \brief Number of slabs kept for reuse
+    size_t slab_count() const { return _slabs.size(); }
+};
+
+//! \class BufferPool
+//! Packets are read, and headers serialized, into slabs, so that once the pool has grown to the number of
+//! packets in flight, making a Buffer takes no allocation. A slab is free when the pool holds the only
+//! reference to it. A pool must be used by one thread at a time, but its Buffers can be released anywhere.
+
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
 //! \note Used to model packets that contain multiple sets of headers
 //! + a payload. This allows us to prepend headers (e.g., to
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
 class BufferList {
+  public:
+    //! Most packets are a payload and a header or two, so that many Buffers are kept without allocating
+    static constexpr size_t INLINE_BUFFERS = 4;
+
+    //! \brief The Buffers that make up a BufferList
+    using Buffers = SmallVector<Buffer, INLINE_BUFFERS>;
+
   private:
-    std::deque<Buffer> _buffers{};
+    Buffers _buffers{};
 
   public:
     //! \name Constructors
@@ -65,7 +282,7 @@ class BufferList {
     BufferList() = default;
 
     //! \brief Construct from a Buffer
-    BufferList(Buffer buffer) : _buffers{buffer} {}
+    BufferList(Buffer buffer) { _buffers.push_back(std::move(buffer)); }
 
     //! \brief Construct by taking ownership of a std::string
     BufferList(std::string &&str) noexcept {
@@ -74,8 +291,8 @@ class BufferList {
     }
     //!@}
 
-    //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    //! \brief Access the underlying sequence of Buffers
+    const Buffers &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
@@ -96,7 +313,12 @@ class BufferList {
 
 //! \brief A non-owning temporary view (similar to std::string_view) of a discontiguous string
 class BufferViewList {
-    std::deque<std::string_view> _views{};
+  public:
+    //! \brief `iovec` structures for the views, on the stack unless there are more than a packet usually has
+    using IOVecs = SmallVector<iovec, BufferList::INLINE_BUFFERS>;
+
+  private:
+    SmallVector<std::string_view, BufferList::INLINE_BUFFERS> _views{};
 
   public:
     //! \name Constructors
@@ -118,13 +340,23 @@ class BufferViewList {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
+    //! \brief Put a view of `str` at the front (e.g., headers serialized ahead of a payload)
+    void prepend(std::string_view str) { _views.push_front(str); }
+
+    //! \brief Append the views in `other`
+    void append(const BufferViewList &other) {
+        for (const auto &view : other._views) {
+            _views.push_back(view);
+        }
+    }
+
     //! \brief Size of the string
     size_t size() const;
 
-    //! \brief Convert to a vector of `iovec` structures
+    //! \brief Convert to a sequence of `iovec` structures (use `data()` and `size()` to pass them on)
     //! \note used for system calls that write discontiguous buffers,
     //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg)
-    std::vector<iovec> as_iovecs() const;
+    IOVecs as_iovecs() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_BUFFER_HH
@@ -2,7 +2,10 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <iterator>
 #include <stdexcept>
 #include <system_error>
 #include <utility>
@@ -10,10 +13,20 @@
 
 using namespace std;
 
+//! Most events to collect from one call to epoll_wait
+static constexpr size_t MAX_EPOLL_EVENTS = 1024;
+
 unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
 
+//! \param[in] backend selects how wait_next_event waits for the rules' fds
+EventLoop::EventLoop(const Backend backend) : _backend(backend), _timers(timestamp_ms()) {
+    if (_backend == Backend::Epoll) {
+        _epoll.emplace(SystemCall("epoll_create1", ::epoll_create1(EPOLL_CLOEXEC)));
+    }
+}
+
 //! \param[in] fd is the FileDescriptor to be polled
 //! \param[in] direction indicates whether to poll for reading (Direction::In) or writing (Direction::Out)
 //! \param[in] callback is called when `fd` is ready.
@@ -25,11 +38,88 @@ void EventLoop::add_rule(const FileDescriptor &fd,
                          const CallbackT &callback,
                          const InterestT &interest,
                          const CallbackT &cancel) {
-    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+    if (_backend == Backend::Epoll) {
+        // rules left behind by an fd that was closed and whose number has been reused
+        const auto reg = _registrations.find(fd.fd_num());
+        if (reg != _registrations.end()) {
+            for (const auto &ref : vector<RuleRef>(reg->second.rules)) {
+                if (ref.it->fd.closed()) {
+                    _erase_rule(ref);
+                    reg->second.in_kernel = false;  // closing the fd took it out of the epoll set
+                }
+            }
+        }
+    }
+
+    RuleList &list = (_backend == Backend::Epoll and not interest) ? _static_rules : _rules;
+    list.push_back({fd.duplicate(), direction, callback, interest, cancel, not interest});
+
+    if (_backend == Backend::Epoll) {
+        _registrations[fd.fd_num()].rules.push_back({&list, prev(list.end())});
+        _dirty.push_back(fd.fd_num());
+    }
+}
+
+//! \param[in] ref is the rule to cancel
+void EventLoop::_erase_rule(const RuleRef &ref) {
+    ref.it->cancel();
+
+    if (_backend == Backend::Epoll) {
+        const int fd_num = ref.it->fd.fd_num();
+        auto &rules = _registrations.at(fd_num).rules;
+        rules.erase(find_if(rules.begin(), rules.end(), [&](const RuleRef &r) { return r.it == ref.it; }));
+        _dirty.push_back(fd_num);
+    }
+
+    ref.list->erase(ref.it);
+}
+
+//! \param[in] fd_num is the number of the fd whose rules have changed
+//! \details The fd stays in the epoll set while it has rules, even uninterested ones, so that errors
+//! and hangups are still reported (as with the placeholder pollfd of Backend::Poll).
+void EventLoop::_update_registration(const int fd_num) {
+    const auto reg = _registrations.find(fd_num);
+    if (reg == _registrations.end()) {
+        return;
+    }
+
+    if (reg->second.rules.empty()) {
+        if (reg->second.in_kernel) {
+            // the fd may already be closed, which removed it from the epoll set
+            ::epoll_ctl(_epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr);
+        }
+        _registrations.erase(reg);
+        return;
+    }
+
+    uint32_t events = 0;
+    for (const auto &ref : reg->second.rules) {
+        if (ref.it->interested) {
+            events |= static_cast<uint32_t>(ref.it->direction);
+        }
+    }
+    if (reg->second.in_kernel and events == reg->second.events) {
+        return;
+    }
+
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd_num;
+    // if the fd number was closed and reused, the kernel has already forgotten the old registration
+    const int op = reg->second.in_kernel ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    int ret = ::epoll_ctl(_epoll->fd_num(), op, fd_num, &event);
+    if (ret < 0 and errno == (op == EPOLL_CTL_MOD ? ENOENT : EEXIST)) {
+        ret = ::epoll_ctl(_epoll->fd_num(), op == EPOLL_CTL_MOD ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd_num, &event);
+    }
+    SystemCall("epoll_ctl", ret);
+
+    reg->second.events = events;
+    reg->second.in_kernel = true;
 }
 
-//! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
-//!                       returns Result::Timeout if no fd is ready after the timeout expires.
+//! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll), shortened if a timer
+//!                       is due sooner; `wait_next_event` returns Result::Timeout if no fd is ready and
+//!                       no timer expires before the timeout.
 //! \returns Eventloop::Result indicating success, timeout, or no more Rule objects to poll.
 //!
 //! For each Rule, this function first calls Rule::interest; if `true`, Rule::fd is added to the
@@ -41,14 +131,15 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //!
 //! Then, for each ready file descriptor, this function calls Rule::callback. If fd reaches EOF or
 //! if the Rule was registered using EventLoop::add_cancelable_rule and Rule::callback returns true,
-//! this Rule is canceled.
+//! this Rule is canceled. Finally, it calls the callback of each timer that has come due.
 //!
 //! If an error occurs during polling, this function throws a std::runtime_error.
 //!
-//! If a [signal(7)](\ref man7::signal) was caught during polling or if EventLoop::_rules becomes empty,
-//! this function returns Result::Exit.
+//! If a [signal(7)](\ref man7::signal) was caught during polling or if EventLoop::_rules becomes empty
+//! while no timers are pending, this function returns Result::Exit.
 //!
-//! If a timeout occurred while polling (i.e., no fd became ready), this function returns Result::Timeout.
+//! If a timeout occurred while polling (i.e., no fd became ready) and no timer expired, this function
+//! returns Result::Timeout.
 //!
 //! Otherwise, this function returns Result::Success.
 //!
@@ -59,6 +150,37 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    // sleep no later than the next timer's deadline
+    int wait_ms = timeout_ms;
+    const auto deadline = _timers.next_deadline();
+    if (deadline.has_value()) {
+        const uint64_t now = timestamp_ms();
+        const uint64_t until_deadline = min(deadline.value() - min(deadline.value(), now), uint64_t{INT_MAX});
+        if (wait_ms < 0 or until_deadline < static_cast<uint64_t>(wait_ms)) {
+            wait_ms = static_cast<int>(until_deadline);
+        }
+    }
+
+    const Result result = _backend == Backend::Epoll ? _wait_epoll(wait_ms) : _wait_poll(wait_ms);
+    if (result == Result::Exit) {
+        return result;
+    }
+
+    const size_t expired = _timers.advance(timestamp_ms());
+    return (result == Result::Timeout and expired > 0) ? Result::Success : result;
+}
+
+//! \param[in] delay_ms is how long from now the timer should expire
+//! \param[in] callback is called from wait_next_event once the timer has expired
+//! \returns an id with which to cancel the timer
+EventLoop::TimerId EventLoop::add_timer(const uint64_t delay_ms, const CallbackT &callback) {
+    return _timers.add(timestamp_ms() + delay_ms, callback);
+}
+
+//! \param[in] id is the timer to cancel
+bool EventLoop::cancel_timer(const TimerId id) { return _timers.cancel(id); }
+
+EventLoop::Result EventLoop::_wait_poll(const int timeout_ms) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -79,7 +201,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             continue;
         }
 
-        if (this_rule.interest()) {
+        if (this_rule.is_interested()) {
             pollfds.push_back({this_rule.fd.fd_num(), static_cast<short>(this_rule.direction), 0});
             something_to_poll = true;
         } else {
@@ -88,8 +210,8 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
         ++it;
     }
 
-    // quit if there is nothing left to poll
-    if (not something_to_poll) {
+    // quit if there is nothing left to poll or wait for
+    if (not something_to_poll and _timers.empty()) {
         return Result::Exit;
     }
 
@@ -132,7 +254,7 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
             this_rule.callback();
 
             // only check for busy wait if we're not canceling or exiting
-            if (count_before == this_rule.service_count() and this_rule.interest()) {
+            if (count_before == this_rule.service_count() and this_rule.is_interested()) {
                 throw runtime_error(
                     "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
             }
@@ -143,3 +265,113 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+EventLoop::Result EventLoop::_wait_epoll(const int timeout_ms) {
+    bool something_to_poll = not _static_rules.empty();
+
+    // check the rules whose interest may have changed
+    for (auto it = _rules.begin(); it != _rules.end();) {  // NOTE: it gets erased or incremented in loop body
+        if ((it->direction == Direction::In and it->fd.eof()) or it->fd.closed()) {
+            _erase_rule({&_rules, it++});
+            continue;
+        }
+
+        const bool interested = it->interest();
+        if (interested != it->interested) {
+            it->interested = interested;
+            _dirty.push_back(it->fd.fd_num());
+        }
+        something_to_poll |= interested;
+        ++it;
+    }
+
+    // quit if there is nothing left to poll or wait for
+    if (not something_to_poll and _timers.empty()) {
+        return Result::Exit;
+    }
+
+    // an fd closed since its rules changed can't be given to the kernel, so cancel its rules instead
+    for (size_t i = 0; i < _dirty.size(); i++) {  // NOTE: _erase_rule() appends to _dirty
+        const auto reg = _registrations.find(_dirty[i]);
+        if (reg == _registrations.end()) {
+            continue;
+        }
+        auto &rules = reg->second.rules;
+        for (size_t j = 0; j < rules.size();) {
+            if (rules[j].it->fd.closed()) {
+                const RuleRef ref = rules[j];  // _erase_rule() removes it from `rules`
+                _erase_rule(ref);
+            } else {
+                j++;
+            }
+        }
+    }
+
+    for (const int fd_num : _dirty) {
+        _update_registration(fd_num);
+    }
+    _dirty.clear();
+
+    _events.resize(max(size_t{1}, min(_registrations.size(), MAX_EPOLL_EVENTS)));
+    int ready_count = 0;
+    try {
+        ready_count = SystemCall("epoll_wait", ::epoll_wait(_epoll->fd_num(), _events.data(), _events.size(), timeout_ms));
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    if (ready_count == 0) {
+        return Result::Timeout;
+    }
+
+    // go through the ready fds (callbacks don't wait, so nothing else touches _events meanwhile)
+    for (int i = 0; i < ready_count; i++) {
+        const epoll_event &event = _events[i];
+        const auto reg = _registrations.find(event.data.fd);
+        if (reg == _registrations.end()) {
+            continue;
+        }
+
+        if (event.events & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        // callbacks may add rules, and cancellations remove them, so work from a copy
+        _ready_rules.assign(reg->second.rules.begin(), reg->second.rules.end());
+        for (const auto &ref : _ready_rules) {
+            Rule &this_rule = *ref.it;
+            if (this_rule.fd.closed()) {
+                _erase_rule(ref);
+                continue;
+            }
+
+            const uint32_t requested = this_rule.interested ? static_cast<uint32_t>(this_rule.direction) : 0;
+            const auto poll_ready = static_cast<bool>(event.events & requested);
+            const auto poll_hup = static_cast<bool>(event.events & EPOLLHUP);
+            if (poll_hup && requested && !poll_ready) {
+                // as with Backend::Poll, a hangup with nothing left to read or write makes the fd defunct
+                _erase_rule(ref);
+                continue;
+            }
+
+            if (poll_ready) {
+                const auto count_before = this_rule.service_count();
+                this_rule.callback();
+
+                if (count_before == this_rule.service_count() and this_rule.is_interested()) {
+                    throw runtime_error(
+                        "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+                }
+
+                // rules in _rules are checked for EOF before the next wait, but static rules only here
+                if (ref.list == &_static_rules and this_rule.direction == Direction::In and this_rule.fd.eof()) {
+                    _erase_rule(ref);
+                }
+            }
+        }
+    }
+
+    return Result::Success;
+}
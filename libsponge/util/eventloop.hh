@@ -2,11 +2,17 @@
 #define SPONGE_LIBSPONGE_EVENTLOOP_HH
 
 #include "file_descriptor.hh"
+#include "timer_wheel.hh"
 
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <optional>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,6 +23,21 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! How the EventLoop waits for its file descriptors
+    enum class Backend {
+        Poll,  //!< Build a [poll(2)](\ref man2::poll) set from every rule on each call; works with any fd
+        Epoll  //!< Keep registrations in an [epoll(7)](\ref man7::epoll) set; fds must be pollable (not regular files)
+    };
+
+    //! Returned by each call to EventLoop::wait_next_event.
+    enum class Result {
+        Success,  //!< At least one Rule was triggered, or a timer expired.
+        Timeout,  //!< No rules were triggered and no timers expired before timeout.
+        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    };
+
+    using TimerId = TimerWheel::TimerId;  //!< Names a timer added with EventLoop::add_timer
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
@@ -30,31 +51,81 @@ class EventLoop {
         CallbackT callback;   //!< A callback that reads or writes fd.
         InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool interested;      //!< Was the rule interested when it was last checked?
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
+
+        //! Calls Rule::interest (a rule without one is always interested)
+        bool is_interested() const { return not interest or interest(); }
     };
 
-    std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
+    using RuleList = std::list<Rule>;
 
-  public:
-    //! Returned by each call to EventLoop::wait_next_event.
-    enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
-        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    //! A rule, and the list that holds it
+    struct RuleRef {
+        RuleList *list;         //!< EventLoop::_rules or EventLoop::_static_rules
+        RuleList::iterator it;  //!< The rule
+    };
+
+    //! The rules registered in the epoll set for one fd number
+    struct Registration {
+        std::vector<RuleRef> rules{};  //!< Rules on this fd (usually one for each direction)
+        uint32_t events{0};            //!< Events last given to the kernel
+        bool in_kernel{false};         //!< Is the fd in the epoll set?
     };
 
+    Backend _backend;  //!< How to wait for fds
+
+    TimerWheel _timers;  //!< Pending timers, with deadlines in timestamp_ms() time
+
+    RuleList _rules{};  //!< All rules that have been added and not canceled (with Backend::Epoll, those with an
+                        //!< interest callback).
+
+    //! \name State of Backend::Epoll
+    //!@{
+    RuleList _static_rules{};                                //!< Rules without an interest callback
+    std::optional<FileDescriptor> _epoll{};                  //!< The epoll set
+    std::unordered_map<int, Registration> _registrations{};  //!< Rules in the epoll set, by fd number
+    std::vector<int> _dirty{};                               //!< fds whose rules or interest have changed
+    std::vector<epoll_event> _events{};                      //!< Storage for the events returned by epoll_wait
+    std::vector<RuleRef> _ready_rules{};                     //!< Copy of the rules on the ready fd being served
+    //!@}
+
+    //! Call a rule's cancel callback and delete it
+    void _erase_rule(const RuleRef &ref);
+
+    //! Bring the kernel's epoll set up to date with the rules on `fd_num`
+    void _update_registration(const int fd_num);
+
+    //! wait_next_event() with Backend::Poll
+    Result _wait_poll(const int timeout_ms);
+
+    //! wait_next_event() with Backend::Epoll
+    Result _wait_epoll(const int timeout_ms);
+
+  public:
+    //! Construct with the given backend
+    explicit EventLoop(const Backend backend = Backend::Poll);
+
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
+    //! \note A rule without an `interest` callback is always interested.
     void add_rule(const FileDescriptor &fd,
                   const Direction direction,
                   const CallbackT &callback,
-                  const InterestT &interest = [] { return true; },
+                  const InterestT &interest = {},
                   const CallbackT &cancel = [] {});
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! Waits for the rules' fds (or the next timer) and then executes callback for each ready fd and expired timer.
     Result wait_next_event(const int timeout_ms);
+
+    //! Add a timer whose callback will be called once, `delay_ms` milliseconds from now.
+    TimerId add_timer(const uint64_t delay_ms, const CallbackT &callback);
+
+    //! Cancel a timer that hasn't expired.
+    //! \returns `false` if the timer had already expired or been canceled
+    bool cancel_timer(const TimerId id);
 };
 
 using Direction = EventLoop::Direction;
@@ -72,5 +143,13 @@ using Direction = EventLoop::Direction;
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
+//!
+//! With Backend::Epoll, each fd stays in an epoll set between calls, and its events are changed
+//! only when the interest of one of its rules changes. Only rules with an `interest` callback are
+//! checked on each call; a rule without one is checked for EOF or closure only when its fd is ready,
+//! so that a wakeup costs time in proportion to the number of ready fds.
+//!
+//! Timers added with EventLoop::add_timer are kept in a TimerWheel. wait_next_event sleeps no longer than
+//! until the earliest deadline, so a loop with nothing to do but wait for timers wakes only when one expires.
 
 #endif  // SPONGE_LIBSPONGE_EVENTLOOP_HH
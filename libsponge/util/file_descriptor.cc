@@ -3,6 +3,8 @@
 #include "util.hh"
 
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <fcntl.h>
 #include <iostream>
 #include <stdexcept>
@@ -50,17 +52,67 @@ void FileDescriptor::read(std::string &str, const size_t limit) {
     constexpr size_t BUFFER_SIZE = 1024 * 1024;  // maximum size of a read
     const size_t size_to_read = min(BUFFER_SIZE, limit);
     str.resize(size_to_read);
+    str.resize(read_into(str.data(), size_to_read));
+}
+
+//! \param[out] data is where to put the bytes read
+//! \param[in] size is the maximum number of bytes to read; fewer bytes may be read
+//! \details Unlike read(), this doesn't allocate, resize or zero-fill anything.
+size_t FileDescriptor::read_into(char *data, const size_t size) {
+    const iovec iov{data, size};
+    return read_into(&iov, 1);
+}
 
-    ssize_t bytes_read = SystemCall("read", ::read(fd_num(), str.data(), size_to_read));
-    if (limit > 0 && bytes_read == 0) {
+//! \param[in] iovecs describe the buffers to fill, in order, with one call to [readv(2)](\ref man2::readv)
+//! \param[in] count is the number of buffers
+size_t FileDescriptor::read_into(const iovec *iovecs, const size_t count) {
+    size_t size_to_read = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_to_read += iovecs[i].iov_len;
+    }
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), iovecs, count));
+    if (size_to_read > 0 && bytes_read == 0) {
         _internal_fd->_eof = true;
     }
     if (bytes_read > static_cast<ssize_t>(size_to_read)) {
-        throw runtime_error("read() read more than requested");
+        throw runtime_error("readv() read more than requested");
     }
-    str.resize(bytes_read);
 
     register_read();
+    return bytes_read;
+}
+
+//! \param[in] pool provides the slab to read into
+//! \returns the bytes read, sharing the slab
+//! \note On a device or socket that gives one packet per read, the rest of a packet bigger than a slab is lost.
+Buffer FileDescriptor::read_into(BufferPool &pool) {
+    BufferPool::Slab slab = pool.acquire();
+    return slab.buffer(read_into(slab.data(), slab.size()));
+}
+
+//! \param[in] pool provides slabs that fit the usual packet
+//! \param[in] large_pool provides slabs that fit the largest packet; it must have the larger slabs
+//! \returns the packet, sharing the slab it was read into
+//! \details The read is scattered, with [readv(2)](\ref man2::readv), over a slab from each pool: the
+//! packet goes into the small slab, and its remainder, if any, into the large one. A packet that didn't
+//! fit is then moved over to the large slab, so that it is contiguous.
+Buffer FileDescriptor::read_into(BufferPool &pool, BufferPool &large_pool) {
+    if (large_pool.slab_size() <= pool.slab_size()) {
+        throw runtime_error("FileDescriptor::read_into: large_pool has slabs no larger than pool's");
+    }
+
+    BufferPool::Slab slab = pool.acquire();
+    BufferPool::Slab large_slab = large_pool.acquire();
+    const array<iovec, 2> iovecs{{{slab.data(), slab.size()},
+                                  {large_slab.data() + slab.size(), large_slab.size() - slab.size()}}};
+    const size_t bytes_read = read_into(iovecs.data(), iovecs.size());
+    if (bytes_read <= slab.size()) {
+        return slab.buffer(bytes_read);
+    }
+
+    memcpy(large_slab.data(), slab.data(), slab.size());
+    return large_slab.buffer(bytes_read);
 }
 
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
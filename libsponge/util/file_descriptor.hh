@@ -61,6 +61,18 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read up to `size` bytes into the caller's memory at `data`, returning the number read
+    size_t read_into(char *data, const size_t size);
+
+    //! Read into each of the `count` buffers described by `iovecs` in turn, returning the number of bytes read
+    size_t read_into(const iovec *iovecs, const size_t count);
+
+    //! Read up to a slab's worth of bytes into a slab from `pool`
+    Buffer read_into(BufferPool &pool);
+
+    //! Read one packet into a slab from `pool`, or, if it doesn't fit, into a slab from `large_pool`
+    Buffer read_into(BufferPool &pool, BufferPool &large_pool);
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
@@ -31,12 +31,7 @@ T NetParser::_parse_int() {
         return 0;
     }
 
-    T ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret <<= 8;
-        ret += uint8_t(_buffer.at(i));
-    }
-
+    const T ret = read_big_endian<T>(_buffer.str().data());
     _buffer.remove_prefix(len);
 
     return ret;
@@ -52,11 +47,9 @@ void NetParser::remove_prefix(const size_t n) {
 
 template <typename T>
 void NetUnparser::_unparse_int(string &s, T val) {
-    constexpr size_t len = sizeof(T);
-    for (size_t i = 0; i < len; ++i) {
-        const uint8_t the_byte = (val >> ((len - i - 1) * 8)) & 0xff;
-        s.push_back(the_byte);
-    }
+    char bytes[sizeof(T)];
+    write_big_endian<T>(static_cast<char *>(bytes), val);
+    s.append(static_cast<char *>(bytes), sizeof(T));
 }
 
 uint32_t NetParser::u32() { return _parse_int<uint32_t>(); }
@@ -70,3 +63,10 @@ void NetUnparser::u32(string &s, const uint32_t val) { return _unparse_int<uint3
 void NetUnparser::u16(string &s, const uint16_t val) { return _unparse_int<uint16_t>(s, val); }
 
 void NetUnparser::u8(string &s, const uint8_t val) { return _unparse_int<uint8_t>(s, val); }
+
+//! \details Serializers that return a BufferList use this, so that their headers take no allocation once
+//! the pool has as many slabs as there are packets in flight.
+Buffer Headroom::to_buffer() const {
+    thread_local BufferPool header_pool{CAPACITY, 4096};
+    return header_pool.copy(str());
+}
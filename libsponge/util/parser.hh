@@ -3,9 +3,15 @@
 
 #include "buffer.hh"
 
+#include <algorithm>
+#include <arpa/inet.h>
+#include <array>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 
 //! The result of parsing or unparsing an IP datagram, TCP segment, Ethernet frame, or ARP message
@@ -22,6 +28,35 @@ enum class ParseResult {
 //! Output a string representation of a ParseResult
 std::string as_string(const ParseResult r);
 
+//! \brief Read an integer in network byte order from memory that may be unaligned
+//! \details Compiles to one load (and a byte swap on little-endian machines).
+template <typename T>
+T read_big_endian(const char *data) {
+    static_assert(sizeof(T) == 1 or sizeof(T) == 2 or sizeof(T) == 4, "unsupported integer size");
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    if constexpr (sizeof(T) == 2) {
+        return ntohs(value);
+    } else if constexpr (sizeof(T) == 4) {
+        return ntohl(value);
+    } else {
+        return value;
+    }
+}
+
+//! \brief Write an integer in network byte order to memory that may be unaligned
+template <typename T>
+void write_big_endian(char *data, const T value) {
+    static_assert(sizeof(T) == 1 or sizeof(T) == 2 or sizeof(T) == 4, "unsupported integer size");
+    T big_endian = value;
+    if constexpr (sizeof(T) == 2) {
+        big_endian = htons(value);
+    } else if constexpr (sizeof(T) == 4) {
+        big_endian = htonl(value);
+    }
+    std::memcpy(data, &big_endian, sizeof(T));
+}
+
 class NetParser {
   private:
     Buffer _buffer;
@@ -62,6 +97,86 @@ class NetParser {
     void remove_prefix(const size_t n);
 };
 
+//! \brief Base of the read-only views of a header in place in a Buffer (EthernetHeaderView, IPv4HeaderView,
+//! TCPHeaderView), which read fields without copying or parsing the header first
+//! \details The constructor makes the only bounds check: valid() is `true` if the buffer holds at least the
+//! header's fixed-length part. Field accessors then read straight from the buffer, and mustn't be called on a
+//! view that isn't valid. Nothing else (version, lengths, checksum) is checked.
+class HeaderView {
+  private:
+    Buffer _buffer;           //!< The header and whatever follows it
+    std::string_view _bytes;  //!< Contents of `_buffer` (which keeps them alive)
+    bool _valid;              //!< Whether `_buffer` is long enough
+
+  protected:
+    //! Construct a view of a header whose fixed-length part is `length` bytes
+    HeaderView(Buffer buffer, const size_t length)
+        : _buffer(std::move(buffer)), _bytes(_buffer.str()), _valid(_bytes.size() >= length) {}
+
+    //! \returns a pointer to the byte at `offset`
+    const char *_data(const size_t offset) const { return _bytes.data() + offset; }
+
+    //! \returns the integer in network byte order at `offset`
+    template <typename T>
+    T _field(const size_t offset) const {
+        return read_big_endian<T>(_data(offset));
+    }
+
+    //! \returns what follows the first `length` bytes (or nothing, if the buffer is shorter)
+    Buffer _after(const size_t length) const {
+        Buffer rest = _buffer;
+        rest.remove_prefix(std::min(length, rest.size()));
+        return rest;
+    }
+
+  public:
+    //! \returns `true` if the buffer is long enough to read the header's fields
+    bool valid() const { return _valid; }
+
+    //! \returns the header and whatever follows it
+    const Buffer &buffer() const { return _buffer; }
+};
+
+//! \brief Fixed-size space (on the stack, or reused) in which the headers of an outgoing packet are
+//! serialized without allocating
+//! \details Headers are prepended innermost first (e.g., TCP, then IPv4, then Ethernet), so that they end
+//! up contiguous and in order, ready to be sent in front of the payload with one more iovec.
+class Headroom {
+  public:
+    //! Room for Ethernet, IPv4 and TCP headers, each with as many options as it allows (14 + 60 + 60 bytes)
+    static constexpr size_t CAPACITY = 136;
+
+  private:
+    std::array<char, CAPACITY> _bytes{};
+    size_t _start{CAPACITY};  //!< Index in `_bytes` of the first byte written
+
+  public:
+    //! \brief Make room for `n` bytes ahead of those already written
+    //! \returns where to write them
+    char *prepend(const size_t n) {
+        if (n > _start) {
+            throw std::length_error("Headroom::prepend: out of room");
+        }
+        _start -= n;
+        return _bytes.data() + _start;
+    }
+
+    //! \returns the first byte written (e.g., to fill in a checksum)
+    char *front() { return _bytes.data() + _start; }
+
+    //! \returns the bytes written so far
+    std::string_view str() const { return {_bytes.data() + _start, CAPACITY - _start}; }
+
+    //! \returns the number of bytes written so far
+    size_t size() const { return CAPACITY - _start; }
+
+    //! \returns a copy of the bytes written so far, in a slab from this thread's pool of header buffers
+    Buffer to_buffer() const;
+
+    //! Discard everything written
+    void clear() { _start = CAPACITY; }
+};
+
 struct NetUnparser {
     template <typename T>
     static void _unparse_int(std::string &s, T val);
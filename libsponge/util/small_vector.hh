@@ -0,0 +1,161 @@
+#ifndef SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+#define SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \brief A sequence that keeps up to `N` elements inline, and moves to the heap only if it outgrows them
+//! \details Elements are contiguous, and can be added at either end and removed from the front, which is
+//! all a list of the few pieces of a packet needs. Removed elements are reset to `T{}`, so that they don't
+//! hold on to anything (e.g., a Buffer's storage). `T` must be default-constructible.
+template <typename T, size_t N>
+class SmallVector {
+    std::array<T, N> _inline{};  //!< The elements, while there are at most `N`
+    std::vector<T> _heap{};      //!< The elements (after `_first` unused ones), once there have been more
+    bool _on_heap{false};        //!< Are the elements in `_heap`?
+    size_t _first{0};            //!< Index of the first element
+    size_t _size{0};             //!< Number of elements
+
+    T *_data() { return _on_heap ? _heap.data() : _inline.data(); }
+    const T *_data() const { return _on_heap ? _heap.data() : _inline.data(); }
+
+    //! Move the elements to the heap, leaving room for more
+    void _spill() {
+        _heap.reserve(2 * N);
+        std::move(_inline.begin() + _first, _inline.begin() + _first + _size, std::back_inserter(_heap));
+        std::fill(_inline.begin() + _first, _inline.begin() + _first + _size, T{});
+        _first = 0;
+        _on_heap = true;
+    }
+
+    //! Forget the elements, which have been moved elsewhere
+    void _forget() {
+        _heap.clear();
+        _on_heap = false;
+        _first = 0;
+        _size = 0;
+    }
+
+  public:
+    SmallVector() = default;
+    SmallVector(const SmallVector &other) = default;
+    SmallVector &operator=(const SmallVector &other) = default;
+    ~SmallVector() = default;
+
+    //! \brief Take the elements of `other`, leaving it empty
+    SmallVector(SmallVector &&other) noexcept
+        : _inline(std::move(other._inline))
+        , _heap(std::move(other._heap))
+        , _on_heap(other._on_heap)
+        , _first(other._first)
+        , _size(other._size) {
+        other._forget();
+    }
+
+    //! \brief Take the elements of `other`, leaving it empty
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this != &other) {
+            _inline = std::move(other._inline);
+            _heap = std::move(other._heap);
+            _on_heap = other._on_heap;
+            _first = other._first;
+            _size = other._size;
+            other._forget();
+        }
+        return *this;
+    }
+
+    //! \name Element access
+    //!@{
+    T *begin() { return _data() + _first; }
+    T *end() { return begin() + _size; }
+    const T *begin() const { return _data() + _first; }
+    const T *end() const { return begin() + _size; }
+    T *data() { return begin(); }
+    const T *data() const { return begin(); }
+
+    T &operator[](const size_t i) { return begin()[i]; }
+    const T &operator[](const size_t i) const { return begin()[i]; }
+    T &front() { return *begin(); }
+    const T &front() const { return *begin(); }
+    T &back() { return end()[-1]; }
+    const T &back() const { return end()[-1]; }
+    //!@}
+
+    //! \brief Number of elements
+    size_t size() const { return _size; }
+
+    //! \brief Are there no elements?
+    bool empty() const { return _size == 0; }
+
+    //! \brief Add an element at the end
+    void push_back(T value) {
+        if (not _on_heap) {
+            if (_first + _size < N) {
+                _inline[_first + _size] = std::move(value);
+                _size++;
+                return;
+            }
+            if (_size < N) {  // there's room at the front, so shift the elements into it
+                std::move(begin(), end(), _inline.begin());
+                std::fill(_inline.begin() + _size, _inline.end(), T{});
+                _first = 0;
+                _inline[_size++] = std::move(value);
+                return;
+            }
+            _spill();
+        }
+        _heap.push_back(std::move(value));
+        _size++;
+    }
+
+    //! \brief Add an element at the front
+    void push_front(T value) {
+        if (_first > 0) {
+            _data()[--_first] = std::move(value);
+            _size++;
+            return;
+        }
+        if (not _on_heap) {
+            if (_size < N) {
+                std::move_backward(begin(), end(), end() + 1);
+                _inline[0] = std::move(value);
+                _size++;
+                return;
+            }
+            _spill();
+        }
+        _heap.insert(_heap.begin(), std::move(value));
+        _size++;
+    }
+
+    //! \brief Remove the first element
+    void pop_front() {
+        if (empty()) {
+            throw std::out_of_range("SmallVector::pop_front");
+        }
+        front() = T{};
+        _first++;
+        _size--;
+        if (_size == 0) {
+            clear();
+        } else if (_on_heap and _first > _heap.capacity() / 2) {
+            // used as a queue, the heap would otherwise keep growing at the back; drop the consumed front
+            _heap.erase(_heap.begin(), _heap.begin() + _first);
+            _first = 0;
+        }
+    }
+
+    //! \brief Remove every element (keeping any heap storage for reuse)
+    void clear() {
+        std::fill(begin(), end(), T{});
+        _forget();
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_SMALL_VECTOR_HH
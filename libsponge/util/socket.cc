@@ -2,7 +2,11 @@
 
 #include "util.hh"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstring>
+#include <netinet/udp.h>
 #include <stdexcept>
 #include <unistd.h>
 
@@ -112,6 +116,81 @@ UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
     return ret;
 }
 
+//! \param[in] capacity is the most datagrams to receive at once
+//! \param[in] mtu is the largest datagram to receive; larger ones make recv_batch throw std::runtime_error
+//! \param[in] slab_size is the size of the slabs that payloads are kept in, which should fit the usual datagram
+//! \details Keeps up to four slabs per datagram for reuse, so that payloads can be held for a while (e.g., until
+//! the next batch is read) without more allocation. Each datagram is scattered over a slab and, past its end,
+//! a large slab of `mtu` bytes; the large slab is only kept by a payload that didn't fit the small one, so a
+//! payload held for a long time (e.g., by a StreamReassembler) keeps no more than `slab_size` bytes alive.
+UDPSocket::RecvBatch::RecvBatch(const size_t capacity, const size_t mtu, const size_t slab_size)
+    : _slab_size(min(slab_size, mtu))
+    , _pool(_slab_size, 4 * capacity)
+    , _large_pool(mtu, capacity)
+    , _slabs()
+    , _large_slabs()
+    , _addresses(capacity)
+    , _iovecs(2 * capacity)
+    , _headers(capacity) {
+    _slabs.reserve(capacity);
+    _large_slabs.reserve(capacity);
+    for (size_t i = 0; i < capacity; i++) {
+        _slabs.push_back(_pool.acquire());
+        _large_slabs.push_back(_large_pool.acquire());
+        _iovecs[2 * i] = {_slabs[i].data(), _slab_size};
+        _iovecs[2 * i + 1] = {_large_slabs[i].data() + _slab_size, mtu - _slab_size};
+        _headers[i].msg_hdr.msg_iov = &_iovecs[2 * i];
+        _headers[i].msg_hdr.msg_iovlen = mtu > _slab_size ? 2 : 1;
+        _headers[i].msg_hdr.msg_name = static_cast<sockaddr *>(_addresses[i]);
+    }
+}
+
+//! \param[in] i is the index of a datagram received by the last call to UDPSocket::recv_batch
+Address UDPSocket::RecvBatch::source_address(const size_t i) const {
+    return {static_cast<const sockaddr *>(_addresses.at(i)), _headers.at(i).msg_hdr.msg_namelen};
+}
+
+//! \param[out] batch receives the datagrams
+//! \details Like recv(), this blocks until a datagram arrives, but then takes whatever else is waiting
+//! without blocking again ([MSG_WAITFORONE](\ref man2::recvmmsg)).
+//! \note If a datagram is too big for the batch's buffers, this method throws a std::runtime_error
+void UDPSocket::recv_batch(RecvBatch &batch) {
+    // the slabs filled last time may still be in use (through payload()), so receive into fresh ones
+    for (size_t i = 0; i < batch._size; i++) {
+        if (batch._is_large(i)) {
+            batch._large_slabs[i] = batch._large_pool.acquire();
+            batch._iovecs[2 * i + 1].iov_base = batch._large_slabs[i].data() + batch._slab_size;
+        } else {
+            batch._slabs[i] = batch._pool.acquire();
+            batch._iovecs[2 * i].iov_base = batch._slabs[i].data();
+        }
+    }
+
+    for (auto &header : batch._headers) {
+        header.msg_hdr.msg_namelen = sizeof(Address::Raw::storage);
+        header.msg_hdr.msg_flags = 0;
+    }
+
+    batch._size = 0;
+    const int count = SystemCall(
+        "recvmmsg", ::recvmmsg(fd_num(), batch._headers.data(), batch._headers.size(), MSG_WAITFORONE, nullptr));
+    register_read();
+
+    for (int i = 0; i < count; i++) {
+        if (batch._headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            throw runtime_error("recvmmsg (oversized datagram)");
+        }
+    }
+    batch._size = count;
+
+    // a datagram that didn't fit its slab is made whole in its large slab
+    for (size_t i = 0; i < batch._size; i++) {
+        if (batch._is_large(i)) {
+            memcpy(batch._large_slabs[i].data(), batch._slabs[i].data(), batch._slab_size);
+        }
+    }
+}
+
 void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
@@ -141,6 +220,144 @@ void UDPSocket::send(const BufferViewList &payload) {
     register_write();
 }
 
+//! \param[in] destination is the Address to send every datagram to
+//! \param[in] payloads are the datagrams to send, in order
+void UDPSocket::send_batch(const Address &destination, const vector<BufferViewList> &payloads) {
+    // the messages are built on the stack a chunk at a time, so sending a batch doesn't allocate
+    constexpr size_t MESSAGES_PER_CHUNK = 32;
+    array<BufferViewList::IOVecs, MESSAGES_PER_CHUNK> iovecs{};
+    array<mmsghdr, MESSAGES_PER_CHUNK> headers{};
+
+    for (size_t first = 0; first < payloads.size();) {
+        const size_t chunk_size = min(payloads.size() - first, MESSAGES_PER_CHUNK);
+        for (size_t i = 0; i < chunk_size; i++) {
+            iovecs[i] = payloads[first + i].as_iovecs();
+            msghdr &message = headers[i].msg_hdr;
+            message.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(destination));
+            message.msg_namelen = destination.size();
+            message.msg_iov = iovecs[i].data();
+            message.msg_iovlen = iovecs[i].size();
+        }
+
+        // the kernel may stop early
+        for (size_t sent = 0; sent < chunk_size;) {
+            const int count = SystemCall("sendmmsg", ::sendmmsg(fd_num(), &headers[sent], chunk_size - sent, 0));
+            for (size_t i = sent; i < sent + count; i++) {
+                if (headers[i].msg_len != payloads[first + i].size()) {
+                    throw runtime_error("datagram payload too big for sendmmsg()");
+                }
+            }
+            sent += count;
+        }
+        first += chunk_size;
+    }
+
+    register_write();
+}
+
+//! \param[in] destination is the Address to send the datagrams to
+//! \param[in] payload is the concatenated datagram payloads, of at most MAX_GSO_PAYLOAD bytes
+//! \param[in] segment_size is the size of each datagram's payload; there may be at most MAX_GSO_SEGMENTS
+//! \details The kernel splits `payload` into datagrams after routing, or hands the whole thing to a NIC
+//! that can segment it. Either way, the datagrams arrive as if sent one by one.
+void UDPSocket::send_segmented(const Address &destination, const BufferViewList &payload, const size_t segment_size) {
+    if (segment_size == 0 or payload.size() > MAX_GSO_PAYLOAD or
+        payload.size() > segment_size * MAX_GSO_SEGMENTS) {
+        throw runtime_error("UDPSocket::send_segmented: payload can't be segmented");
+    }
+
+    // a single datagram needs no segmentation
+    if (payload.size() <= segment_size) {
+        sendto(destination, payload);
+        return;
+    }
+
+    auto iovecs = payload.as_iovecs();
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))]{};
+    msghdr message{};
+    message.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(destination));
+    message.msg_namelen = destination.size();
+    message.msg_iov = iovecs.data();
+    message.msg_iovlen = iovecs.size();
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr *const cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    const auto gso_size = static_cast<uint16_t>(segment_size);
+    memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+
+    const ssize_t bytes_sent = SystemCall("sendmsg (UDP_SEGMENT)", ::sendmsg(fd_num(), &message, 0));
+    if (size_t(bytes_sent) != payload.size()) {
+        throw runtime_error("datagram payload too big for sendmsg()");
+    }
+
+    register_write();
+}
+
+//! \param[out] datagrams receives the datagrams; each payload is a slice of one Buffer
+//! \details Without enable_gro(), this receives a single datagram. As with recv_batch, the read is scattered
+//! over a small slab and, past its end, a large slab that fits the largest coalesced read; a read that
+//! didn't fit the small slab is made whole in the large one, so a lone datagram of the usual size keeps no
+//! more than a small slab alive.
+void UDPSocket::recv_coalesced(coalesced_datagrams &datagrams) {
+    datagrams.payloads.clear();
+    BufferPool::Slab slab = datagrams.pool.acquire();
+    BufferPool::Slab large_slab = datagrams.large_pool.acquire();
+    if (large_slab.size() <= slab.size()) {
+        throw runtime_error("UDPSocket::recv_coalesced: large_pool has slabs no larger than pool's");
+    }
+    array<iovec, 2> iovecs{{{slab.data(), slab.size()},
+                            {large_slab.data() + slab.size(), large_slab.size() - slab.size()}}};
+
+    Address::Raw source_address;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr message{};
+    message.msg_name = static_cast<sockaddr *>(source_address);
+    message.msg_namelen = sizeof(source_address.storage);
+    message.msg_iov = iovecs.data();
+    message.msg_iovlen = iovecs.size();
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    const ssize_t recv_len = SystemCall("recvmsg", ::recvmsg(fd_num(), &message, 0));
+    register_read();
+    if (message.msg_flags & MSG_TRUNC) {
+        throw runtime_error("recvmsg (oversized datagram)");
+    }
+
+    // the kernel reports the size of the coalesced datagrams (all but the last, which may be shorter)
+    size_t segment_size = recv_len;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP and cmsg->cmsg_type == UDP_GRO) {
+            int gso_size = 0;
+            memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+            segment_size = gso_size;
+        }
+    }
+
+    datagrams.source_address = {source_address, message.msg_namelen};
+
+    if (recv_len == 0) {
+        datagrams.payloads.emplace_back();  // an empty datagram
+        return;
+    }
+
+    if (size_t(recv_len) > slab.size()) {
+        memcpy(large_slab.data(), slab.data(), slab.size());
+    }
+    const Buffer whole = size_t(recv_len) > slab.size() ? large_slab.buffer(recv_len) : slab.buffer(recv_len);
+    for (size_t offset = 0; offset < whole.size(); offset += segment_size) {
+        Buffer payload = whole;
+        payload.remove_prefix(offset);
+        payload.remove_suffix(payload.size() - min(segment_size, payload.size()));
+        datagrams.payloads.push_back(move(payload));
+    }
+}
+
 // mark the socket as listening for incoming connections
 //! \param[in] backlog is the number of waiting connections to queue (see [listen(2)](\ref man2::listen))
 void TCPSocket::listen(const int backlog) { SystemCall("listen", ::listen(fd_num(), backlog)); }
@@ -166,3 +383,7 @@ void Socket::setsockopt(const int level, const int option, const option_type &op
 // allow local address to be reused sooner, at the cost of some robustness
 //! \note Using `SO_REUSEADDR` may reduce the robustness of your application
 void Socket::set_reuseaddr() { setsockopt(SOL_SOCKET, SO_REUSEADDR, int(true)); }
+
+//! \details See [udp(7)](\ref man7::udp) for details. Until it is enabled, the kernel splits datagrams
+//! that were sent with send_segmented before delivering them.
+void UDPSocket::enable_gro() { setsockopt(SOL_UDP, UDP_GRO, int(true)); }
@@ -7,7 +7,9 @@
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
+#include <vector>
 
 //! \brief Base class for network sockets (TCP, UDP, etc.)
 //! \details Socket is generally used via a subclass. See TCPSocket and UDPSocket for usage examples.
@@ -70,15 +72,110 @@ class UDPSocket : public Socket {
     //! Receive a datagram and the Address of its sender (caller can allocate storage)
     void recv(received_datagram &datagram, const size_t mtu = 65536);
 
+    //! Preallocated storage for the datagrams received by one call to UDPSocket::recv_batch
+    class RecvBatch {
+      private:
+        friend class UDPSocket;
+
+        size_t _slab_size;                           //!< Size of the slabs that payloads are kept in
+        BufferPool _pool;                            //!< Slabs that datagrams are received into
+        BufferPool _large_pool;                      //!< Slabs of `mtu` bytes, for datagrams too big for `_pool`'s
+        std::vector<BufferPool::Slab> _slabs;        //!< The slab for each datagram
+        std::vector<BufferPool::Slab> _large_slabs;  //!< Where the rest of each datagram goes, if it doesn't fit
+        std::vector<Address::Raw> _addresses;        //!< Source address of each datagram
+        std::vector<iovec> _iovecs;                  //!< Points to each datagram's slab (and large slab)
+        std::vector<mmsghdr> _headers;               //!< Message headers given to recvmmsg
+        size_t _size{0};                             //!< Number of datagrams received by the last recv_batch
+
+        //! Did the `i`th datagram overflow its slab, and so get made whole in its large slab?
+        bool _is_large(const size_t i) const { return _headers.at(i).msg_len > _slab_size; }
+
+      public:
+        //! The default slab size, which fits a datagram at the usual 1500-byte MTU
+        static constexpr size_t DEFAULT_SLAB_SIZE = 2048;
+
+        //! Allocate room for `capacity` datagrams of up to `mtu` bytes each, kept in slabs of `slab_size` bytes
+        explicit RecvBatch(const size_t capacity, const size_t mtu = 65536, const size_t slab_size = DEFAULT_SLAB_SIZE);
+
+        //! Most datagrams received at once
+        size_t capacity() const { return _headers.size(); }
+
+        //! Size of the slabs that payloads (of datagrams that fit) are kept in
+        size_t slab_size() const { return _slab_size; }
+
+        //! Number of large slabs kept for reuse
+        size_t large_slab_count() const { return _large_pool.slab_count(); }
+
+        //! Number of datagrams received by the last call to UDPSocket::recv_batch
+        size_t size() const { return _size; }
+
+        //! Payload of the `i`th datagram, which keeps its slab from being reused while it lasts
+        Buffer payload(const size_t i) const {
+            return (_is_large(i) ? _large_slabs.at(i) : _slabs.at(i)).buffer(_headers.at(i).msg_len);
+        }
+
+        //! Address from which the `i`th datagram was received
+        Address source_address(const size_t i) const;
+
+        //! \name
+        //! The headers point into the other members, so a RecvBatch can be moved but not copied
+
+        //!@{
+        RecvBatch(const RecvBatch &) = delete;
+        RecvBatch &operator=(const RecvBatch &) = delete;
+        RecvBatch(RecvBatch &&) = default;
+        RecvBatch &operator=(RecvBatch &&) = default;
+        ~RecvBatch() = default;
+        //!@}
+    };
+
+    //! Receive one or more datagrams (up to the batch's capacity) with a single system call
+    void recv_batch(RecvBatch &batch);
+
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
+
+    //! Send several datagrams to specified Address, with as few system calls as possible
+    void send_batch(const Address &destination, const std::vector<BufferViewList> &payloads);
+
+    //! \name Segmentation offload
+    //!@{
+
+    //! Most datagrams the kernel will make of one call to send_segmented
+    static constexpr size_t MAX_GSO_SEGMENTS = 64;
+
+    //! Largest payload of one call to send_segmented (the largest UDP payload in an IPv4 datagram)
+    static constexpr size_t MAX_GSO_PAYLOAD = 65507;
+
+    //! Send `payload` to specified Address as datagrams of `segment_size` bytes each (the last may be
+    //! shorter), with a single system call
+    void send_segmented(const Address &destination, const BufferViewList &payload, const size_t segment_size);
+
+    //! Let the kernel coalesce same-sized datagrams from one sender; read them with recv_coalesced
+    void enable_gro();
+
+    //! Returned by UDPSocket::recv_coalesced; carries the datagrams that arrived together
+    struct coalesced_datagrams {
+        Address source_address;                             //!< Address from which these datagrams were received
+        std::vector<Buffer> payloads;                       //!< UDP datagram payloads, in order, sharing one buffer
+        BufferPool pool{RecvBatch::DEFAULT_SLAB_SIZE, 64};  //!< Slabs that a lone, usual-sized datagram is kept in
+        BufferPool large_pool{MAX_GSO_PAYLOAD, 16};         //!< Slabs that fit a whole coalesced read
+    };
+
+    //! Receive one or more datagrams from the same sender with a single system call
+    void recv_coalesced(coalesced_datagrams &datagrams);
+    //!@}
 };
 
 //! \class UDPSocket
-//! Functions in this class are essentially wrappers over their POSIX eponyms.
+//! Functions in this class are essentially wrappers over their POSIX eponyms. recv_batch and send_batch
+//! wrap [recvmmsg(2)](\ref man2::recvmmsg) and [sendmmsg(2)](\ref man2::sendmmsg), which move many
+//! datagrams per system call. send_segmented and recv_coalesced go further, using UDP segmentation offload
+//! ([UDP_SEGMENT and UDP_GRO](\ref man7::udp)) so that a burst of equal-sized datagrams crosses the
+//! kernel's network stack once.
 //!
 //! Example:
 //!
@@ -0,0 +1,64 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_RING_HH
+#define SPONGE_LIBSPONGE_SPSC_RING_HH
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+//! \brief A bounded lock-free queue between one producer thread and one consumer thread
+//! \details The producer only writes `_tail` and the consumer only writes `_head`, each publishing
+//! the slots it has filled or emptied with a release store that the other side reads with an acquire
+//! load. The indices are on separate cache lines so the two threads don't contend for one.
+template <typename T>
+class SPSCRing {
+  private:
+    std::vector<T> _slots;  //!< Storage; the size is a power of two
+    size_t _mask;           //!< Size of `_slots` minus one
+
+    alignas(64) std::atomic<size_t> _head{0};  //!< Count of items popped (written by the consumer)
+    alignas(64) std::atomic<size_t> _tail{0};  //!< Count of items pushed (written by the producer)
+
+    //! \returns the smallest power of two that is at least `n`
+    static size_t _round_up(const size_t n) {
+        size_t size = 1;
+        while (size < n) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+  public:
+    //! Construct a ring that holds at least `capacity` items
+    explicit SPSCRing(const size_t capacity) : _slots(_round_up(capacity)), _mask(_slots.size() - 1) {}
+
+    //! \brief Append an item, if there is room (producer only)
+    //! \returns `false` if the ring is full, in which case `item` is left alone
+    bool try_push(T &item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _slots.size()) {
+            return false;
+        }
+        _slots[tail & _mask] = std::move(item);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Remove the oldest item (consumer only)
+    //! \returns the item, or nothing if the ring is empty
+    std::optional<T> try_pop() {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return {};
+        }
+        std::optional<T> item{std::move(_slots[head & _mask])};
+        _head.store(head + 1, std::memory_order_release);
+        return item;
+    }
+
+    //! Most items the ring holds
+    size_t capacity() const { return _slots.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_RING_HH
@@ -0,0 +1,155 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] occupied is the occupied bitmap of `level`
+//! \param[in] level is a level of the wheel
+//! \param[in] now is the current time
+//! \returns the occupied slots of `level` that come after the slot that `now` falls in
+uint64_t TimerWheel::_later_slots(const uint64_t occupied, const unsigned level, const uint64_t now) {
+    const unsigned current = (now >> (SLOT_BITS * level)) & (SLOTS - 1);
+    return current == SLOTS - 1 ? 0 : occupied & (~uint64_t{0} << (current + 1));
+}
+
+//! \param[in] from is the slot (or temporary list) that holds the timer
+//! \param[in] it is the timer, which keeps its identity (and iterator) as it moves
+void TimerWheel::_place(Slot &from, const Slot::iterator it) {
+    const uint64_t deadline = max(it->deadline, _now);
+
+    // the lowest level whose current span contains the deadline
+    Location location{LEVELS, 0, it};
+    for (unsigned level = 0; level < LEVELS; level++) {
+        const unsigned span_bits = SLOT_BITS * (level + 1);
+        if ((deadline >> span_bits) == (_now >> span_bits)) {
+            location.level = level;
+            location.slot = (deadline >> (SLOT_BITS * level)) & (SLOTS - 1);
+            _occupied[level] |= uint64_t{1} << location.slot;
+            break;
+        }
+    }
+
+    Slot &to = _slot(location);
+    to.splice(to.end(), from, it);
+    _timers.insert_or_assign(it->id, location);
+}
+
+void TimerWheel::_vacate(const Location &location) {
+    if (location.level < LEVELS and _slots[location.level][location.slot].empty()) {
+        _occupied[location.level] &= ~(uint64_t{1} << location.slot);
+    }
+}
+
+//! \details A slot in an upper level must be cascaded when the clock reaches its start, and a slot in
+//! the bottom level fired when the clock reaches it. Timers in a lower level always come due before those
+//! in a higher one, so the first occupied slot of the lowest occupied level is next.
+optional<uint64_t> TimerWheel::_next_event() const {
+    for (unsigned level = 0; level < LEVELS; level++) {
+        const uint64_t later = _later_slots(_occupied[level], level, _now);
+        if (later) {
+            const unsigned span_bits = SLOT_BITS * (level + 1);
+            const auto slot = static_cast<uint64_t>(__builtin_ctzll(later));
+            return ((_now >> span_bits) << span_bits) | (slot << (SLOT_BITS * level));
+        }
+    }
+    if (not _far.empty()) {
+        return ((_now >> RANGE_BITS) + 1) << RANGE_BITS;
+    }
+    return {};
+}
+
+//! \param[in] deadline_ms is the time at which the timer should expire
+//! \param[in] callback is called (once) when it does
+//! \returns the id of the new timer
+TimerWheel::TimerId TimerWheel::add(const uint64_t deadline_ms, CallbackT callback) {
+    const TimerId id = _next_id++;
+    Slot pending{};
+    pending.push_back({id, max(deadline_ms, _now + 1), move(callback)});
+    _place(pending, pending.begin());
+    return id;
+}
+
+//! \param[in] id is the timer to cancel
+bool TimerWheel::cancel(const TimerId id) {
+    const auto timer = _timers.find(id);
+    if (timer == _timers.end()) {
+        return false;
+    }
+
+    const Location location = timer->second;
+    _timers.erase(timer);
+    _slot(location).erase(location.it);
+    _vacate(location);
+    return true;
+}
+
+//! \param[in] now_ms is the current time
+//! \details Callbacks may add and cancel timers; a timer they add expires no earlier than the next call.
+size_t TimerWheel::advance(const uint64_t now_ms) {
+    size_t expired = 0;
+    for (auto next = _next_event(); next.has_value() and next.value() <= now_ms; next = _next_event()) {
+        _now = next.value();
+
+        // at the start of a new span of the whole wheel, some far timers may have come in range
+        if ((_now & ((uint64_t{1} << RANGE_BITS) - 1)) == 0 and not _far.empty()) {
+            Slot far{};
+            far.splice(far.end(), _far);
+            while (not far.empty()) {
+                _place(far, far.begin());
+            }
+        }
+
+        // cascade each upper level whose slot starts now, from the top down
+        for (unsigned level = LEVELS - 1; level > 0; level--) {
+            if ((_now & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) != 0) {
+                continue;
+            }
+            const unsigned slot = (_now >> (SLOT_BITS * level)) & (SLOTS - 1);
+            Slot cascading{};
+            cascading.splice(cascading.end(), _slots[level][slot]);
+            _occupied[level] &= ~(uint64_t{1} << slot);
+            while (not cascading.empty()) {
+                _place(cascading, cascading.begin());
+            }
+        }
+
+        // fire the timers due now
+        const unsigned slot = _now & (SLOTS - 1);
+        Slot &due = _slots[0][slot];
+        while (not due.empty()) {
+            Timer timer = move(due.front());
+            due.pop_front();
+            _timers.erase(timer.id);
+            if (due.empty()) {
+                _occupied[0] &= ~(uint64_t{1} << slot);
+            }
+            expired++;
+            timer.callback();
+        }
+    }
+
+    _now = max(_now, now_ms);
+    return expired;
+}
+
+//! \returns the earliest deadline, which is at least now() + 1
+optional<uint64_t> TimerWheel::next_deadline() const {
+    const auto earliest = [](const Slot &slot) {
+        return min_element(slot.begin(), slot.end(), [](const Timer &a, const Timer &b) {
+                   return a.deadline < b.deadline;
+               })->deadline;
+    };
+
+    for (unsigned level = 0; level < LEVELS; level++) {
+        const uint64_t later = _later_slots(_occupied[level], level, _now);
+        if (later) {
+            return earliest(_slots[level][__builtin_ctzll(later)]);
+        }
+    }
+    if (not _far.empty()) {
+        return earliest(_far);
+    }
+    return {};
+}
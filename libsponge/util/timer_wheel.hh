@@ -0,0 +1,115 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <unordered_map>
+
+//! \brief One-shot timers with millisecond deadlines, kept in a hierarchical timing wheel
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;                     //!< Names a timer, for cancel()
+    using CallbackT = std::function<void(void)>;  //!< Called when a timer expires
+
+  private:
+    static constexpr unsigned SLOT_BITS = 6;                    //!< log2 of the slots in each level
+    static constexpr unsigned SLOTS = 1u << SLOT_BITS;          //!< Slots in each level
+    static constexpr unsigned LEVELS = 4;                       //!< Levels in the wheel
+    static constexpr unsigned RANGE_BITS = SLOT_BITS * LEVELS;  //!< log2 of the span of the whole wheel (ms)
+
+    //! A pending timer
+    struct Timer {
+        TimerId id;          //!< The timer's name
+        uint64_t deadline;   //!< Time at which it expires
+        CallbackT callback;  //!< What to call when it does
+    };
+
+    using Slot = std::list<Timer>;
+
+    //! Where a pending timer is stored
+    struct Location {
+        unsigned level;     //!< Level of the wheel (or LEVELS for _far)
+        unsigned slot;      //!< Slot in that level
+        Slot::iterator it;  //!< The timer
+    };
+
+    //! Level `l` slot `s` holds timers due in the `s`th span of 64^l ms within the current span of 64^(l+1) ms
+    std::array<std::array<Slot, SLOTS>, LEVELS> _slots{};
+
+    //! Bit `s` of `_occupied[l]` is set if `_slots[l][s]` isn't empty
+    std::array<uint64_t, LEVELS> _occupied{};
+
+    //! Timers due beyond the span of the wheel
+    Slot _far{};
+
+    //! Every pending timer, by id
+    std::unordered_map<TimerId, Location> _timers{};
+
+    //! Time up to which the wheel has been advanced: every timer due at or before it has expired
+    uint64_t _now;
+
+    //! Id of the next timer to be added
+    TimerId _next_id{1};
+
+    //! The slot that holds a timer
+    Slot &_slot(const Location &location) {
+        return location.level == LEVELS ? _far : _slots[location.level][location.slot];
+    }
+
+    //! The occupied slots of `level` after the one `now` falls in
+    static uint64_t _later_slots(const uint64_t occupied, const unsigned level, const uint64_t now);
+
+    //! Move the timer at `it` in `from` into the slot for its deadline
+    void _place(Slot &from, const Slot::iterator it);
+
+    //! Clear the occupied bit of a slot that has become empty
+    void _vacate(const Location &location);
+
+    //! Earliest time at which some slot must be cascaded or fired
+    std::optional<uint64_t> _next_event() const;
+
+  public:
+    //! Construct a wheel whose clock starts at `now_ms`
+    explicit TimerWheel(const uint64_t now_ms) : _now(now_ms) {}
+
+    //! Add a timer that expires at `deadline_ms` (or on the next advance(), if that has passed)
+    TimerId add(const uint64_t deadline_ms, CallbackT callback);
+
+    //! Cancel a pending timer
+    //! \returns `false` if the timer had already expired or been cancelled
+    bool cancel(const TimerId id);
+
+    //! Advance the clock to `now_ms`, calling the callback of each timer due by then, earliest first
+    //! \returns the number of timers that expired
+    size_t advance(const uint64_t now_ms);
+
+    //! \name Accessors
+    //!@{
+
+    //! Deadline of the earliest pending timer, or nothing if there are none
+    std::optional<uint64_t> next_deadline() const;
+
+    //! Number of pending timers
+    size_t size() const { return _timers.size(); }
+
+    //! Are there no pending timers?
+    bool empty() const { return _timers.empty(); }
+
+    //! Time up to which the wheel has been advanced
+    uint64_t now() const { return _now; }
+    //!@}
+};
+
+//! \class TimerWheel
+//! Adding or cancelling a timer takes constant time, however many are pending. Each level of the wheel
+//! covers 64 times the span of the one below it, with 1 ms slots at the bottom, so four levels hold
+//! deadlines up to about 4.6 hours ahead (later ones wait in a separate list until they come in range).
+//! As the clock reaches the start of a slot in an upper level, its timers are cascaded into the levels
+//! below; a timer expires when the clock reaches its bottom-level slot. advance() skips directly between
+//! occupied slots, so a long idle interval costs no more than a short one.
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
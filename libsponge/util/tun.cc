@@ -14,18 +14,22 @@ using namespace std;
 
 //! \param[in] devname is the name of the TUN or TAP device, specified at its creation.
 //! \param[in] is_tun is `true` for a TUN device (expects IP datagrams), or `false` for a TAP device (expects Ethernet frames)
+//! \param[in] multi_queue is `true` to open one more queue of a multiqueue device
 //!
 //! To create a TUN device, you should already have run
 //!
 //!     ip tuntap add mode tun user `username` name `devname`
 //!
-//! as root before calling this function.
+//! (adding `multi_queue` for a multiqueue device) as root before calling this function.
 
-TunTapFD::TunTapFD(const string &devname, const bool is_tun)
+TunTapFD::TunTapFD(const string &devname, const bool is_tun, const bool multi_queue)
     : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))) {
     struct ifreq tun_req {};
 
     tun_req.ifr_flags = (is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI;  // tun device with no packetinfo
+    if (multi_queue) {
+        tun_req.ifr_flags |= IFF_MULTI_QUEUE;  // each fd opened on the device is a queue of its own
+    }
 
     // copy devname to ifr_name, making sure to null terminate
 
@@ -34,3 +38,26 @@ TunTapFD::TunTapFD(const string &devname, const bool is_tun)
 
     SystemCall("ioctl", ioctl(fd_num(), TUNSETIFF, static_cast<void *>(&tun_req)));
 }
+
+//! \details The kernel spreads the datagrams it sends to the device over the queues by flow.
+template <typename DeviceFD>
+static vector<DeviceFD> open_device_queues(const string &devname, const size_t count) {
+    vector<DeviceFD> queues;
+    queues.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        queues.emplace_back(devname, true);
+    }
+    return queues;
+}
+
+//! \param[in] devname is the name of the TUN device, created with `multi_queue`
+//! \param[in] count is the number of queues to open
+vector<TunFD> TunFD::open_queues(const string &devname, const size_t count) {
+    return open_device_queues<TunFD>(devname, count);
+}
+
+//! \param[in] devname is the name of the TAP device, created with `multi_queue`
+//! \param[in] count is the number of queues to open
+vector<TapFD> TapFD::open_queues(const string &devname, const size_t count) {
+    return open_device_queues<TapFD>(devname, count);
+}
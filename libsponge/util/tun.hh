@@ -3,27 +3,45 @@
 
 #include "file_descriptor.hh"
 
+#include <cstddef>
 #include <string>
+#include <utility>
+#include <vector>
 
 //! A FileDescriptor to a [Linux TUN/TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunTapFD : public FileDescriptor {
   public:
-    //! Open an existing persistent [TUN or TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunTapFD(const std::string &devname, const bool is_tun);
+    //! Open an existing persistent [TUN or TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt),
+    //! or one queue of it if it is a multiqueue device.
+    explicit TunTapFD(const std::string &devname, const bool is_tun, const bool multi_queue = false);
+
+    //! Use an fd that, like a device, reads and writes one packet at a time (e.g., one end of a datagram socketpair)
+    explicit TunTapFD(FileDescriptor &&fd) : FileDescriptor(std::move(fd)) {}
 };
 
 //! A FileDescriptor to a [Linux TUN](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunFD : public TunTapFD {
   public:
     //! Open an existing persistent [TUN device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunFD(const std::string &devname) : TunTapFD(devname, true) {}
+    explicit TunFD(const std::string &devname, const bool multi_queue = false)
+        : TunTapFD(devname, true, multi_queue) {}
+
+    //! Stand in for a TUN device with an fd that reads and writes one IP datagram at a time
+    explicit TunFD(FileDescriptor &&fd) : TunTapFD(std::move(fd)) {}
+
+    //! Open `count` queues of an existing multiqueue TUN device
+    static std::vector<TunFD> open_queues(const std::string &devname, const size_t count);
 };
 
 //! A FileDescriptor to a [Linux TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TapFD : public TunTapFD {
   public:
     //! Open an existing persistent [TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TapFD(const std::string &devname) : TunTapFD(devname, false) {}
+    explicit TapFD(const std::string &devname, const bool multi_queue = false)
+        : TunTapFD(devname, false, multi_queue) {}
+
+    //! Open `count` queues of an existing multiqueue TAP device
+    static std::vector<TapFD> open_queues(const std::string &devname, const size_t count);
 };
 
 #endif  // SPONGE_LIBSPONGE_TUN_HH
@@ -3,11 +3,20 @@
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#define CHECKSUM_HAVE_X86 1
+#include <immintrin.h>
+#else
+#define CHECKSUM_HAVE_X86 0
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -69,6 +78,106 @@ mt19937 get_random_generator() {
     return mt19937(seed);
 }
 
+//! \name Internet checksum kernels
+//! Each kernel sums `len` bytes (`len` even) as native-order 16-bit words and returns an unfolded sum.
+//!@{
+
+//! Fold a sum of 16-bit words into 16 bits with end-around carry
+static uint16_t fold_checksum(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return sum;
+}
+
+//! Convert a folded native-order sum into the network-order sum
+static uint16_t to_network_order(const uint16_t sum) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap16(sum);
+#else
+    return sum;
+#endif
+}
+
+static uint64_t checksum_word64(const uint8_t *data, size_t len) {
+    uint64_t sum = 0;
+    // each 64-bit word adds two 32-bit halves; 2^32 words would be needed to overflow
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        sum += (word & 0xffffffff) + (word >> 32);
+    }
+    for (; len >= 2; data += 2, len -= 2) {
+        uint16_t word;
+        memcpy(&word, data, sizeof(word));
+        sum += word;
+    }
+    return sum;
+}
+
+#if CHECKSUM_HAVE_X86
+//! 32-bit vector lanes take two 16-bit words per step, so they are drained before they can overflow
+static constexpr size_t CHECKSUM_LANE_FLUSH = 16384;
+
+__attribute__((target("sse2"))) static uint64_t checksum_sse2(const uint8_t *data, size_t len) {
+    const __m128i low_words = _mm_set1_epi32(0xffff);
+    uint64_t sum = 0;
+    while (len >= 32) {
+        // two independent accumulators, each taking the low and high word of every 32-bit lane
+        __m128i acc0 = _mm_setzero_si128();
+        __m128i acc1 = _mm_setzero_si128();
+        for (size_t i = 0; i < CHECKSUM_LANE_FLUSH and len >= 32; ++i, data += 32, len -= 32) {
+            const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+            const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16));
+            acc0 = _mm_add_epi32(acc0, _mm_and_si128(v0, low_words));
+            acc1 = _mm_add_epi32(acc1, _mm_and_si128(v1, low_words));
+            acc0 = _mm_add_epi32(acc0, _mm_srli_epi32(v0, 16));
+            acc1 = _mm_add_epi32(acc1, _mm_srli_epi32(v1, 16));
+        }
+        alignas(16) uint32_t lanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc0);
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes + 4), acc1);
+        for (const auto lane : lanes) {
+            sum += lane;
+        }
+    }
+    return sum + checksum_word64(data, len);
+}
+
+__attribute__((target("avx2"))) static uint64_t checksum_avx2(const uint8_t *data, size_t len) {
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t sum = 0;
+    while (len >= 32) {
+        __m256i acc = zero;
+        for (size_t i = 0; i < CHECKSUM_LANE_FLUSH and len >= 32; ++i, data += 32, len -= 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        for (const auto lane : lanes) {
+            sum += lane;
+        }
+    }
+    return sum + checksum_word64(data, len);
+}
+#endif
+
+//! \returns the fastest kernel this CPU supports (checked once)
+static InternetChecksum::Kernel best_checksum_kernel() {
+    static const InternetChecksum::Kernel best = [] {
+        for (const auto kernel : {InternetChecksum::Kernel::AVX2, InternetChecksum::Kernel::SSE2}) {
+            if (InternetChecksum::supported(kernel)) {
+                return kernel;
+            }
+        }
+        return InternetChecksum::Kernel::Word64;
+    }();
+    return best;
+}
+//!@}
+
 //! \note This class returns the checksum in host byte order.
 //!       See https://commandcenter.blogspot.com/2012/04/byte-order-fallacy.html for rationale
 //! \details This class can be used to either check or compute an Internet checksum
@@ -84,16 +193,86 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
-InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+InternetChecksum::InternetChecksum(const uint32_t initial_sum, const Kernel kernel)
+    : _sum(initial_sum), _kernel(kernel == Kernel::Auto ? best_checksum_kernel() : kernel) {
+    if (not supported(_kernel)) {
+        throw runtime_error("InternetChecksum: kernel not supported on this CPU");
+    }
+}
 
+//! \details The data is summed as 16-bit big-endian words. A chunk with an odd number of bytes
+//! leaves its last byte "half-added" (tracked by `_parity`), and the next call to add() picks up
+//! with that byte's partner, so splitting the data across calls never changes the result.
+//!
+//! Apart from the Bytewise reference kernel, the even-length middle of each chunk is summed in
+//! native byte order and byte-swapped afterwards, which gives the same one's-complement sum
+//! ([RFC 1071](\ref rfc::rfc1071), section 2(B)).
 void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+    if (_kernel == Kernel::Bytewise) {
+        for (size_t i = 0; i < data.size(); i++) {
+            uint16_t val = uint8_t(data[i]);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
         }
-        _sum += val;
-        _parity = !_parity;
+        return;
+    }
+
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    size_t len = data.size();
+    if (len == 0) {
+        return;
+    }
+
+    // finish the word begun by the previous chunk
+    if (_parity) {
+        _sum += *bytes;
+        ++bytes;
+        --len;
+        _parity = false;
+    }
+
+    const size_t even_len = len & ~size_t{1};
+    uint64_t native_sum = 0;
+    switch (_kernel) {
+#if CHECKSUM_HAVE_X86
+        case Kernel::AVX2:
+            native_sum = checksum_avx2(bytes, even_len);
+            break;
+        case Kernel::SSE2:
+            native_sum = checksum_sse2(bytes, even_len);
+            break;
+#endif
+        default:
+            native_sum = checksum_word64(bytes, even_len);
+            break;
+    }
+    _sum += to_network_order(fold_checksum(native_sum));
+
+    // start a word that the next chunk will finish
+    if (len != even_len) {
+        _sum += uint16_t(bytes[even_len]) << 8;
+        _parity = true;
+    }
+}
+
+//! \param[in] kernel is the kernel to check
+bool InternetChecksum::supported(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Auto:
+        case Kernel::Bytewise:
+        case Kernel::Word64:
+            return true;
+#if CHECKSUM_HAVE_X86
+        case Kernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
     }
 }
 
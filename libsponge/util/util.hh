@@ -53,14 +53,28 @@ uint64_t timestamp_ms();
 
 //! The internet checksum algorithm
 class InternetChecksum {
+  public:
+    //! Summation kernel used by add()
+    enum class Kernel {
+        Auto,      //!< Fastest kernel supported by this CPU (chosen once, at runtime)
+        Bytewise,  //!< One byte at a time (reference implementation)
+        Word64,    //!< 64-bit words, portable
+        SSE2,      //!< 128-bit vectors (x86 only)
+        AVX2       //!< 256-bit vectors (x86 only)
+    };
+
   private:
     uint32_t _sum;
     bool _parity{};
+    Kernel _kernel;
 
   public:
-    InternetChecksum(const uint32_t initial_sum = 0);
+    InternetChecksum(const uint32_t initial_sum = 0, const Kernel kernel = Kernel::Auto);
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! \returns `true` if `kernel` can run on this CPU
+    static bool supported(const Kernel kernel);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
@@ -31,20 +31,10 @@ WrappingInt32 wrap(uint64_t n, WrappingInt32 isn) {
 //! and the other stream runs from the remote TCPSender to the local TCPReceiver and
 //! has a different ISN.
 uint64_t unwrap(WrappingInt32 n, WrappingInt32 isn, uint64_t checkpoint) {
-    uint64_t checkpoint_global_seqno = isn.raw_value() + checkpoint;
-    uint64_t base_global_seqno = checkpoint_global_seqno & 0xFFFFFFFF00000000ul;
-    uint64_t target_global_seqno = base_global_seqno + n.raw_value();
-    uint64_t upper_bound = checkpoint_global_seqno + (1ul << 31);
-    uint64_t lower_bound = checkpoint_global_seqno - (1ul << 31);
-
-    if (checkpoint_global_seqno < (1ul << 31) + isn.raw_value()) {
-        if (target_global_seqno < isn.raw_value())
-            target_global_seqno += 1ul << 32;
-    } else if (target_global_seqno < lower_bound) {
-        target_global_seqno += 1ul << 32;
-    } else if (target_global_seqno > upper_bound) {
-        target_global_seqno -= 1ul << 32;
+    // the distance from the checkpoint's wrapped value to `n`, taken the short way round
+    const auto offset = static_cast<int32_t>(n.raw_value() - wrap(checkpoint, isn).raw_value());
+    if (offset < 0 && checkpoint < static_cast<uint64_t>(-int64_t{offset})) {
+        return checkpoint + offset + (1ul << 32);  // absolute sequence numbers can't go below zero
     }
-
-    return target_global_seqno - isn.raw_value();
+    return checkpoint + offset;
 }
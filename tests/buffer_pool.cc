@@ -0,0 +1,258 @@
+#include "buffer.hh"
+#include "file_descriptor.hh"
+#include "socket.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! \returns a Buffer from `pool` holding `str`, written through a slab
+static Buffer fill(BufferPool &pool, const string &str) {
+    BufferPool::Slab slab = pool.acquire();
+    memcpy(slab.data(), str.data(), str.size());
+    return slab.buffer(str.size());
+}
+
+int main() {
+    try {
+        // test 1: a slab is reused once its Buffers are gone, but not while one is held
+        {
+            BufferPool pool{64};
+            Buffer first = fill(pool, "first");
+            const char *first_slab = first.str().data();
+            const Buffer second = fill(pool, "second");
+            test_err_if(second.str().data() == first_slab, "test 1 failed: held slab was reused");
+            test_err_if(first.str() != "first" or second.str() != "second", "test 1 failed: wrong contents");
+
+            Buffer slice = first;
+            slice.remove_prefix(2);
+            first = {};
+            const Buffer third = fill(pool, "third");
+            test_err_if(third.str().data() == first_slab, "test 1 failed: slab reused while a slice held it");
+            test_err_if(slice.str() != "rst", "test 1 failed: slice was overwritten");
+
+            slice = {};
+            bool reused = false;
+            vector<Buffer> held{};
+            for (size_t i = 0; i < 2 * BufferPool::SCAN_LIMIT and not reused; i++) {
+                held.push_back(pool.copy("more"));
+                reused = held.back().str().data() == first_slab;
+            }
+            test_err_if(not reused, "test 1 failed: free slab wasn't reused");
+            test_err_if(pool.slab_count() > 2 + 2 * BufferPool::SCAN_LIMIT, "test 1 failed: pool grew too much");
+        }
+
+        // test 2: past its limit, a pool hands out slabs it doesn't keep
+        {
+            BufferPool pool{16, 2};
+            vector<Buffer> held{};
+            for (const string str : {"a", "bb", "ccc", "dddd"}) {
+                held.push_back(pool.copy(str));
+            }
+            test_err_if(pool.slab_count() != 2, "test 2 failed: pool kept too many slabs");
+            test_err_if(held[0].str() != "a" or held[3].str() != "dddd", "test 2 failed: wrong contents");
+
+            bool threw = false;
+            try {
+                pool.copy(string(17, 'x'));
+            } catch (const length_error &) {
+                threw = true;
+            }
+            test_err_if(not threw, "test 2 failed: copied a string bigger than a slab");
+        }
+
+        // test 3: payloads received in a batch stay intact after the next batch is received
+        {
+            UDPSocket sender, receiver;
+            sender.bind({"127.0.0.1", 0});
+            receiver.bind({"127.0.0.1", 0});
+            UDPSocket::RecvBatch batch{2, 1500};
+
+            vector<Buffer> payloads{};
+            for (const string str : {"one", "two", "three", "four", "five", "six"}) {
+                sender.sendto(receiver.local_address(), str);
+            }
+            while (payloads.size() < 6) {
+                receiver.recv_batch(batch);
+                for (size_t i = 0; i < batch.size(); i++) {
+                    payloads.push_back(batch.payload(i));
+                }
+            }
+            test_err_if(payloads[0].str() != "one" or payloads[2].str() != "three" or payloads[5].str() != "six",
+                        "test 3 failed: held payload was overwritten");
+        }
+
+        // test 4: copies of a Buffer share its bytes, and outlive it
+        {
+            Buffer original = Buffer::copy_of("shared bytes");
+            Buffer copy = original;
+            test_err_if(copy.str().data() != original.str().data(), "test 4 failed: copy didn't share storage");
+
+            Buffer moved = move(original);
+            original = {};
+            moved.remove_prefix(7);
+            test_err_if(copy.str() != "shared bytes" or moved.str() != "bytes", "test 4 failed: wrong contents");
+
+            copy = moved;
+            moved = {};
+            test_err_if(copy.str() != "bytes", "test 4 failed: assigned copy lost its bytes");
+            test_err_if(not Buffer::copy_of("").str().empty(), "test 4 failed: empty copy isn't empty");
+        }
+
+        // test 5: lists keep their order past the Buffers they hold inline, and once moved from are empty
+        {
+            BufferList list{};
+            string expected{};
+            for (const string str : {"b", "cc", "ddd", "eeee", "fffff", "gggggg"}) {
+                list.append(BufferList{string{str}});
+                expected += str;
+            }
+            list.remove_prefix(4);
+            test_err_if(list.concatenate() != expected.substr(4), "test 5 failed: wrong list contents");
+
+            BufferViewList views{list};
+            for (const string_view header : {"2", "1"}) {
+                views.prepend(header);
+            }
+            views.remove_prefix(1);
+            string written{};
+            for (const iovec &iov : views.as_iovecs()) {
+                written.append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+            }
+            test_err_if(written != "2" + expected.substr(4), "test 5 failed: wrong iovecs");
+
+            BufferList moved = move(list);
+            test_err_if(list.size() != 0 or not list.buffers().empty(), "test 5 failed: moved-from list isn't empty");
+            test_err_if(moved.concatenate() != expected.substr(4), "test 5 failed: moved list lost its contents");
+
+            // used as a queue, a list on the heap keeps its order as the consumed front is dropped
+            SmallVector<size_t, 2> queue{};
+            size_t next_in = 0, next_out = 0;
+            for (size_t i = 0; i < 1000; i++) {
+                queue.push_back(next_in++);
+                if (i % 7 != 0) {
+                    test_err_if(queue.front() != next_out++, "test 5 failed: queue out of order");
+                    queue.pop_front();
+                }
+            }
+            test_err_if(queue.size() != next_in - next_out, "test 5 failed: wrong queue size");
+            for (size_t i = 0; i < queue.size(); i++) {
+                test_err_if(queue[i] != next_out + i, "test 5 failed: queue lost its contents");
+            }
+        }
+
+        // test 6: packets are read into a small slab, or, if they don't fit, whole into a large one
+        {
+            int fds[2];
+            SystemCall("socketpair", socketpair(AF_UNIX, SOCK_DGRAM, 0, static_cast<int *>(fds)));
+            FileDescriptor sender{fds[0]}, receiver{fds[1]};
+            BufferPool pool{64}, large_pool{256};
+
+            const string small_packet(64, 's');
+            string large_packet(200, 'l');
+            large_packet.front() = 'L';
+            for (const string &packet : {small_packet, large_packet, small_packet}) {
+                sender.write(packet);
+            }
+
+            const Buffer first = receiver.read_into(pool, large_pool);
+            const Buffer second = receiver.read_into(pool, large_pool);
+            const Buffer third = receiver.read_into(pool);
+            test_err_if(first.str() != small_packet or third.str() != small_packet, "test 6 failed: wrong packet");
+            test_err_if(second.str() != large_packet, "test 6 failed: large packet isn't whole");
+            test_err_if(large_pool.slab_count() != 1 or pool.slab_count() != 2, "test 6 failed: wrong slabs used");
+
+            char bytes[4];
+            sender.write("abc");
+            test_err_if(receiver.read_into(static_cast<char *>(bytes), sizeof(bytes)) != 3 or string(bytes, 3) != "abc",
+                        "test 6 failed: wrong bytes read into caller's memory");
+        }
+
+        // test 7: a batch keeps each payload in a slab its size, with any that overflow made whole
+        {
+            UDPSocket sender, receiver;
+            sender.bind({"127.0.0.1", 0});
+            receiver.bind({"127.0.0.1", 0});
+            UDPSocket::RecvBatch batch{4, 1500, 64};
+
+            string large_payload(1000, 'l');
+            large_payload.front() = 'L';
+            const vector<string> sent{"small", large_payload, string(64, 'e'), "tiny"};
+            for (const auto &payload : sent) {
+                sender.sendto(receiver.local_address(), payload);
+            }
+
+            vector<Buffer> payloads{};
+            while (payloads.size() < sent.size()) {
+                receiver.recv_batch(batch);
+                for (size_t i = 0; i < batch.size(); i++) {
+                    payloads.push_back(batch.payload(i));
+                }
+            }
+            for (size_t i = 0; i < sent.size(); i++) {
+                test_err_if(payloads[i].str() != sent[i], "test 7 failed: wrong payload " + to_string(i));
+            }
+
+            // the held small payloads don't keep large slabs alive, so later batches reuse them
+            payloads[1] = {};
+            size_t large_slab_count = 0;
+            for (size_t round = 0; round < 4; round++) {
+                sender.sendto(receiver.local_address(), large_payload);
+                receiver.recv_batch(batch);
+                test_err_if(batch.size() != 1 or batch.payload(0).str() != large_payload,
+                            "test 7 failed: wrong payload after reuse");
+                // the first batch replaces the slab it filled last; from then on, released slabs come back
+                if (round == 0) {
+                    large_slab_count = batch.large_slab_count();
+                }
+                test_err_if(batch.large_slab_count() != large_slab_count or large_slab_count > batch.capacity() + 1,
+                            "test 7 failed: large slab wasn't reused");
+            }
+            test_err_if(payloads[0].str() != "small" or payloads[3].str() != "tiny",
+                        "test 7 failed: held payload was overwritten");
+        }
+
+        // test 8: a lone datagram of the usual size is received into a small slab, a larger one into a large slab
+        {
+            UDPSocket sender, receiver;
+            sender.bind({"127.0.0.1", 0});
+            receiver.bind({"127.0.0.1", 0});
+            UDPSocket::coalesced_datagrams datagrams{{"0", 0}, {}};
+
+            const string large_payload(9000, 'j');
+            vector<Buffer> payloads{};
+            for (const string &payload : {string("small"), large_payload, string("tiny")}) {
+                sender.sendto(receiver.local_address(), payload);
+                receiver.recv_coalesced(datagrams);
+                test_err_if(datagrams.payloads.size() != 1 or datagrams.payloads[0].str() != payload,
+                            "test 8 failed: wrong payload");
+                payloads.push_back(datagrams.payloads[0]);
+            }
+            // the large payload only passed through a small slab, which the next read took
+            test_err_if(datagrams.pool.slab_count() != 2, "test 8 failed: wrong number of small slabs");
+
+            // each read takes a large slab, but only the large payload keeps one
+            test_err_if(datagrams.large_pool.slab_count() != 2, "test 8 failed: wrong number of large slabs");
+            payloads.clear();
+            sender.sendto(receiver.local_address(), large_payload);
+            receiver.recv_coalesced(datagrams);
+            test_err_if(datagrams.payloads[0].str() != large_payload or datagrams.large_pool.slab_count() != 2,
+                        "test 8 failed: large slab wasn't reused");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static const vector<pair<EventLoop::Backend, string>> backends = {{EventLoop::Backend::Poll, "poll"},
+                                                                  {EventLoop::Backend::Epoll, "epoll"}};
+
+//! \returns the read and write ends of a new pipe
+static pair<FileDescriptor, FileDescriptor> make_pipe() {
+    int fds[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(fds)));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+//! \returns whether wait_next_event() threw a std::runtime_error
+static bool wait_throws(EventLoop &loop) {
+    try {
+        loop.wait_next_event(0);
+    } catch (const runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    try {
+        for (const auto &[backend, name] : backends) {
+            // test 1: a rule's callback runs when its fd is ready, and not otherwise
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                string received;
+                loop.add_rule(reader, Direction::In, [&] { received += reader.read(); });
+
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Timeout,
+                            "test 1 failed (" + name + "): wait without data didn't time out");
+                writer.write("hello");
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or received != "hello",
+                            "test 1 failed (" + name + "): callback didn't read");
+            }
+
+            // test 2: an uninterested rule isn't called, and once no rule is interested the loop exits
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                bool interested = false;
+                size_t calls = 0;
+                loop.add_rule(
+                    reader,
+                    Direction::In,
+                    [&] {
+                        reader.read();
+                        calls++;
+                    },
+                    [&] { return interested; });
+
+                writer.write("x");
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit or calls != 0,
+                            "test 2 failed (" + name + "): uninterested rule was polled");
+                interested = true;
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or calls != 1,
+                            "test 2 failed (" + name + "): interested rule wasn't called");
+                interested = false;
+                writer.write("y");
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit or calls != 1,
+                            "test 2 failed (" + name + "): rule was called after losing interest");
+            }
+
+            // test 3: a callback that leaves its fd ready while still interested is a busy wait
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                loop.add_rule(reader, Direction::In, [] {});
+                writer.write("x");
+                test_err_if(not wait_throws(loop), "test 3 failed (" + name + "): busy wait wasn't detected");
+            }
+
+            // test 4: data written before a hangup is read, then the rule is cancelled
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                string received;
+                size_t cancels = 0;
+                loop.add_rule(
+                    reader, Direction::In, [&] { received += reader.read(); }, {}, [&] { cancels++; });
+
+                writer.write("bye");
+                writer.close();
+                for (size_t i = 0; i < 4 and loop.wait_next_event(0) != EventLoop::Result::Exit; i++) {
+                }
+                test_err_if(received != "bye", "test 4 failed (" + name + "): data before hangup wasn't read");
+                test_err_if(cancels != 1, "test 4 failed (" + name + "): rule wasn't cancelled once");
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit,
+                            "test 4 failed (" + name + "): loop didn't exit without rules");
+            }
+
+            // test 5: a hangup with nothing left to read cancels the rule without calling it
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                size_t calls = 0, cancels = 0;
+                loop.add_rule(
+                    reader,
+                    Direction::In,
+                    [&] {
+                        reader.read();
+                        calls++;
+                    },
+                    [] { return true; },
+                    [&] { cancels++; });
+
+                writer.close();
+                loop.wait_next_event(0);
+                test_err_if(calls != 0 or cancels != 1,
+                            "test 5 failed (" + name + "): hangup didn't cancel the rule without calling it");
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit,
+                            "test 5 failed (" + name + "): loop didn't exit after the hangup");
+            }
+
+            // test 6: an error on an fd is reported, even if its rule isn't interested
+            for (const bool interested : {true, false}) {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                loop.add_rule(
+                    writer, Direction::Out, [&] { writer.write("x"); }, [&] { return interested; });
+                loop.add_timer(1000, [] {});  // so that the loop doesn't exit for lack of interest
+
+                reader.close();  // writing to a pipe without a reader is an error
+                test_err_if(not wait_throws(loop),
+                            "test 6 failed (" + name + "): error wasn't reported" +
+                                (interested ? "" : " for uninterested rule"));
+            }
+
+            // test 7: closing an fd cancels its rules, and another fd can reuse its number
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                size_t cancels = 0;
+                loop.add_rule(
+                    reader, Direction::In, [&] { reader.read(); }, [] { return true; }, [&] { cancels++; });
+                const int old_fd_num = reader.fd_num();
+                reader.close();
+                writer.close();
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Exit or cancels != 1,
+                            "test 7 failed (" + name + "): closing the fd didn't cancel its rule");
+
+                auto [new_reader, new_writer] = make_pipe();
+                test_err_if(new_reader.fd_num() != old_fd_num, "test 7 failed: fd number wasn't reused");
+                string received;
+                loop.add_rule(new_reader, Direction::In, [&] { received += new_reader.read(); });
+                new_writer.write("again");
+                test_err_if(loop.wait_next_event(0) != EventLoop::Result::Success or received != "again",
+                            "test 7 failed (" + name + "): rule on reused fd number wasn't called");
+            }
+
+            // test 8: a rule whose fd is closed before the loop first waits is cancelled, not polled
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                size_t cancels = 0;
+                loop.add_rule(
+                    reader, Direction::In, [&] { reader.read(); }, {}, [&] { cancels++; });
+                loop.add_timer(1000, [] {});
+                reader.close();
+                test_err_if(wait_throws(loop) or cancels != 1,
+                            "test 8 failed (" + name + "): rule on fd closed before waiting wasn't cancelled");
+            }
+
+            // test 9: rules added by a callback take part in the next wait
+            {
+                EventLoop loop{backend};
+                auto [reader, writer] = make_pipe();
+                auto [second_reader, second_writer] = make_pipe();
+                string received;
+                loop.add_rule(reader, Direction::In, [&] {
+                    received += reader.read();
+                    loop.add_rule(second_reader, Direction::In, [&] { received += second_reader.read(); });
+                });
+
+                writer.write("a");
+                second_writer.write("b");
+                loop.wait_next_event(0);
+                test_err_if(received != "a", "test 9 failed (" + name + "): wrong callbacks on first wait");
+                loop.wait_next_event(0);
+                test_err_if(received != "ab", "test 9 failed (" + name + "): added rule wasn't called");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include "tcp_config.hh"
+#include "tcp_demultiplexer.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+using State = TCPState::State;
+
+static constexpr uint32_t CLIENT_ADDRESS = 0x0a000001;  // 10.0.0.1
+static constexpr uint32_t SERVER_ADDRESS = 0x0a000002;  // 10.0.0.2
+static constexpr uint16_t SERVER_PORT = 80;
+
+//! Deliver every segment `from` has sent to `to`, which sees each connection from the other end
+static void deliver(TCPDemultiplexer &from, TCPDemultiplexer &to) {
+    while (not from.segments_out().empty()) {
+        auto &[tuple, seg] = from.segments_out().front();
+        to.segment_received(tuple.reversed(), move(seg));
+        from.segments_out().pop();
+    }
+}
+
+//! Deliver segments both ways until neither side has anything more to send
+static void exchange(TCPDemultiplexer &a, TCPDemultiplexer &b) {
+    while (not a.segments_out().empty() or not b.segments_out().empty()) {
+        deliver(a, b);
+        deliver(b, a);
+    }
+}
+
+static TCPFourTuple client_tuple(const uint16_t client_port) {
+    return {CLIENT_ADDRESS, client_port, SERVER_ADDRESS, SERVER_PORT};
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        const size_t backlog = 2;
+
+        TCPDemultiplexer server{cfg};
+        TCPDemultiplexer client{cfg};
+        server.listen(0, SERVER_PORT, backlog);
+
+        // test 1: a third SYN beyond the backlog is dropped until the owner accepts a connection
+        const uint16_t base_port = 1024 + rd() % 60000;
+        vector<uint16_t> ports{};
+        for (uint16_t i = 0; i < backlog + 1; i++) {
+            ports.push_back(base_port + i);
+            client.connect(client_tuple(ports.back()));
+        }
+        exchange(client, server);
+        test_err_if(server.size() != backlog, "test 1 failed: server opened more connections than its backlog");
+        test_err_if(server.accept_queue_size() != backlog, "test 1 failed: connections weren't queued for accept");
+        test_err_if(client.connection(client_tuple(ports.back()))->state() != State::SYN_SENT,
+                    "test 1 failed: the connection beyond the backlog got an answer");
+
+        const optional<TCPFourTuple> first = server.accept();
+        test_err_if(not first.has_value() or not(first.value() == client_tuple(ports[0]).reversed()),
+                    "test 1 failed: accept() didn't return the oldest connection");
+        test_err_if(server.unaccepted() != backlog - 1, "test 1 failed: accept() didn't make room in the backlog");
+
+        // the dropped SYN is retransmitted, and now fits
+        client.tick(cfg.rt_timeout);
+        server.tick(cfg.rt_timeout);
+        exchange(client, server);
+        test_err_if(server.size() != backlog + 1, "test 1 failed: retransmitted SYN wasn't accepted");
+        while (server.accept().has_value()) {
+        }
+        test_err_if(server.unaccepted() != 0, "test 1 failed: connections left in the backlog");
+
+        // test 2: each connection gets its own data
+        for (const auto port : ports) {
+            client.connection(client_tuple(port))->write("hello from " + to_string(port));
+            client.connection_updated(client_tuple(port));
+        }
+        exchange(client, server);
+        for (const auto port : ports) {
+            ByteStream &inbound = server.connection(client_tuple(port).reversed())->inbound_stream();
+            const string expected = "hello from " + to_string(port);
+            test_err_if(inbound.read(inbound.buffer_size()) != expected,
+                        "test 2 failed: data delivered to the wrong connection");
+        }
+
+        // test 3: a segment for no connection is answered with a RST
+        TCPSegment stray;
+        stray.header().ack = true;
+        stray.header().ackno = WrappingInt32(rd());
+        const TCPFourTuple stray_tuple{SERVER_ADDRESS, SERVER_PORT + 1, CLIENT_ADDRESS, base_port};
+        server.segment_received(stray_tuple, stray);
+        test_err_if(server.segments_out().size() != 1, "test 3 failed: no reply to a stray segment");
+        const auto &[rst_tuple, rst] = server.segments_out().front();
+        test_err_if(not(rst_tuple == stray_tuple) or not rst.header().rst or
+                        rst.header().seqno != stray.header().ackno,
+                    "test 3 failed: wrong reply to a stray segment");
+        server.segments_out().pop();
+
+        // test 4: closed connections stay until the owner erases them; erasing an open one resets it
+        const TCPFourTuple closing = client_tuple(ports[0]);
+        client.connection(closing)->end_input_stream();
+        client.connection_updated(closing);
+        server.connection(closing.reversed())->end_input_stream();
+        server.connection_updated(closing.reversed());
+        exchange(client, server);
+        server.tick(10 * cfg.rt_timeout);
+        client.tick(10 * cfg.rt_timeout);
+        test_err_if(server.connection(closing.reversed())->active() or client.connection(closing)->active(),
+                    "test 4 failed: connection didn't close");
+        server.erase(closing.reversed());
+        client.erase(closing);
+
+        const TCPFourTuple aborted = client_tuple(ports[1]);
+        server.erase(aborted.reversed());
+        exchange(client, server);
+        test_err_if(client.connection(aborted)->state() != State::RESET,
+                    "test 4 failed: erasing an open connection didn't reset it");
+        test_err_if(server.size() != backlog - 1, "test 4 failed: erased connections are still there");
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
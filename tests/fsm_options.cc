@@ -0,0 +1,262 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr unsigned NREPS = 8;
+
+//! Reads every segment the harness has sent, checking that each is acceptable to `check`
+//! \returns the number of payload bytes read
+template <typename Check>
+static size_t read_segments(TCPTestHarness &test, const ExpectSegment &expectation, Check &&check) {
+    size_t bytes_read = 0;
+    while (test.can_read()) {
+        const TCPSegment seg = test.expect_seg(expectation, "invalid segment carrying write() data");
+        check(seg);
+        bytes_read += seg.payload().size();
+    }
+    return bytes_read;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: the peer's SYN offers window scaling, timestamps and a small MSS, and we accept all three
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            TCPConfig cfg{};
+            cfg.recv_capacity = 1 << 20;
+            cfg.send_capacity = 1 << 20;
+            cfg.timestamps = true;
+            const uint8_t receive_scale = 5;  // the smallest shift that fits 1 MiB in 16 bits
+            const WrappingInt32 seq_base(rd());
+            const uint32_t peer_ts = rd();
+            const uint16_t peer_mss = 900 + rd() % 100;
+            const uint8_t peer_scale = 1;
+            TCPTestHarness test_1(cfg);
+
+            TCPOptions syn_options{};
+            syn_options.mss = peer_mss;
+            syn_options.window_scale = peer_scale;
+            syn_options.timestamps = TCPTimestamps{peer_ts, 0};
+
+            test_1.execute(Listen{});
+            test_1.execute(
+                SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(1000).with_options(syn_options));
+
+            // the window of a SYN is never scaled, so it is capped at what the field can hold
+            const TCPSegment syn_ack = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1).with_win(UINT16_MAX),
+                "test 1 failed: SYN/ACK invalid");
+            const TCPOptions &reply = syn_ack.header().options;
+            test_err_if(reply.mss != TCPConfig::MAX_PAYLOAD_SIZE, "test 1 failed: SYN/ACK has wrong MSS");
+            test_err_if(reply.window_scale != receive_scale, "test 1 failed: SYN/ACK has wrong window scale");
+            test_err_if(not reply.timestamps.has_value() or reply.timestamps.value().echo != peer_ts,
+                        "test 1 failed: SYN/ACK doesn't echo the peer's timestamp");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            // a scaled window just over 64 KiB (more segments than this would fill up the test harness's socket)
+            const uint16_t swin = 33000 + rd() % 2000;
+            const size_t window = size_t{swin} << peer_scale;
+            TCPOptions ack_options{};
+            ack_options.timestamps = TCPTimestamps{peer_ts + 1, reply.timestamps.value().value};
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(swin)
+                               .with_options(ack_options));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: ACK after acceptable ACK");
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            string d(window + 1000, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            test_1.execute(Write{d}.with_bytes_written(d.size()));
+            test_1.execute(Tick(1));
+
+            const size_t bytes_read = read_segments(
+                test_1,
+                ExpectSegment{}.with_ack(true).with_ackno(seq_base + 1).with_win(cfg.recv_capacity >> receive_scale),
+                [&](const TCPSegment &seg) {
+                    test_err_if(seg.payload().size() > peer_mss, "test 1 failed: segment larger than peer's MSS");
+                    const auto &timestamps = seg.header().options.timestamps;
+                    test_err_if(not timestamps.has_value() or timestamps.value().echo != peer_ts + 1,
+                                "test 1 failed: segment doesn't echo the peer's latest timestamp");
+                });
+            test_err_if(bytes_read != window, "test 1 failed: sender did not fill the scaled window");
+            test_1.execute(ExpectBytesInFlight{window});
+        }
+
+        // test 2: a peer that offers no options gets none back, and an unscaled window
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            TCPConfig cfg{};
+            cfg.recv_capacity = 1 << 20;
+            cfg.send_capacity = 1 << 20;
+            cfg.timestamps = true;
+            const WrappingInt32 seq_base(rd());
+            TCPTestHarness test_2(cfg);
+
+            test_2.execute(Listen{});
+            test_2.send_syn(seq_base);
+
+            const TCPSegment syn_ack = test_2.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1).with_win(UINT16_MAX),
+                "test 2 failed: SYN/ACK invalid");
+            const TCPOptions &reply = syn_ack.header().options;
+            test_err_if(reply.window_scale.has_value() or reply.timestamps.has_value(),
+                        "test 2 failed: SYN/ACK offers options the peer didn't");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_2.send_ack(seq_base + 1, ack_base + 1, UINT16_MAX);
+            test_2.execute(ExpectState{State::ESTABLISHED});
+
+            string d(2 * UINT16_MAX, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            test_2.execute(Write{d}.with_bytes_written(d.size()));
+            test_2.execute(Tick(1));
+
+            const size_t bytes_read = read_segments(
+                test_2,
+                ExpectSegment{}.with_ack(true).with_ackno(seq_base + 1).with_win(UINT16_MAX),
+                [&](const TCPSegment &seg) {
+                    test_err_if(seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE,
+                                "test 2 failed: segment larger than MAX_PAYLOAD_SIZE");
+                    test_err_if(seg.header().options.timestamps.has_value(),
+                                "test 2 failed: timestamps sent without being negotiated");
+                });
+            test_err_if(bytes_read != UINT16_MAX, "test 2 failed: window was scaled without being negotiated");
+        }
+
+        // test 3: we announce the configured MSS, and send the peer's MSS less the room timestamps take
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            TCPConfig cfg{};
+            cfg.mss = 1460;
+            cfg.timestamps = true;
+            const WrappingInt32 seq_base(rd());
+            const uint16_t peer_mss = 1200 + rd() % 1000;
+            const size_t expected_mss = min(size_t{peer_mss}, cfg.mss) - TCPOptions::TIMESTAMPS_LENGTH;
+            TCPTestHarness test_3(cfg);
+
+            TCPOptions syn_options{};
+            syn_options.mss = peer_mss;
+            syn_options.timestamps = TCPTimestamps{static_cast<uint32_t>(rd()), 0};
+
+            test_3.execute(Listen{});
+            test_3.execute(
+                SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(UINT16_MAX).with_options(syn_options));
+
+            const TCPSegment syn_ack = test_3.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1),
+                "test 3 failed: SYN/ACK invalid");
+            test_err_if(syn_ack.header().options.mss != cfg.mss, "test 3 failed: SYN/ACK has wrong MSS");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            test_3.send_ack(seq_base + 1, ack_base + 1, UINT16_MAX);
+            test_3.execute(ExpectState{State::ESTABLISHED});
+
+            string d(4 * cfg.mss, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            test_3.execute(Write{d}.with_bytes_written(d.size()));
+            test_3.execute(Tick(1));
+
+            size_t largest = 0;
+            const size_t bytes_read = read_segments(
+                test_3, ExpectSegment{}.with_ack(true).with_max_payload_size(cfg.mss), [&](const TCPSegment &seg) {
+                    largest = max(largest, seg.payload().size());
+                });
+            test_err_if(bytes_read != d.size(), "test 3 failed: not all data was sent");
+            test_err_if(largest != expected_mss, "test 3 failed: segments not sized to the negotiated MSS");
+        }
+
+        // test 4: with SACK, segments leave room for the SACK blocks too, so none is bigger on the wire than the MSS
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            TCPConfig cfg{};
+            cfg.mss = 1460;
+            cfg.sack = true;
+            cfg.timestamps = true;
+            const WrappingInt32 seq_base(rd());
+            const uint32_t peer_ts = rd();
+            const uint16_t peer_mss = 1200 + rd() % 200;
+            TCPTestHarness test_4(cfg);
+
+            TCPOptions syn_options{};
+            syn_options.mss = peer_mss;
+            syn_options.sack_permitted = true;
+            syn_options.timestamps = TCPTimestamps{peer_ts, 0};
+
+            test_4.execute(Listen{});
+            test_4.execute(
+                SendSegment{}.with_syn(true).with_seqno(seq_base).with_win(UINT16_MAX).with_options(syn_options));
+
+            const TCPSegment syn_ack = test_4.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(seq_base + 1),
+                "test 4 failed: SYN/ACK invalid");
+            test_err_if(not syn_ack.header().options.sack_permitted, "test 4 failed: SYN/ACK doesn't permit SACK");
+            const WrappingInt32 ack_base = syn_ack.header().seqno;
+
+            TCPOptions ack_options{};
+            ack_options.timestamps = TCPTimestamps{peer_ts + 1, syn_ack.header().options.timestamps.value().value};
+            test_4.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(seq_base + 1)
+                               .with_ackno(ack_base + 1)
+                               .with_win(UINT16_MAX)
+                               .with_options(ack_options));
+            test_4.execute(ExpectState{State::ESTABLISHED});
+
+            // three out-of-order pieces from the peer leave three holes, so each of our segments has three SACK blocks
+            for (const uint32_t offset : {100, 200, 300}) {
+                test_4.execute(SendSegment{}
+                                   .with_ack(true)
+                                   .with_seqno(seq_base + 1 + offset)
+                                   .with_ackno(ack_base + 1)
+                                   .with_win(UINT16_MAX)
+                                   .with_data(string(10, 'x'))
+                                   .with_options(ack_options));
+                test_4.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(seq_base + 1),
+                                  "test 4 failed: out-of-order data wasn't acknowledged");
+            }
+
+            string d(4 * cfg.mss, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            test_4.execute(Write{d}.with_bytes_written(d.size()));
+            test_4.execute(Tick(1));
+
+            size_t largest = 0;
+            const size_t bytes_read = read_segments(
+                test_4,
+                ExpectSegment{}.with_ack(true).with_ackno(seq_base + 1).with_max_payload_size(cfg.mss),
+                [&](const TCPSegment &seg) {
+                    const TCPHeader &header = seg.header();
+                    test_err_if(header.options.sack_blocks.size() != 3, "test 4 failed: segment lacks SACK blocks");
+                    const size_t options_length = header.doff * 4 - TCPHeader::LENGTH;
+                    test_err_if(seg.payload().size() + options_length > peer_mss,
+                                "test 4 failed: segment and its options are larger than the peer's MSS");
+                    largest = max(largest, seg.payload().size());
+                });
+            test_err_if(bytes_read != d.size(), "test 4 failed: not all data was sent");
+            test_err_if(largest != peer_mss - TCPOptions::MAX_LENGTH,
+                        "test 4 failed: segments not sized to the MSS less the largest options");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
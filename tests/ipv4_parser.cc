@@ -1,3 +1,4 @@
+#include "ethernet_header.hh"
 #include "ipv4_datagram.hh"
 #include "ipv4_header.hh"
 #include "tcp_header.hh"
@@ -25,6 +26,34 @@ uint16_t inet_cksum(const uint8_t *data, const size_t len) {
     return check.value();
 }
 
+//! \returns `true` if header views over the frame read the same fields as the parsed headers
+static bool views_match(const uint8_t *frame, const size_t len, const IPv4Header &ip_hdr, const TCPSegment &tcp_seg) {
+    const EthernetHeaderView eth_view{string(frame, frame + len)};
+    if (not eth_view.valid() or eth_view.type() != EthernetHeader::TYPE_IPv4 or
+        not equal(frame, frame + 6, eth_view.dst().begin()) or
+        not equal(frame + 6, frame + 12, eth_view.src().begin())) {
+        return false;
+    }
+
+    const IPv4HeaderView ip_view{eth_view.payload()};
+    if (not ip_view.valid() or ip_view.ver() != ip_hdr.ver or ip_view.hlen() != ip_hdr.hlen or
+        ip_view.tos() != ip_hdr.tos or ip_view.len() != ip_hdr.len or ip_view.id() != ip_hdr.id or
+        ip_view.df() != ip_hdr.df or ip_view.mf() != ip_hdr.mf or ip_view.offset() != ip_hdr.offset or
+        ip_view.ttl() != ip_hdr.ttl or ip_view.proto() != ip_hdr.proto or ip_view.cksum() != ip_hdr.cksum or
+        ip_view.src() != ip_hdr.src or ip_view.dst() != ip_hdr.dst) {
+        return false;
+    }
+
+    const TCPHeader &tcp_hdr = tcp_seg.header();
+    const TCPHeaderView tcp_view{ip_view.payload()};
+    return tcp_view.valid() and tcp_view.sport() == tcp_hdr.sport and tcp_view.dport() == tcp_hdr.dport and
+           tcp_view.seqno() == tcp_hdr.seqno and tcp_view.ackno() == tcp_hdr.ackno and
+           tcp_view.doff() == tcp_hdr.doff and tcp_view.urg() == tcp_hdr.urg and tcp_view.ack() == tcp_hdr.ack and
+           tcp_view.psh() == tcp_hdr.psh and tcp_view.rst() == tcp_hdr.rst and tcp_view.syn() == tcp_hdr.syn and
+           tcp_view.fin() == tcp_hdr.fin and tcp_view.win() == tcp_hdr.win and tcp_view.cksum() == tcp_hdr.cksum and
+           tcp_view.uptr() == tcp_hdr.uptr and tcp_view.payload().str() == tcp_seg.payload().str();
+}
+
 int main(int argc, char **argv) {
     try {
         // first, make sure the parser gets the correct values and catches errors
@@ -81,6 +110,24 @@ int main(int argc, char **argv) {
                 throw runtime_error("Parse error: dst addr is wrong");
             }
 
+            // forwarding a parsed datagram changes only its TTL and checksum, and leaves the checksum valid
+            {
+                const string original(test_header.begin(), test_header.end());
+                IPv4Datagram dgram;
+                if (auto ret = dgram.parse(string(original)); ret != ParseResult::NoError) {
+                    throw runtime_error("Parse error: " + as_string(ret));
+                }
+                dgram.decrement_ttl();
+                const string forwarded = dgram.serialize().concatenate();
+                if (forwarded.size() != original.size() or uint8_t(forwarded[8]) != uint8_t(original[8] - 1) or
+                    forwarded.substr(12) != original.substr(12) or forwarded.substr(0, 8) != original.substr(0, 8)) {
+                    throw runtime_error("decrement_ttl error: changed more than the TTL and checksum");
+                }
+                if (inet_cksum(reinterpret_cast<const uint8_t *>(forwarded.data()), 20) != 0) {
+                    throw runtime_error("decrement_ttl error: checksum is wrong");
+                }
+            }
+
             test_header[0] = 0x55;
             {
                 const uint16_t new_cksum = inet_cksum(test_header.data(), 20);
@@ -212,6 +259,14 @@ int main(int argc, char **argv) {
                 continue;
             }
 
+            if (!views_match(pkt, hdr.caplen, ip_dgram.header(), tcp_seg)) {
+                cout << "ERROR: header views don't match the parsed headers.\n";
+                show_ethernet_frame(pkt, hdr);
+                hexdump(pkt + 14, hdr.caplen - 14);
+                ok = false;
+                continue;
+            }
+
             // parse succeeded. Create a new packet and rebuild the header by unparsing.
             cout << dec;
 
@@ -250,6 +305,17 @@ int main(int argc, char **argv) {
             concat.append(ip_dgram_copy.header().serialize());
             concat.append(tcp_seg_copy.serialize(ip_dgram_copy.header().pseudo_cksum()).concatenate());
 
+            // serializing the same headers into a Headroom must give the same bytes
+            Headroom headroom;
+            tcp_seg_copy.serialize(headroom, ip_dgram_copy.header().pseudo_cksum());
+            ip_dgram_copy.header().serialize(headroom);
+            if (string(headroom.str()) + tcp_seg_copy.payload().copy() != concat) {
+                cout << "ERROR: headers serialized into a Headroom don't match their serialization as strings.\n";
+                hexdump(headroom.str().data(), headroom.size());
+                ok = false;
+                continue;
+            }
+
             if (auto res = ip_dgram_copy2.parse(string(concat)); res != ParseResult::NoError) {
                 auto ip_parse_result = as_string(res);
                 cout << "ERROR got IP parse failure " << ip_parse_result << " for this datagram (copy2):\n";
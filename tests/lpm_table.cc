@@ -0,0 +1,102 @@
+#include "lpm_table.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const vector<pair<LPMAlgorithm, string>> algorithms = {
+    {LPMAlgorithm::Linear, "linear"}, {LPMAlgorithm::Trie, "trie"}, {LPMAlgorithm::Dir24_8, "DIR-24-8"}};
+
+static uint32_t ip(const uint8_t a, const uint8_t b, const uint8_t c, const uint8_t d) {
+    return (uint32_t{a} << 24) | (uint32_t{b} << 16) | (uint32_t{c} << 8) | d;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: a small table, with prefixes added shortest and longest first
+        for (const auto &[algorithm, name] : algorithms) {
+            const auto table = LPMTable::make(algorithm);
+            test_err_if(table->lookup(ip(1, 2, 3, 4)).has_value(), "test 1 failed (" + name + "): empty table matched");
+
+            table->insert(ip(10, 0, 0, 0), 8, 1);
+            table->insert(ip(10, 1, 2, 3), 32, 4);
+            table->insert(ip(10, 1, 2, 128), 25, 3);
+            table->insert(ip(10, 1, 0, 0), 16, 2);
+            table->insert(ip(10, 1, 2, 99), 24, 5);  // bits beyond the length are ignored
+            table->insert(0, 0, 0);
+
+            const vector<pair<uint32_t, size_t>> expected = {{ip(1, 2, 3, 4), 0},
+                                                             {ip(10, 200, 0, 1), 1},
+                                                             {ip(10, 1, 200, 1), 2},
+                                                             {ip(10, 1, 2, 200), 3},
+                                                             {ip(10, 1, 2, 3), 4},
+                                                             {ip(10, 1, 2, 4), 5},
+                                                             {ip(10, 1, 3, 4), 2}};
+            for (const auto &[address, value] : expected) {
+                test_err_if(table->lookup(address) != value, "test 1 failed (" + name + "): wrong match");
+            }
+
+            table->insert(ip(10, 1, 0, 0), 16, 6);  // replaces the earlier value
+            test_err_if(table->lookup(ip(10, 1, 200, 1)) != size_t{6},
+                        "test 1 failed (" + name + "): prefix wasn't replaced");
+        }
+
+        // test 2: random tables agree with the linear scan
+        for (unsigned rep_no = 0; rep_no < 4; rep_no++) {
+            vector<unique_ptr<LPMTable>> tables{};
+            for (const auto &algorithm : algorithms) {
+                tables.push_back(LPMTable::make(algorithm.first));
+            }
+
+            // prefixes clustered under a few /8s, so that many of them overlap (none shorter than /8, each of
+            // which would fill millions of DIR-24-8 entries)
+            vector<uint32_t> bases{};
+            for (unsigned i = 0; i < 4; i++) {
+                bases.push_back(uint32_t(rd()) & 0xff000000);
+            }
+            for (size_t value = 0; value < 1000; value++) {
+                const uint8_t length = 8 + rd() % 25;
+                const uint32_t prefix = bases[rd() % bases.size()] | (uint32_t(rd()) & 0x00ffffff);
+                for (auto &table : tables) {
+                    table->insert(prefix, length, value);
+                }
+            }
+
+            vector<uint32_t> addresses{};
+            vector<optional<size_t>> expected{};
+            for (unsigned i = 0; i < 10000; i++) {
+                addresses.push_back(bases[rd() % bases.size()] | (uint32_t(rd()) & 0x00ffffff));
+                expected.push_back(tables.front()->lookup(addresses.back()));
+                for (size_t t = 1; t < tables.size(); t++) {
+                    test_err_if(tables[t]->lookup(addresses.back()) != expected.back(),
+                                "test 2 failed (" + algorithms[t].second + "): disagrees with linear scan");
+                }
+            }
+
+            // test 3: batched lookups agree with single ones (with a batch that isn't a whole number of lanes)
+            addresses.pop_back();
+            expected.pop_back();
+            for (size_t t = 0; t < tables.size(); t++) {
+                vector<optional<size_t>> results{};
+                tables[t]->lookup_batch(addresses, results);
+                test_err_if(results != expected, "test 3 failed (" + algorithms[t].second + "): wrong batch results");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
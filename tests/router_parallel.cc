@@ -0,0 +1,178 @@
+#include "arp_message.hh"
+#include "router.hh"
+#include "spsc_ring.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static uint32_t ip(const string &str) { return Address{str}.ipv4_numeric(); }
+
+//! Give `router` `interface_count` interfaces, where interface k is 192.168.k.1, with a neighbor at 192.168.k.2
+//! (whose Ethernet address it has learned) that is the next hop to 10.k.0.0/16
+static void add_interfaces(Router &router, const size_t interface_count) {
+    for (size_t k = 0; k < interface_count; k++) {
+        const EthernetAddress address{2, 0, 0, 0, 0, uint8_t(k)};
+        const uint32_t subnet = ip("192.168.0.0") | (k << 8);
+        router.add_interface({address, Address::from_ipv4_numeric(subnet | 1)});
+        router.add_route(ip("10.0.0.0") | (k << 16), 16, Address::from_ipv4_numeric(subnet | 2), k);
+
+        ARPMessage arp;
+        arp.opcode = ARPMessage::OPCODE_REPLY;
+        arp.sender_ethernet_address = {2, 0, 0, 0, 1, uint8_t(k)};
+        arp.sender_ip_address = subnet | 2;
+        arp.target_ethernet_address = address;
+        arp.target_ip_address = subnet | 1;
+        EthernetFrame frame;
+        frame.header() = {address, arp.sender_ethernet_address, EthernetHeader::TYPE_ARP};
+        frame.payload() = arp.serialize();
+        router.interface(k).recv_frame(frame);
+    }
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: a ring keeps its items in order, refuses them when full, and is empty once drained
+        {
+            SPSCRing<int> ring{5};
+            test_err_if(ring.capacity() != 8, "test 1 failed: capacity isn't rounded up to a power of two");
+            test_err_if(ring.try_pop().has_value(), "test 1 failed: new ring isn't empty");
+            for (int round = 0; round < 3; round++) {
+                for (int i = 0; i < 8; i++) {
+                    int item = round * 8 + i;
+                    test_err_if(not ring.try_push(item), "test 1 failed: ring was full too soon");
+                }
+                int extra = -1;
+                test_err_if(ring.try_push(extra) or extra != -1, "test 1 failed: full ring took an item");
+                for (int i = 0; i < 8; i++) {
+                    test_err_if(ring.try_pop() != round * 8 + i, "test 1 failed: wrong item popped");
+                }
+                test_err_if(ring.try_pop().has_value(), "test 1 failed: drained ring isn't empty");
+            }
+        }
+
+        // test 2: items pushed by one thread are popped by another in order, as the indices wrap many times
+        {
+            constexpr size_t item_count = 200000;
+            SPSCRing<size_t> ring{16};
+            thread producer{[&] {
+                for (size_t i = 0; i < item_count; i++) {
+                    size_t item = i;
+                    while (not ring.try_push(item)) {
+                        this_thread::yield();
+                    }
+                }
+            }};
+
+            size_t popped = 0;
+            bool in_order = true;
+            while (popped < item_count) {
+                const optional<size_t> item = ring.try_pop();
+                if (not item.has_value()) {
+                    this_thread::yield();
+                    continue;
+                }
+                in_order = in_order and item.value() == popped;
+                popped++;
+            }
+            producer.join();
+            test_err_if(not in_order, "test 2 failed: items popped out of order");
+            test_err_if(ring.try_pop().has_value(), "test 2 failed: ring isn't empty after every item was popped");
+        }
+
+        // test 3: route_parallel() sends the same datagrams out of the same interfaces as route()
+        {
+            constexpr size_t interface_count = 6;
+            constexpr size_t datagrams_per_interface = 600;  // more than a ring holds
+            Router serial, parallel;
+            add_interfaces(serial, interface_count);
+            add_interfaces(parallel, interface_count);
+
+            // the workers are kept between calls, so route several rounds with each number of workers
+            for (const size_t workers : {2, 3, 3, 4, 6, 6}) {
+                for (size_t k = 0; k < interface_count; k++) {
+                    for (size_t i = 0; i < datagrams_per_interface; i++) {
+                        InternetDatagram dgram;
+                        dgram.header().src = ip("192.168.0.2") | (k << 8);
+                        // some destinations have no route, and some datagrams have no TTL left
+                        dgram.header().dst = ip("10.0.0.0") | ((rd() % (interface_count + 1)) << 16) | (rd() & 0xffff);
+                        dgram.header().ttl = rd() % 16 == 0 ? 1 : 64;
+                        dgram.payload() = to_string(i);
+                        dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+
+                        EthernetFrame frame;
+                        frame.header() = {
+                            {2, 0, 0, 0, 0, uint8_t(k)}, {2, 0, 0, 0, 1, uint8_t(k)}, EthernetHeader::TYPE_IPv4};
+                        frame.payload() = dgram.serialize().concatenate();
+                        serial.interface(k).recv_frame(frame);
+                        parallel.interface(k).recv_frame(frame);
+                    }
+                }
+
+                serial.route();
+#if defined(SPONGE_NONATOMIC_BUFFER_REFCOUNT)
+                // the workers would share Buffers whose references aren't counted atomically
+                bool refused = false;
+                try {
+                    parallel.route_parallel(workers);
+                } catch (const runtime_error &) {
+                    refused = true;
+                }
+                test_err_if(not refused, "test 3 failed: route_parallel() ran without atomic Buffer references");
+                parallel.route();
+#else
+                parallel.route_parallel(workers);
+#endif
+
+                const string with = " with " + to_string(workers) + " workers";
+                for (size_t k = 0; k < interface_count; k++) {
+                    test_err_if(not parallel.interface(k).datagrams_out().empty(),
+                                "test 3 failed" + with + ": datagram left unrouted");
+
+                    vector<string> expected{}, sent{};
+                    vector<optional<size_t>> last_from(interface_count);
+                    for (auto &frames = serial.interface(k).frames_out(); not frames.empty(); frames.pop()) {
+                        expected.push_back(frames.front().serialize().concatenate());
+                    }
+                    for (auto &frames = parallel.interface(k).frames_out(); not frames.empty(); frames.pop()) {
+                        sent.push_back(frames.front().serialize().concatenate());
+
+                        // datagrams from one interface to another keep their order
+                        InternetDatagram dgram;
+                        test_err_if(dgram.parse(frames.front().payload().concatenate()) != ParseResult::NoError,
+                                    "test 3 failed" + with + ": bad datagram sent");
+                        const size_t from = (dgram.header().src >> 8) & 0xff;
+                        const size_t i = stoul(dgram.payload().concatenate());
+                        test_err_if(last_from.at(from).has_value() and last_from.at(from).value() >= i,
+                                    "test 3 failed" + with + ": datagrams reordered");
+                        last_from.at(from) = i;
+                    }
+
+                    // route() goes through the interfaces in turn, so only the interleaving may differ
+                    sort(expected.begin(), expected.end());
+                    sort(sent.begin(), sent.end());
+                    test_err_if(expected.empty(), "test 3 failed" + with + ": nothing was routed");
+                    test_err_if(sent != expected, "test 3 failed" + with + ": different datagrams sent");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+        const size_t initial_window = NewRenoController::INITIAL_WINDOW_SEGMENTS * mss;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            cfg.congestion_control = CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"Third duplicate ack retransmits at once, then fast recovery", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectCongestionWindow{initial_window + 1});
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes("def"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+            test.execute(WriteBytes("ghi"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("ghi").with_seqno(isn + 7));
+            test.execute(WriteBytes("jkl"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("jkl").with_seqno(isn + 10));
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectCongestionWindow{initial_window + 4});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            // ssthresh = max(FlightSize / 2, 2 * MSS), and cwnd is inflated by three segments
+            test.execute(ExpectCongestionWindow{5 * mss});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{6 * mss});
+            // the retransmission timer was not restarted by the fast retransmit
+            test.execute(Tick{rto - 1});
+            test.execute(ExpectNoSegment{});
+            // partial ack: the next hole is resent immediately and cwnd deflates by the bytes acked
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("ghi").with_seqno(isn + 7));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{6 * mss - 3});
+            // full ack ends recovery with cwnd = ssthresh
+            test.execute(AckReceived{WrappingInt32{isn + 13}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectCongestionWindow{2 * mss});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+
+            TCPSenderTestHarness test{"Without congestion control, only the timer retransmits", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes("def"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+            for (unsigned i = 0; i < TCPConfig::DUP_ACK_THRESHOLD + 1; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{rto - 1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            cfg.congestion_control = CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"Window updates are not duplicate acks", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1001));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1002));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1003));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            cfg.congestion_control = CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"After a timeout, old duplicates don't start fast recovery", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes("def"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+            test.execute(Tick{rto});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{mss});
+            for (unsigned i = 0; i < TCPConfig::DUP_ACK_THRESHOLD; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectCongestionWindow{mss});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            cfg.congestion_control = CongestionControl::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC fast retransmit", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes("abc"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(WriteBytes("def"));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+            for (unsigned i = 0; i < TCPConfig::DUP_ACK_THRESHOLD - 1; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            const size_t rto = uniform_int_distribution<uint16_t>{30, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = rto;
+            cfg.congestion_control = CongestionControl::NewReno;
+
+            TCPSenderTestHarness test{"SACK: only holes with enough SACKed data above them are resent", cfg};
+
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            const string data = "abcdefghijklmnopqrstuvwx";
+            for (size_t i = 0; i < data.size(); i += 3) {
+                test.execute(WriteBytes(data.substr(i, 3)));
+                test.execute(ExpectSegment{}.with_payload_size(3).with_data(data.substr(i, 3)).with_seqno(isn + 1 + i));
+            }
+            // "abc" and "jkl" are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 4, isn + 10));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 13, isn + 16).with_sack(
+                isn + 4, isn + 10));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 13, isn + 19).with_sack(
+                isn + 4, isn + 10));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            // only two segments have been SACKed above "jkl", which could still just be reordered
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(isn + 13, isn + 22).with_sack(
+                isn + 4, isn + 10));
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("jkl").with_seqno(isn + 10));
+            test.execute(ExpectNoSegment{});
+            // the partial ack doesn't resend "jkl" a second time
+            test.execute(AckReceived{WrappingInt32{isn + 10}}.with_win(1000).with_sack(isn + 13, isn + 22));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 25}}.with_win(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
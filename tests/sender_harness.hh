@@ -15,6 +15,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +100,22 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectCongestionWindow : public SenderExpectation {
+    size_t _n_bytes;
+
+    ExpectCongestionWindow(size_t n_bytes) : _n_bytes(n_bytes) {}
+    std::string description() const { return "congestion window of " + std::to_string(_n_bytes) + " bytes"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.congestion_window() != _n_bytes) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << sender.congestion_window()
+               << " bytes, but it was expected to be " << _n_bytes << " bytes";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,6 +208,7 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<TCPSACKBlock> _sack_blocks{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
@@ -204,8 +222,13 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack_blocks.push_back({left, right});
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), false, _sack_blocks);
         sender.fill_window();
     }
 };
@@ -394,7 +417,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -123,6 +123,7 @@ struct ExpectSegment : public TCPExpectation {
     std::optional<uint16_t> win{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
+    size_t max_payload_size = TCPConfig::MAX_PAYLOAD_SIZE;
 
     ExpectSegment &with_ack(bool ack_) {
         ack = ack_;
@@ -181,6 +182,11 @@ struct ExpectSegment : public TCPExpectation {
         return *this;
     }
 
+    ExpectSegment &with_max_payload_size(size_t max_payload_size_) {
+        max_payload_size = max_payload_size_;
+        return *this;
+    }
+
     std::string segment_description() const {
         std::ostringstream o;
         o << "(";
@@ -252,7 +258,7 @@ struct ExpectSegment : public TCPExpectation {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
         }
-        if (seg.length_in_sequence_space() > TCPConfig::MAX_PAYLOAD_SIZE) {
+        if (seg.length_in_sequence_space() > max_payload_size) {
             throw SegmentExpectationViolation("packet has length_including_flags (" +
                                               std::to_string(seg.length_in_sequence_space()) +
                                               ") greater than the maximum");
@@ -392,6 +398,7 @@ struct SendSegment : public TCPAction {
     uint16_t win{0};
     size_t payload_size{0};
     std::string data{};
+    TCPOptions options{};
 
     SendSegment() {}
 
@@ -404,6 +411,7 @@ struct SendSegment : public TCPAction {
         ackno = seg.header().ackno;
         win = seg.header().win;
         data = seg.payload();
+        options = seg.header().options;
     }
 
     SendSegment &with_ack(bool ack_) {
@@ -455,6 +463,11 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_options(const TCPOptions &options_) {
+        options = options_;
+        return *this;
+    }
+
     TCPSegment get_segment() const {
         TCPSegment data_seg;
         data_seg.payload() = std::string(data);
@@ -466,6 +479,8 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.options = options;
+        data_hdr.doff = (TCPHeader::LENGTH + data_hdr.options_length()) / 4;
         return data_seg;
     }
 
@@ -118,6 +118,62 @@ int main(int argc, char **argv) {
             }
         }
 
+        // next, make sure that options survive a round trip, and that only what fits in doff is written
+        for (unsigned i = 0; i < NREPS; ++i) {
+            TCPHeader test_2{};
+            test_2.syn = rd() % 2;
+            test_2.win = rd();
+            if (rd() % 2) {
+                test_2.options.mss = rd();
+            }
+            if (rd() % 2) {
+                test_2.options.window_scale = rd() % (TCPOptions::MAX_WINDOW_SCALE + 1);
+            }
+            test_2.options.sack_permitted = rd() % 2;
+            if (rd() % 2) {
+                test_2.options.timestamps = TCPTimestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+            }
+            const size_t n_blocks = rd() % (TCPOptions::MAX_SACK_BLOCKS + 1);
+            for (size_t j = 0; j < n_blocks; ++j) {
+                test_2.options.sack_blocks.push_back({WrappingInt32(rd()), WrappingInt32(rd())});
+            }
+            test_2.doff = (TCPHeader::LENGTH + test_2.options_length()) / 4;
+            if (test_2.doff * 4 > TCPHeader::MAX_LENGTH) {
+                throw runtime_error("options don't fit in the TCP header");
+            }
+
+            TCPHeader test_3{};
+            {
+                NetParser p{test_2.serialize()};
+                if (const auto res = test_3.parse(p); res != ParseResult::NoError) {
+                    throw runtime_error("header with options parse failed: " + as_string(res));
+                }
+            }
+            // SACK blocks are cut to fit in the room left by the other options
+            TCPOptions without_blocks = test_2.options;
+            without_blocks.sack_blocks.clear();
+            const size_t room = TCPOptions::MAX_LENGTH - without_blocks.length();
+            const size_t blocks_sent = room < 12 ? 0 : min(n_blocks, (room - 4) / 8);
+            test_2.options.sack_blocks.resize(blocks_sent);
+            if (not compare_tcp_headers(test_2, test_3) or not(test_2.options == test_3.options)) {
+                throw runtime_error("bad parse: options don't round-trip: " + test_2.to_string() + " vs\n" +
+                                    test_3.to_string());
+            }
+
+            // without room, nothing is written and nothing is parsed
+            test_3.doff = 5;
+            TCPHeader test_4{};
+            {
+                NetParser p{test_3.serialize()};
+                if (const auto res = test_4.parse(p); res != ParseResult::NoError) {
+                    throw runtime_error("header parse failed: " + as_string(res));
+                }
+            }
+            if (not(test_4.options == TCPOptions{})) {
+                throw runtime_error("bad parse: options written beyond doff");
+            }
+        }
+
         // now process some segments off the wire for correctness of parser and unparser
         if (argc < 2) {
             cout << "USAGE: " << argv[0] << " <filename>" << endl;
@@ -230,6 +286,18 @@ int main(int argc, char **argv) {
                 ok = false;
                 continue;
             }
+
+            // the options off the wire should survive a round trip when there is room for them
+            TCPSegment tcp_seg_copy3;
+            tcp_seg_copy3.header() = tcp_seg.header();
+            tcp_seg_copy3.header().doff = (TCPHeader::LENGTH + tcp_seg.header().options_length()) / 4;
+            TCPSegment tcp_seg_copy4;
+            if (const auto res = tcp_seg_copy4.parse(tcp_seg_copy3.serialize().concatenate());
+                res != ParseResult::NoError or not(tcp_seg.header().options == tcp_seg_copy4.header().options)) {
+                cout << "ERROR: after re-parsing, TCP options don't match.\n";
+                ok = false;
+                continue;
+            }
         }
 
         pcap_close(pcap);
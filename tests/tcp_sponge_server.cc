@@ -0,0 +1,100 @@
+#include "tcp_sponge_socket.hh"
+#include "test_err_if.hh"
+#include "tun.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! \returns the two ends of a datagram socketpair, each standing in for a queue of a TUN device
+static pair<TunFD, TunFD> tun_pair() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, static_cast<int *>(fds)));
+    return {TunFD(FileDescriptor(fds[0])), TunFD(FileDescriptor(fds[1]))};
+}
+
+int main() {
+    try {
+        // test 1: a server with two workers accepts the connections that arrive on either of them, and
+        // accept() fails once the workers have stopped
+        {
+            constexpr size_t worker_count = 2;
+            const Address server_address{"169.254.144.9", 9090};
+
+            vector<TCPOverIPv4OverTunFdAdapter> queues{}, client_links{};
+            for (size_t i = 0; i < worker_count; i++) {
+                auto [queue, client_link] = tun_pair();
+                queues.emplace_back(move(queue));
+                client_links.emplace_back(move(client_link));
+            }
+
+            TCPOverIPv4SpongeServer server{move(queues)};
+            test_err_if(server.queue_count() != worker_count, "test 1 failed: wrong number of queues");
+            FdAdapterConfig server_config;
+            server_config.source = server_address;
+            server.listen({}, server_config, 4);
+
+            // one client behind each worker's queue
+            vector<unique_ptr<TCPOverIPv4SpongeSocket>> clients{};
+            vector<string> client_addresses{};
+            for (size_t i = 0; i < worker_count; i++) {
+                FdAdapterConfig client_config;
+                client_config.source = {"169.254.144.1", uint16_t(50000 + i)};
+                client_config.destination = server_address;
+                client_addresses.push_back(client_config.source.to_string());
+
+                clients.push_back(make_unique<TCPOverIPv4SpongeSocket>(move(client_links.at(i))));
+                clients.back()->connect({}, client_config);
+                clients.back()->write("hello from " + client_addresses.back());
+            }
+
+            vector<string> accepted_addresses{};
+            for (size_t i = 0; i < worker_count; i++) {
+                auto [stream, peer] = server.accept();
+                accepted_addresses.push_back(peer.to_string());
+                test_err_if(stream.read() != "hello from " + peer.to_string(),
+                            "test 1 failed: wrong data on accepted connection");
+            }
+            sort(client_addresses.begin(), client_addresses.end());
+            sort(accepted_addresses.begin(), accepted_addresses.end());
+            test_err_if(accepted_addresses != client_addresses, "test 1 failed: didn't accept from both workers");
+
+            // an accept() waiting when the workers stop returns (by throwing) once the last of them has
+            bool accept_failed = false;
+            thread acceptor{[&] {
+                try {
+                    server.accept();
+                } catch (const runtime_error &) {
+                    accept_failed = true;
+                }
+            }};
+            server.stop();
+            acceptor.join();
+            test_err_if(not accept_failed, "test 1 failed: accept() didn't fail after stop()");
+
+            bool late_accept_failed = false;
+            try {
+                server.accept();
+            } catch (const runtime_error &) {
+                late_accept_failed = true;
+            }
+            test_err_if(not late_accept_failed, "test 1 failed: accept() after stop() didn't fail");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#include "test_err_if.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: timers fire once, in deadline order, no earlier than their deadline
+        {
+            TimerWheel wheel{1000};
+            vector<pair<uint64_t, uint64_t>> fired{};  // (deadline, time fired)
+            for (const uint64_t delay : {0, 5, 1, 64, 63, 4096, 4095, 300000, 1}) {
+                const uint64_t deadline = wheel.now() + delay;
+                wheel.add(deadline, [&, deadline] { fired.emplace_back(deadline, wheel.now()); });
+            }
+            test_err_if(wheel.size() != 9, "test 1 failed: wrong number of pending timers");
+            test_err_if(wheel.next_deadline() != 1001u, "test 1 failed: wrong next deadline");
+
+            wheel.advance(1000 + 4095);
+            test_err_if(fired.size() != 7, "test 1 failed: wrong number of timers fired");
+            for (size_t i = 0; i < fired.size(); i++) {
+                test_err_if(fired[i].second != max(fired[i].first, uint64_t{1001}),
+                            "test 1 failed: timer fired at the wrong time");
+                test_err_if(i > 0 and fired[i].first < fired[i - 1].first, "test 1 failed: timers out of order");
+            }
+            test_err_if(wheel.next_deadline() != 1000u + 4096, "test 1 failed: wrong next deadline");
+
+            wheel.advance(1000 + 4096 + 200000);
+            test_err_if(fired.size() != 8, "test 1 failed: timer didn't fire after a long interval");
+            wheel.advance(1000 + 300000);
+            test_err_if(fired.size() != 9 or fired.back().second != 1000 + 300000,
+                        "test 1 failed: last timer fired at the wrong time");
+            test_err_if(not wheel.empty() or wheel.next_deadline().has_value(), "test 1 failed: timers left over");
+        }
+
+        // test 2: cancelled timers don't fire, and callbacks can add and cancel timers
+        {
+            TimerWheel wheel{0};
+            unsigned count = 0;
+            const auto doomed = wheel.add(20, [&] { count += 100; });
+            TimerWheel::TimerId chained = 0;
+            wheel.add(10, [&] {
+                count++;
+                test_err_if(not wheel.cancel(doomed), "test 2 failed: couldn't cancel from a callback");
+                chained = wheel.add(wheel.now(), [&] { count += 10; });
+            });
+            const auto cancelled = wheel.add(5, [&] { count += 1000; });
+            test_err_if(not wheel.cancel(cancelled), "test 2 failed: couldn't cancel");
+            test_err_if(wheel.cancel(cancelled), "test 2 failed: cancelled a timer twice");
+
+            wheel.advance(10);
+            test_err_if(count != 1, "test 2 failed: wrong timers fired");
+            test_err_if(wheel.next_deadline() != 11u, "test 2 failed: timer added by a callback fired early");
+            wheel.advance(100);
+            test_err_if(count != 11 or not wheel.empty(), "test 2 failed: wrong timers fired");
+            test_err_if(wheel.cancel(chained), "test 2 failed: cancelled a timer that already fired");
+        }
+
+        // test 3: random timers (some beyond the span of the wheel) agree with a sorted reference
+        for (unsigned rep_no = 0; rep_no < 8; rep_no++) {
+            const uint64_t start = rd() % (uint64_t{1} << 30);
+            TimerWheel wheel{start};
+            multimap<uint64_t, TimerWheel::TimerId> expected{};
+            vector<uint64_t> fired{};  // deadlines, in the order fired
+
+            for (unsigned step = 0; step < 2000; step++) {
+                const unsigned action = rd() % 10;
+                if (action < 5) {
+                    const unsigned magnitude = rd() % 27;  // up to 2^26 ms, four times the wheel's span
+                    const uint64_t deadline = wheel.now() + 1 + rd() % (uint64_t{1} << magnitude);
+                    expected.emplace(deadline, wheel.add(deadline, [&, deadline] { fired.push_back(deadline); }));
+                } else if (action < 7 and not expected.empty()) {
+                    auto victim = expected.begin();
+                    advance(victim, rd() % expected.size());
+                    test_err_if(not wheel.cancel(victim->second), "test 3 failed: couldn't cancel a pending timer");
+                    expected.erase(victim);
+                } else {
+                    const unsigned magnitude = rd() % 26;
+                    const uint64_t now = wheel.now() + rd() % (uint64_t{1} << magnitude);
+                    fired.clear();
+                    wheel.advance(now);
+
+                    const auto last_due = expected.upper_bound(now);
+                    test_err_if(fired.size() != size_t(distance(expected.begin(), last_due)),
+                                "test 3 failed: wrong number of timers fired");
+                    size_t i = 0;
+                    for (auto it = expected.begin(); it != last_due; ++it, ++i) {
+                        test_err_if(fired[i] != it->first, "test 3 failed: timers fired out of order");
+                    }
+                    expected.erase(expected.begin(), last_due);
+                }
+
+                test_err_if(wheel.size() != expected.size(), "test 3 failed: wrong number of pending timers");
+                const optional<uint64_t> next = wheel.next_deadline();
+                test_err_if(next.has_value() == expected.empty(), "test 3 failed: wrong next deadline");
+                test_err_if(next.has_value() and next.value() != expected.begin()->first,
+                            "test 3 failed: wrong next deadline");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
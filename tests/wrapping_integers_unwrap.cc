@@ -35,6 +35,10 @@ int main() {
         // Nearly big unwrap with non-zero ISN
         test_should_be(unwrap(WrappingInt32(UINT32_MAX), WrappingInt32(1ul << 31), 0),
                        static_cast<uint64_t>(UINT32_MAX) >> 1);
+        // Unwrap a byte just before the wrap, once the checkpoint has passed it
+        test_should_be(unwrap(WrappingInt32(UINT32_MAX - 4000), WrappingInt32(UINT32_MAX - 4096), 10000), 96ul);
+        // Unwrap a byte well before the wrap, with a checkpoint within 2^31 of the ISN
+        test_should_be(unwrap(WrappingInt32(UINT32_MAX - 4095), WrappingInt32(UINT32_MAX - 4096), 1ul << 30), 1ul);
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return 1;
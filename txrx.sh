@@ -1,7 +1,7 @@
 #!/bin/bash
 
 show_usage() {
-    echo "Usage: $0 <-i|-u> <-c|-s> <-R|-S|-D> [-n|-o]"
+    echo "Usage: $0 <-i|-u> <-c|-s> <-R|-S|-D> [-n|-o] [-g]"
     echo "       [-t <rtto>] [-d <size>] [-w <size>] [-l <rate>] [-L <rate>]"
     echo
     echo "  Option                                                      Default"
@@ -19,6 +19,7 @@ show_usage() {
     echo
     echo "  -n          In IP mode, use tcp_native rather tcp_ipv4_ref  False"
     echo "  -o          In IP mode, use socat rather than tcp_ipv4_ref  False"
+    echo "  -g          In UDP mode, test with UDP offload (GSO/GRO)    False"
     [ ! -z "$1" ] && { echo; echo ERROR: "$1"; }
     exit 1
 }
@@ -26,8 +27,8 @@ show_usage() {
 get_cmdline_options () {
     # prepare to use getopts
     local OPT= OPTIND=1 OPTARG=
-    CSMODE= RSDMODE= DATASIZE=32 WINSIZE= IUMODE= USE_IPV4= RTTO="-t 12" LOSS_UP= LOSS_DN=
-    while getopts "t:oniucsRSDd:w:p:l:L:" OPT; do
+    CSMODE= RSDMODE= DATASIZE=32 WINSIZE= IUMODE= USE_IPV4= RTTO="-t 12" LOSS_UP= LOSS_DN= OFFLOAD=
+    while getopts "t:oniucsRSDd:w:p:l:L:g" OPT; do
         case "$OPT" in
             i|u)
                 [ ! -z "$IUMODE" ] && show_usage "Only one of -i and -u is allowed."
@@ -58,6 +59,9 @@ get_cmdline_options () {
                 [ ! -z "$USE_IPV4" ] && show_usage "Only one of -n and -o is allowed."
                 USE_IPV4=$OPT
                 ;;
+            g)
+                OFFLOAD="-O"
+                ;;
             t)
                 expand_num "$OPTARG" || show_usage "Bad numeric arg \"$OPTARG\" to -t."
                 RTTO="-t ${NUM_EXPANDED}"
@@ -76,6 +80,9 @@ get_cmdline_options () {
     if [ ! -z "$USE_IPV4" ] && [ "$IUMODE" != "i" ]; then
         show_usage "-n and -o may only be specified in IP mode (-i)."
     fi
+    if [ ! -z "$OFFLOAD" ] && [ "$IUMODE" != "u" ]; then
+        show_usage "-g may only be specified in UDP mode (-u)."
+    fi
     # loss param args depend on whether we're applying to ref or test program (test uplink == loss downlink)
     { [ ! -z "$USE_IPV4" ] && local LD_SWITCH="-Ld" LU_SWITCH="-Lu"; } || local LD_SWITCH="-Lu" LU_SWITCH="-Ld"
     [ ! -z "$LOSS_DN" ] && LOSS_DN="${LD_SWITCH} ${LOSS_DN}"
@@ -186,7 +193,7 @@ if [ "$IUMODE" = "i" ]; then
 else
     # UDP mode
     REF_PROG="./apps/tcp_udp ${RTTO} ${WINSIZE} ${LOSS_UP} ${LOSS_DN}"
-    TEST_PROG="./apps/tcp_udp ${RTTO} ${WINSIZE}"
+    TEST_PROG="./apps/tcp_udp ${RTTO} ${WINSIZE} ${OFFLOAD}"
 fi
 
 TEST_OUT_FILE=$(mktemp)